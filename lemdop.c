@@ -19,6 +19,9 @@
  */
 
 /*========== Includes ==========*/
+#if defined __linux__
+#define _GNU_SOURCE /*** For copy_file_range(). ***/
+#endif
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -33,8 +36,13 @@
 #include <math.h>
 #if defined WIN32 || _WIN32 || WIN64 || _WIN64
 #include <windows.h>
+#include <io.h>
 #undef PlaySound
 #endif
+#if defined __linux__
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
 
 #include <SDL.h>
 #include <SDL_audio.h>
@@ -59,9 +67,26 @@
 #define COPYRIGHT "Copyright (C) 2022 Norbert de Jonge"
 #define TILES 30
 #define ROM_DIR "rom"
-#define BACKUP ROM_DIR SLASH "rom.bak"
+#define BACKUP_PREFIX "rom-"
+#define BACKUP_SUFFIX ".bak"
+#define BACKUPS 5 /*** Default number of backup generations. ***/
+#define MAX_BACKUPS 100
+#define UNDO_SIZE 20000 /*** Default number of changes kept for undo. ***/
+#define MAX_UNDO 1000000
+#define UNDO_BYTES (32 * 1024 * 1024) /*** Records kept for undo, at most. ***/
+#define TILE_RUN 4096 /*** Tiles per CHANGE_TILES change, at most. ***/
+#define MAX_SNAPSHOTS 9
+#define SNAPSHOT_VALUES 6 /*** See arSnapshotValues[]. ***/
+#define COPY_BUFFER 0x100000
+#define TEMP_SUFFIX ".tmp"
+#define CACHE_SUFFIX ".cache"
+#define LAYOUTS_FILE "layouts.txt" /*** In ROM_DIR. ***/
+#define LAYOUT_SUFFIX ".layout" /*** See SaveLayout(). ***/
+#define MAX_LAYOUTS 500
+#define CACHE_MAGIC "LEMDOPC4" /*** Change the digit if the layout changes. ***/
+#define CACHE_HEADER 20 /*** magic (8), ROM CRC, ROM size, payload CRC ***/
+#define MAX_GAP 16 /*** Changed ranges closer than this are written as one. ***/
 #define MAX_PATHFILE 200
-#define MAX_TOWRITE 720
 #define WINDOW_WIDTH 640 + 2 + 50 /*** 692 ***/
 #define WINDOW_HEIGHT 390 + 2 + 75 /*** 467 ***/
 #define MAX_IMG 200
@@ -74,7 +99,6 @@
 #define MAX_TEXT 100
 #define MAX_OPTION 100
 #define MAX_ERROR 200
-#define MAX_INFO 200
 #define BLUE 0
 #define BROWN 1
 
@@ -111,6 +135,8 @@
 #define WIDTH 10
 #define HEIGHT 3
 #define OFFSET_REGION 0x01F0
+#define OFFSET_CHECKSUM 0x018E
+#define CHECKSUM_START 0x0200
 #define BAR_FULL 443
 #define MAX_GUARDS MAX_ROOMS
 #define MAX_DOORS MAX_ROOMS * WIDTH * HEIGHT
@@ -121,7 +147,27 @@
 #define MAX_CHOMPER MAX_ROOMS * WIDTH * HEIGHT
 #define MAX_SPIKE MAX_ROOMS * WIDTH * HEIGHT
 #define MAX_POTION MAX_ROOMS * WIDTH * HEIGHT
-#define MAX_TEMP MAX_ROOMS * WIDTH * HEIGHT
+#define NR_TYPES 0x0C /*** Object values 0x03-0x0A, and 0x0C for guards. ***/
+#define MAX_WORDS 12 /*** Guards. ***/
+#define FIELD_Y 1
+#define FIELD_X 2
+#define GUARD_DIR 3
+#define GUARD_SPRITE 5 /*** Double word. ***/
+#define GUARD_TYPE 7
+#define GUARD_SKILL 8
+#define GUARD_HP 9
+#define DOOR_TYPE 0
+#define GATE_STATE1 0
+#define GATE_STATE2 3
+#define GATE_STATE3 4
+#define BUTTON_GATE1 4
+#define BUTTON_GATE2 5
+#define BUTTON_GATE3 6
+#define BUTTON_HANDLES 7 /*** After the ROM words; see GateHandle(). ***/
+#define POTION_COLOR 0
+#define POTION_EFFECT 4
+#define DELETED_X 0xFFFF /*** FIELD_X of a record removed in a batch. ***/
+#define SHARED 0x8000 /*** In arRecords: more records at that tile. ***/
 
 #define VERIFY_OFFSET1 0x120
 #define VERIFY_OFFSET2 0x150
@@ -169,6 +215,26 @@
 #define ALLOWED_EU_CHOMPERS 54
 #define ALLOWED_EU_SPIKES 138
 #define ALLOWED_EU_POTIONS 59
+#define NR_BUDGETS 10
+#define TOTAL_ROOMS 0x00 /*** For Total(); other totals use object values. ***/
+#define CHANGE_OBJECT 1 /*** The object of a tile; in a CHANGE_TILES run. ***/
+#define CHANGE_GRAPHICS 2 /*** The graphics of a tile; idem. ***/
+#define CHANGE_WORD 3 /*** A word of a record. ***/
+#define CHANGE_INSERT 4 /*** A record was added. ***/
+#define CHANGE_REMOVE 5 /*** A record was removed. ***/
+#define CHANGE_MERGE 6 /*** A batch was merged; see MergeEdits(). ***/
+#define CHANGE_SIZE 7 /*** The level was resized. ***/
+#define CHANGE_INT 8 /*** The environment, the prince, etc. ***/
+#define CHANGE_TILES 9 /*** Tiles of one group; see JournalTile(). ***/
+#define DRAW_IMAGE 1
+#define DRAW_TEXT 2
+#define MAX_DIRTY 16 /*** Regions that EndScene() redraws separately. ***/
+#define ATLAS_SIZE 2048
+#define MAX_ATLASES 8
+#define ATLAS_SPRITE 256 /*** Larger images are not packed. ***/
+#define MAX_SPRITES 2048 /*** More than twice the images; see FindSprite(). ***/
+#define MAX_BATCH 256 /*** Quads per FlushBatch(). ***/
+#define MAX_TEXTS 256 /*** Cached text textures; see TextTexture(). ***/
 
 #ifndef O_BINARY
 #define O_BINARY 0
@@ -216,7 +282,10 @@ int iNoOn;
 int iStartLevel;
 int iCustomHover, iCustomHoverOld;
 int iMednafen;
-char sInfo[MAX_INFO + 2];
+int iBackups;
+unsigned long iBAKCRC;
+int iBAKCRCKnown;
+int iCache;
 
 /*** Set by SetTypeDefaults(), used by LoadLevels() and SaveLevels(). ***/
 int iNrLevels;
@@ -255,9 +324,99 @@ SDL_Color color_blue = {0x00, 0x00, 0xff, 255};
 SDL_Color color_green = {0x00, 0xff, 0x00, 255};
 SDL_Color color_red = {0xff, 0x00, 0x00, 255};
 SDL_Surface *message;
-SDL_Texture *messaget;
 SDL_Rect offset;
 
+/* What ShowImage() draws. For room tiles, the kind and value are used to
+ * show "G:" or "O:" under them. The name is only used in warnings, and is
+ * left out if NDEBUG is defined.
+ */
+#define INFO_IMAGE 0
+#define INFO_GRAPHICS 1
+#define INFO_OBJECT 2
+struct imginfo {
+	int iKind; /*** INFO_... ***/
+	int iTile;
+	int iLabel; /*** Whether the value may be shown. ***/
+#ifndef NDEBUG
+	const char *sName;
+#endif
+};
+#ifndef NDEBUG
+#define IMGINFO(iKind, iTile, iLabel, sName) \
+	(&(struct imginfo){(iKind), (iTile), (iLabel), (sName)})
+#else
+#define IMGINFO(iKind, iTile, iLabel, sName) \
+	(&(struct imginfo){(iKind), (iTile), (iLabel)})
+#endif
+#define PLAIN(sName) IMGINFO (INFO_IMAGE, 0, 0, sName)
+
+/* The retained scene of ShowScreen(). Its draws are recorded, see
+ * BeginScene(), and EndScene() only redraws the regions of imgscene where
+ * they differ from the draws of the previous scene.
+ */
+struct draw {
+	int iKind; /*** DRAW_... ***/
+	SDL_Texture *img;
+	int iSrc; /*** Whether src is used. ***/
+	SDL_Rect src;
+	SDL_Rect dst; /*** Scaled; for text, the measured size. ***/
+	TTF_Font *font;
+	int iBlended; /*** Text: blended instead of shaded. ***/
+	SDL_Color fore, back;
+	char sText[MAX_TEXT + 2];
+	int iMatched; /*** See EndScene(). ***/
+};
+struct draw *arDraws[2];
+int arDrawsNr[2], arDrawsAlloc[2];
+int iDraws; /*** The list of this scene; the other is of the last one. ***/
+int iRecording;
+SDL_Texture *imgscene;
+int iSceneW, iSceneH;
+int iSceneValid, iNoScene;
+SDL_Rect arDirty[MAX_DIRTY + 2];
+int iDirtyNr;
+
+/* Texture atlases. The preloaded images are also packed into a few large
+ * textures, see AddSprite(), so that EndScene() can draw runs of them with
+ * a single call; see Batch().
+ */
+struct sprite {
+	SDL_Texture *img; /*** The image; NULL if this slot is free. ***/
+	int iAtlas;
+	SDL_Rect rect; /*** Where it is in the atlas. ***/
+} arSprites[MAX_SPRITES + 2];
+SDL_Texture *arAtlases[MAX_ATLASES + 2];
+SDL_Surface *atlas; /*** The atlas being filled, or NULL. ***/
+int iAtlases; /*** Including the one being filled. ***/
+int iAtlasSize;
+int iAtlasX, iAtlasY, iShelfH; /*** Where the next image goes. ***/
+int iSprites;
+struct loaded {
+	char sImage[MAX_IMG + 2];
+	SDL_Texture *img;
+	SDL_Texture **imgHolder; /*** Where img is kept. ***/
+	int iFirst; /*** The entry that loaded img; to share it. ***/
+} *arLoaded; /*** Images that were preloaded; see LoadSprite(). ***/
+int iLoadedNr, iLoadedAlloc;
+int iBatchAtlas, iBatchNr;
+SDL_Rect arBatchSrc[MAX_BATCH + 2], arBatchDst[MAX_BATCH + 2];
+
+/* Rendered texts, so that labels that are shown on every redraw are not
+ * rendered and uploaded again each time; see TextTexture().
+ */
+struct text {
+	SDL_Texture *tex; /*** NULL if this slot is free. ***/
+	int iW, iH;
+	Uint32 iUsed; /*** The least recently used text is replaced. ***/
+	Uint32 iHash;
+	TTF_Font *font;
+	int iBlended;
+	SDL_Color fore;
+	SDL_Color back;
+	char sText[MAX_TEXT + 2];
+} arTexts[MAX_TEXTS + 2];
+Uint32 iTextsUsed;
+
 /*** controller ***/
 int iController;
 SDL_GameController *controller;
@@ -286,112 +445,156 @@ int arLevelOffsetGraphics[MAX_LEVELS + 2];
 int arLevelStartingY[MAX_LEVELS + 2];
 int arLevelStartingX[MAX_LEVELS + 2];
 int arLevelType[MAX_LEVELS + 2];
-unsigned char arLevelObjects[MAX_LEVELS + 2]
-	[(MAX_ROOMS * WIDTH) + 2][(MAX_ROOMS * HEIGHT) + 2];
-unsigned char arLevelGraphics[MAX_LEVELS + 2]
-	[(MAX_ROOMS * WIDTH) + 2][(MAX_ROOMS * HEIGHT) + 2];
-
-/*** These are the guards. ***/
-int arNrGuards[MAX_LEVELS + 2];
-int arOffsetGuards[MAX_LEVELS + 2];
-int arGuardYP[MAX_LEVELS + 2][MAX_GUARDS + 2];
-int arGuardY[MAX_LEVELS + 2][MAX_GUARDS + 2];
-int arGuardXP[MAX_LEVELS + 2][MAX_GUARDS + 2];
-int arGuardX[MAX_LEVELS + 2][MAX_GUARDS + 2];
-int arGuardDir[MAX_LEVELS + 2][MAX_GUARDS + 2];
-int arGuardSprite[MAX_LEVELS + 2][MAX_GUARDS + 2];
-int arGuardType[MAX_LEVELS + 2][MAX_GUARDS + 2];
-int arGuardSkill[MAX_LEVELS + 2][MAX_GUARDS + 2];
-int arGuardHP[MAX_LEVELS + 2][MAX_GUARDS + 2];
-
-/*** These are the (level) doors. ***/
-int arNrDoors[MAX_LEVELS + 2];
-int arOffsetDoors[MAX_LEVELS + 2];
-int arDoorType[MAX_LEVELS + 2][MAX_DOORS + 2];
-int arDoorYP[MAX_LEVELS + 2][MAX_DOORS + 2];
-int arDoorY[MAX_LEVELS + 2][MAX_DOORS + 2];
-int arDoorXP[MAX_LEVELS + 2][MAX_DOORS + 2];
-int arDoorX[MAX_LEVELS + 2][MAX_DOORS + 2];
-
-/*** These are the gates. ***/
-int arNrGates[MAX_LEVELS + 2];
-int arOffsetGates[MAX_LEVELS + 2];
-int arGateState1[MAX_LEVELS + 2][MAX_GATES + 2];
-int arGateYP[MAX_LEVELS + 2][MAX_GATES + 2];
-int arGateY[MAX_LEVELS + 2][MAX_GATES + 2];
-int arGateXP[MAX_LEVELS + 2][MAX_GATES + 2];
-int arGateX[MAX_LEVELS + 2][MAX_GATES + 2];
-int arGateState2[MAX_LEVELS + 2][MAX_GATES + 2];
-int arGateState3[MAX_LEVELS + 2][MAX_GATES + 2];
-int arGateUnk[MAX_LEVELS + 2][MAX_GATES + 2];
-
-/*** These are the loose (floors). ***/
-int arNrLoose[MAX_LEVELS + 2];
-int arOffsetLoose[MAX_LEVELS + 2];
-int arLooseYP[MAX_LEVELS + 2][MAX_LOOSE + 2];
-int arLooseY[MAX_LEVELS + 2][MAX_LOOSE + 2];
-int arLooseXP[MAX_LEVELS + 2][MAX_LOOSE + 2];
-int arLooseX[MAX_LEVELS + 2][MAX_LOOSE + 2];
-
-/*** These are the raise (buttons). ***/
-int arNrRaise[MAX_LEVELS + 2];
-int arOffsetRaise[MAX_LEVELS + 2];
-int arRaiseYP[MAX_LEVELS + 2][MAX_RAISE + 2];
-int arRaiseY[MAX_LEVELS + 2][MAX_RAISE + 2];
-int arRaiseXP[MAX_LEVELS + 2][MAX_RAISE + 2];
-int arRaiseX[MAX_LEVELS + 2][MAX_RAISE + 2];
-int arRaiseGate1[MAX_LEVELS + 2][MAX_RAISE + 2];
-int arRaiseGate2[MAX_LEVELS + 2][MAX_RAISE + 2];
-int arRaiseGate3[MAX_LEVELS + 2][MAX_RAISE + 2];
-
-/*** These are the drop (buttons). ***/
-int arNrDrop[MAX_LEVELS + 2];
-int arOffsetDrop[MAX_LEVELS + 2];
-int arDropYP[MAX_LEVELS + 2][MAX_DROP + 2];
-int arDropY[MAX_LEVELS + 2][MAX_DROP + 2];
-int arDropXP[MAX_LEVELS + 2][MAX_DROP + 2];
-int arDropX[MAX_LEVELS + 2][MAX_DROP + 2];
-int arDropGate1[MAX_LEVELS + 2][MAX_DROP + 2];
-int arDropGate2[MAX_LEVELS + 2][MAX_DROP + 2];
-int arDropGate3[MAX_LEVELS + 2][MAX_DROP + 2];
-
-/*** These are the chompers. ***/
-int arNrChompers[MAX_LEVELS + 2];
-int arOffsetChompers[MAX_LEVELS + 2];
-int arChomperYP[MAX_LEVELS + 2][MAX_CHOMPER + 2];
-int arChomperY[MAX_LEVELS + 2][MAX_CHOMPER + 2];
-int arChomperXP[MAX_LEVELS + 2][MAX_CHOMPER + 2];
-int arChomperX[MAX_LEVELS + 2][MAX_CHOMPER + 2];
-
-/*** These are the spikes. ***/
-int arNrSpikes[MAX_LEVELS + 2];
-int arOffsetSpikes[MAX_LEVELS + 2];
-int arSpikeYP[MAX_LEVELS + 2][MAX_SPIKE + 2];
-int arSpikeY[MAX_LEVELS + 2][MAX_SPIKE + 2];
-int arSpikeXP[MAX_LEVELS + 2][MAX_SPIKE + 2];
-int arSpikeX[MAX_LEVELS + 2][MAX_SPIKE + 2];
-
-/*** These are the potions. ***/
-int arNrPotions[MAX_LEVELS + 2];
-int arOffsetPotions[MAX_LEVELS + 2];
-int arPotionColor[MAX_LEVELS + 2][MAX_POTION + 2];
-int arPotionYP[MAX_LEVELS + 2][MAX_POTION + 2];
-int arPotionY[MAX_LEVELS + 2][MAX_POTION + 2];
-int arPotionXP[MAX_LEVELS + 2][MAX_POTION + 2];
-int arPotionX[MAX_LEVELS + 2][MAX_POTION + 2];
-int arPotionEffect[MAX_LEVELS + 2][MAX_POTION + 2];
-
-/*** These are used for removing and adding attributes. ***/
-int iNrTemp;
-int iTempAttr1[MAX_TEMP + 2];
-int iTempAttr2[MAX_TEMP + 2];
-int iTempAttr3[MAX_TEMP + 2];
-int iTempAttr4[MAX_TEMP + 2];
-int iTempAttr5[MAX_TEMP + 2];
-int iTempAttr6[MAX_TEMP + 2];
-int iTempAttr7[MAX_TEMP + 2];
-int iTempAttr8[MAX_TEMP + 2];
-int iTempAttr9[MAX_TEMP + 2];
+int arLevelChanged[MAX_LEVELS + 2]; /*** Other levels with unsaved changes. ***/
+/* The tiles of a level, allocated by SizeTiles(). Unlike in the ROM, where
+ * a level is stored column by column, each room is a block of TILES bytes,
+ * row by row; rooms follow each other row by row. Drawing or clearing a
+ * room then stays within one small block. Use the GetTile...() and
+ * SetTile...() functions, or RoomObjects() and RoomGraphics().
+ * arRecords holds, per tile and object value, the number of the record in
+ * arObjects[] at that tile, or 0, plus SHARED if more records are at that
+ * tile; see IndexObjects() and FindObject().
+ * SetTileObject() keeps track of the swords (0x0B) of a level. Normally
+ * there is one sword in the ROM; SaveLevels() uses the last one.
+ */
+struct tiles {
+	unsigned char *sObjects;
+	unsigned char *sGraphics;
+	unsigned short *arRecords; /*** NR_TYPES + 1 per tile. ***/
+	int iWidth; /*** In tiles. ***/
+	int iHeight; /*** In tiles. ***/
+	int iRoomsX; /*** Rooms per row. ***/
+	int iSwords; /*** Number of swords. ***/
+	int iSwordX, iSwordY; /*** The last sword, by X, then by Y. ***/
+} arLevelTiles[MAX_LEVELS + 2];
+
+/* The guards and the objects with attributes (doors, gates, etc.) of a
+ * level, per object value. Each record holds the words of one object in
+ * the order of its ROM table, see arTypes[], followed by iExtra words
+ * that only the editor uses. Use the ...Object...() and ...Field()
+ * functions; records are numbered from 1.
+ */
+struct objects {
+	unsigned short *arWords;
+	int iNr; /*** In records. ***/
+	int iAlloc; /*** In records. ***/
+} arObjects[MAX_LEVELS + 2][NR_TYPES + 2];
+
+/* The ROM table of each object value. Words in iFixed (a bit per word)
+ * always have the value in arFixed[]. Value 0x0C is used for guards.
+ * Raise and drop buttons have one handle (two words) per gate.
+ */
+struct type {
+	int iWords;
+	int iTop; /*** 1 if Y is the top of the tile, see LoadYTop(). ***/
+	int iMax;
+	int *iOffset;
+	char *sName;
+	int iFixed;
+	unsigned short arFixed[MAX_WORDS];
+	int iExtra;
+} arTypes[NR_TYPES + 2] = {
+	/*** 0x00-0x02: no table. ***/
+	{ 0 }, { 0 }, { 0 },
+	{ 7, 0, MAX_RAISE, &iOffsetRaise, "raise", 0x09, { 0x0001 }, 6 },
+	{ 7, 0, MAX_DROP, &iOffsetDrop, "drop", 0x09, { 0x0001 }, 6 },
+	{ 6, 1, MAX_GATES, &iOffsetGates, "gates", 0x00, { 0 }, 0 },
+	{ 5, 0, MAX_LOOSE, &iOffsetLoose, "loose", 0x19, { 0x0001 }, 0 },
+	{ 4, 0, MAX_SPIKE, &iOffsetSpikes, "spikes", 0x09,
+		{ 0x0001, 0, 0, 0xFFFF }, 0 },
+	{ 5, 1, MAX_CHOMPER, &iOffsetChompers, "chompers", 0x19, { 0x0001 }, 0 },
+	{ 5, 0, MAX_POTION, &iOffsetPotions, "potions", 0x08, { 0 }, 0 },
+	{ 5, 1, MAX_DOORS, &iOffsetDoors, "doors", 0x18, { 0 }, 0 },
+	/*** 0x0B: the sword has no table. ***/
+	{ 0 },
+	{ 12, 0, MAX_GUARDS, &iOffsetGuards, "guards", 0xC11, { 0 }, 0 } };
+
+/* What the ROM can hold, in the order of the lines on the enumerate
+ * screen. The totals, for all levels, are kept up to date by SizeTiles()
+ * (rooms) and SizeObjects(); see Total().
+ */
+struct budget {
+	int iObject; /*** TOTAL_ROOMS, or an object value. ***/
+	int iAllowedUS;
+	int iAllowedEU;
+} arBudgets[NR_BUDGETS] = {
+	{ TOTAL_ROOMS, ALLOWED_US_ROOMS, ALLOWED_EU_ROOMS },
+	{ 0x0C, ALLOWED_US_GUARDS, ALLOWED_EU_GUARDS },
+	{ 0x0A, ALLOWED_US_DOORS, ALLOWED_EU_DOORS },
+	{ 0x05, ALLOWED_US_GATES, ALLOWED_EU_GATES },
+	{ 0x06, ALLOWED_US_LOOSE, ALLOWED_EU_LOOSE },
+	{ 0x03, ALLOWED_US_RAISE, ALLOWED_EU_RAISE },
+	{ 0x04, ALLOWED_US_DROP, ALLOWED_EU_DROP },
+	{ 0x08, ALLOWED_US_CHOMPERS, ALLOWED_EU_CHOMPERS },
+	{ 0x07, ALLOWED_US_SPIKES, ALLOWED_EU_SPIKES },
+	{ 0x09, ALLOWED_US_POTIONS, ALLOWED_EU_POTIONS } };
+int arTotals[NR_TYPES + 2];
+
+/*** Bulk edits (of iCurLevel); see BeginEdits(). ***/
+int iEdits; /*** Nesting depth. ***/
+int arEditsNr[NR_TYPES + 2]; /*** Records before the edits, or -1. ***/
+
+/* The undo journal: the changes to iCurLevel, oldest first, in a ring of
+ * iUndoSize. The changes of one user action, such as a fill, share a
+ * group; see CloseChanges(). The first iChangesDone changes are done, the
+ * others can be redone. Only changes made while iJournal is 1 are kept.
+ * The ring takes sizeof (struct change), about 100 bytes, per change; the
+ * records and tile runs of the changes, iChangesBytes, are kept below
+ * UNDO_BYTES by dropping the oldest groups.
+ */
+struct tilechange {
+	unsigned short iX, iY;
+	unsigned char iType; /*** CHANGE_OBJECT or CHANGE_GRAPHICS. ***/
+	unsigned char iOld, iNew;
+};
+struct change {
+	int iGroup;
+	int iType; /*** CHANGE_... ***/
+	int iLevel;
+	int iObject; /*** For records. ***/
+	int iNr; /*** Record; for CHANGE_MERGE, the records before the batch. ***/
+	int iX, iY; /*** Tile; for CHANGE_WORD, X is the word. ***/
+	int iOld, iNew; /*** For CHANGE_SIZE, width * 256 + height, in rooms. ***/
+	int *iValue; /*** For CHANGE_INT. ***/
+	unsigned short *arWords; /*** The record(s) that were added or removed. ***/
+	int *arMap; /*** For CHANGE_MERGE: where each record went, or 0. ***/
+	struct tilechange *arTiles; /*** For CHANGE_TILES. ***/
+	int iTiles, iTilesAlloc;
+	int iBytes; /*** Allocated for arWords, arMap and arTiles. ***/
+} *arChanges;
+int iUndoSize;
+int iChangesFirst, iChangesNr, iChangesDone;
+long iChangesBytes;
+int iGroup, iGroupOpen, iGroupLost;
+int iJournal;
+unsigned char arReindex[MAX_LEVELS + 2][NR_TYPES + 2]; /*** See Undo(). ***/
+
+/* Snapshots of a level, taken with Ctrl+1-9. A snapshot does not depend
+ * on the undo journal; see GoToSnapshot(). It stays with its level, when
+ * another level is edited. Snapshot 0 is the state before the last go-to,
+ * and MAX_SNAPSHOTS + 1 is used while going to one.
+ * The tiles are copied on write, per room: arRooms[] starts out all NULL,
+ * for rooms that are still the same as in the level, and KeepRoom() gives
+ * a snapshot its own copy of a room just before the room changes. Rooms
+ * that several snapshots kept at the same time are shared. The records,
+ * a few KB per level at most, are copied when the snapshot is taken.
+ */
+struct room {
+	int iRefs;
+	unsigned char sObjects[TILES];
+	unsigned char sGraphics[TILES];
+};
+struct snapshot {
+	int iLevel; /*** 0 if not set. ***/
+	int iWidth, iHeight; /*** In rooms. ***/
+	int arValues[SNAPSHOT_VALUES]; /*** See arSnapshotValues[]. ***/
+	int iRooms; /*** As in struct tiles, when the snapshot was taken. ***/
+	struct room **arRooms;
+	unsigned short *arWords[NR_TYPES + 2];
+	int arNr[NR_TYPES + 2];
+} arSnapshots[MAX_SNAPSHOTS + 2];
+int *arSnapshotValues[SNAPSHOT_VALUES] = { arLevelType, arPrinceDir, arPrinceX,
+	arPrinceY, arLevelStartingX, arLevelStartingY };
 
 /*** Values on the object tabs. ***/
 int iRaiseGate1Check;
@@ -502,11 +705,57 @@ struct sample {
 	Uint32 dlen;
 } sounds[NUM_SOUNDS];
 
+/*** An in-memory copy of the ROM, with a position for the Put...() calls. ***/
+struct image {
+	unsigned char *sData;
+	int iSize;
+	int iPos;
+	int iFailed; /*** Set if a Put...() call fell outside the image. ***/
+};
+
+/* Where the level data of a ROM revision or hack is. iCRC and iSize
+ * identify the ROM; both are 0 for the layouts from the region byte.
+ */
+struct layout {
+	unsigned long iCRC;
+	int iSize;
+	int iEXEType;
+	int iNrLevels;
+	int iOffsetPrince;
+	int iOffsetLevels;
+	int iOffsetGrOb;
+	int iOffsetGuards;
+	int iOffsetDoors;
+	int iOffsetGates;
+	int iOffsetLoose;
+	int iOffsetRaise;
+	int iOffsetDrop;
+	int iOffsetChompers;
+	int iOffsetSpikes;
+	int iOffsetPotions;
+	char sName[MAX_TEXT + 2];
+};
+struct layout arLayouts[MAX_LAYOUTS + 2];
+int iNrLayouts;
+struct layout stLayout; /*** The layout of the ROM, see DetectLayout(). ***/
+
+/* The ROM session, see OpenROM(). The ROM stays open, stPristine is the
+ * ROM as it is on disk, and stWorking is the ROM with pending changes.
+ * Everything reads stPristine; stWorking only differs while saving.
+ */
+struct rom {
+	int iFd;
+	int iSaved;
+	struct image stPristine;
+	struct image stWorking;
+} stROM;
+
 void ShowUsage (void);
 void GetPathFile (void);
 void LoadLevels (void);
+void LoadLevel (int iLevel);
 void StringToUpper (char *sInput, char *sOutput);
-void SaveLevels (void);
+int SaveLevels (void);
 void PrintTileCombo (int iObjectValue, int iGraphicsValue);
 void PrIfDe (char *sString);
 void Quit (void);
@@ -536,16 +785,15 @@ void Prev (int iDiscard);
 void Next (int iDiscard);
 void CallSave (void);
 void SetLocation (int iX, int iY, int iObject, int iGraphics);
-void SetAttribute (int iX, int iY, int *arX, int *arY, int *arAttr,
-	int iNrObjects, int iValue);
-int HasObject (int iX, int iY, int *arX, int *arY, int iNrObjects);
+void SetAttribute (int iX, int iY, int iObject, int iField, int iValue);
+int HasObject (int iX, int iY, int iObject);
 int InArea (int iUpperLeftX, int iUpperLeftY,
 	int iLowerRightX, int iLowerRightY);
 int OnLevelBar (void);
 void ChangePos (void);
-void ShowImage (SDL_Texture *img, int iX, int iY, char *sImageInfo);
+void ShowImage (SDL_Texture *img, int iX, int iY, struct imginfo *stInfo);
 void CustomRenderCopy (SDL_Texture* src, SDL_Rect* srcrect,
-	SDL_Rect *dstrect, char *sImageInfo);
+	SDL_Rect *dstrect, struct imginfo *stInfo);
 void CreateBAK (void);
 void DisplayText (int iStartX, int iStartY, int iFontSize,
 	char arText[9 + 2][MAX_TEXT + 2], int iLines, TTF_Font *font,
@@ -574,31 +822,24 @@ void SetEnvTabRow (int iEnv, int iTab, int iRow,
 void SetEnvTabRows (void);
 int OnGraphics (void);
 void UpdateOnTile (void);
-void GetNrsAndOffsets (int iFd, int *arNr, int *arOffset,
-	int iObjectSize, char *sObjectName);
-void SetNrsAndOffsets (int iFd, int *arNr, int iStartOffset, int iObjectSize);
+void GetNrsAndOffsets (unsigned char *sROM, int iROMSize, int iObject);
+void SetNrsAndOffsets (struct image *stImage, int iObject);
 const char* ColorAsText (int iColor);
 const char* EffectAsText (int iEffect);
 const char* StateAsText (int iS1, int iS2, int iS3);
-int GetSelectedTileValue (int *arAttr, int *arX, int *arY,
-	int iNrObjects, int iDefault);
-int GetAttribute (int iX, int iY, int *arX, int *arY, int *arAttr,
-	int iNrObjects);
+int GetSelectedTileValue (int iObject, int iField, int iDefault);
+int GetAttribute (int iX, int iY, int iObject, int iField);
 void ModifyStart (int iLevel, int iToFrom);
-int Total (char *sType);
-void TotalLine (char *sType, int iAllowed, int iVer);
+int Total (int iObject);
+void TotalLine (int iBudget, int iVer);
+int Allowed (int iBudget);
 int IsSavingAllowed (void);
 void SetTypeDefaults (void);
-void WriteByte (int iFd, int iValue);
-void WriteWord (int iFd, int iValue);
-void WriteDWord (int iFd, int iValue);
 int LoadYBottom (int iYCoor);
 int SaveYBottom (int iY);
 int LoadYTop (int iYCoor);
 int SaveYTop (int iY);
-void TempAttributes (int iObject);
-void AddRemoveAttributes (int iObject, int iX, int iY, int *arNr,
-	int *arX, int *arY, int iType);
+void AddRemoveAttributes (int iObject, int iX, int iY, int iType);
 void AttributeDefaults (int iObject);
 void SetCheck (char *sObject, int iX, int iY, int iCheck, int iValue);
 void SetCheckGate (int iX, int iY, int iC, int iState, int iOpenn, int iDelay);
@@ -606,9 +847,128 @@ void UpdateSkillHP (void);
 void RandomizeLevel (void);
 int GuardSprite (int iType);
 void SingleSword (int iLevel, int iX, int iY);
-void SaveSword (int iFd, int iLevel, int iX, int iY);
+void SaveSword (struct image *stImage, int iLevel, int iX, int iY);
 void LevelResized (int iOldWidth, int iOldHeight);
-void RaiseDropUpdate (int iObjectNr, int iDecInc);
+void CheckRange (int iOffset, int iBytes, int iSize, char *sWhat);
+int GetWord (unsigned char *sData);
+int GetDWord (unsigned char *sData);
+void ReadImage (struct image *stImage);
+int WriteImage (void);
+void PutByte (struct image *stImage, int iValue);
+void PutWord (struct image *stImage, int iValue);
+void PutDWord (struct image *stImage, int iValue);
+void CopyImage (struct image *stFrom, struct image *stTo);
+int WriteChanges (void);
+void OpenROM (void);
+int GetLevelSlice (unsigned char *sROM, int iROMSize, int iStartOffset,
+	int iLevel, int *iNr, int iObjectSize);
+void DiscardChanges (void);
+void SizeTiles (int iLevel, int iWidth, int iHeight);
+int GetTileObject (int iLevel, int iX, int iY);
+int GetTileGraphics (int iLevel, int iX, int iY);
+void SetTileObject (int iLevel, int iX, int iY, int iValue);
+void SetTileGraphics (int iLevel, int iX, int iY, int iValue);
+unsigned long CRC32 (unsigned char *sData, int iSize);
+int ListBackups (char (**arBackups)[MAX_PATHFILE + 2]);
+int CompareNames (const void *vName1, const void *vName2);
+int DuplicateFile (char *sFrom, char *sTo);
+int LoadCache (void);
+void SaveCache (void);
+int CacheModel (struct image *stCache, int iSave);
+void CacheInts (struct image *stCache, int *arValues, int iNr, int iSave);
+void CacheBytes (struct image *stCache, unsigned char *sValues, int iNr,
+	int iSave);
+void SetChecksum (void);
+void DefaultLayout (struct layout *stL, int iType);
+void LoadLayouts (void);
+int CompareLayouts (const void *vLayout1, const void *vLayout2);
+int DetectLayout (void);
+int LayoutFits (struct layout *stL);
+void SizeObjects (int iLevel, int iObject, int iNr);
+unsigned short *ObjectRecord (int iLevel, int iObject, int iNr);
+void FixedWords (int iObject, unsigned short *arRecord);
+int RecordX (unsigned short *arRecord);
+int RecordY (int iObject, unsigned short *arRecord);
+void SetRecordXY (int iObject, unsigned short *arRecord, int iX, int iY);
+int GetObjectX (int iLevel, int iObject, int iNr);
+int GetObjectY (int iLevel, int iObject, int iNr);
+int GetField (int iLevel, int iObject, int iNr, int iField);
+void SetField (int iLevel, int iObject, int iNr, int iField, int iValue);
+int FindObject (int iLevel, int iObject, int iX, int iY);
+void LoadObjects (unsigned char *sROM, int iROMSize, int iLevel, int iObject);
+void SaveObjects (struct image *stImage, int iObject);
+void CacheWords (struct image *stCache, unsigned short *arValues, int iNr,
+	int iSave);
+int TileIndex (struct tiles *stTiles, int iX, int iY);
+unsigned char *RoomObjects (int iLevel, int iRoomX, int iRoomY);
+unsigned char *RoomGraphics (int iLevel, int iRoomX, int iRoomY);
+unsigned short *TileRecord (struct tiles *stTiles, int iX, int iY,
+	int iObject);
+void IndexObjects (int iLevel, int iObject, int iAdd);
+void IndexTile (int iLevel, int iObject, int iX, int iY);
+void BeginEdits (void);
+void EndEdits (void);
+void EditAttributes (int iObject, int iX, int iY, int iType);
+void MergeEdits (int iLevel, int iObject, int iStart);
+int CompareEdits (const void *vEdit1, const void *vEdit2);
+void CountSwords (int iLevel);
+void RemoveSword (int iLevel, int iX, int iY);
+int RecordWords (int iObject);
+void GateHandles (int iLevel);
+void GateHandle (int iLevel, unsigned short *arHandle, int iGate);
+int GateNumber (int iLevel, unsigned short *arHandle);
+void SetWord (int iLevel, int iObject, int iNr, int iWord, int iValue);
+void SetLevelValue (int *iValue, int iNew);
+struct change *NewChange (int iType, int iLevel);
+struct change *GetChange (int iChange);
+void FreeChange (struct change *stChange);
+void ClearChanges (void);
+void CloseChanges (void);
+void JournalTile (int iType, int iLevel, int iX, int iY, int iOld,
+	int iNew);
+void JournalRecord (int iType, int iLevel, int iObject, int iNr);
+void JournalSize (int iOldWidth, int iOldHeight);
+void InsertRecord (int iLevel, int iObject, int iNr, unsigned short *arWords);
+void DeleteRecord (int iLevel, int iObject, int iNr);
+void ApplyChange (struct change *stChange, int iRedo);
+void Reindex (int iLevel, int iObject);
+int Undo (void);
+int Redo (void);
+void UndoRedo (int iRedo);
+void ReindexMarked (void);
+void FreeSnapshot (int iSnapshot);
+int TakeSnapshot (int iSnapshot);
+int GoToSnapshot (int iSnapshot);
+void Snapshot (int iSnapshot, int iGoTo);
+void BeginScene (void);
+void EndScene (void);
+void AddDraw (struct draw *stDraw);
+int SameDraw (struct draw *stDraw1, struct draw *stDraw2);
+void AddDirty (SDL_Rect *rect);
+void PerformDraw (struct draw *stDraw);
+void ShowText (TTF_Font *font, char *sText, SDL_Color fore,
+	SDL_Color back, int iBlended, int iX, int iY);
+void LoadSprite (char *sImage, SDL_Texture **imgImage);
+SDL_Texture *CreateSprite (char *sImage);
+void AddSprite (SDL_Texture *img, SDL_Surface *surface);
+struct sprite *FindSprite (SDL_Texture *img);
+void FinishAtlas (void);
+void EndPreLoad (void);
+void Batch (struct sprite *stSprite, SDL_Rect *src, SDL_Rect *dst);
+void FlushBatch (void);
+SDL_Texture *TextTexture (struct draw *stDraw, int *iW, int *iH);
+void DropTexts (void);
+void ReadLayouts (char *sFile);
+int SameLayout (struct layout *stL1, struct layout *stL2);
+void SaveLayout (void);
+void CountBytes (struct change *stChange, int iBytes);
+unsigned char *ReadBuffer (char *sFile, int *iSize);
+int ReplaceROM (int iFd, char *sTemp);
+int NextRange (int iFrom, int *iEnd);
+void KeepRoom (int iLevel, int iRoom);
+void KeepRooms (int iLevel);
+int RestoreRecords (struct snapshot *stSnapshot, int iObject);
+void ReloadSprites (void);
 
 /*****************************************************************************/
 int main (int argc, char *argv[])
@@ -618,6 +978,8 @@ int main (int argc, char *argv[])
 	SDL_version verc, verl;
 	time_t tm;
 	char sStartLevel[MAX_OPTION + 2];
+	char sBackups[MAX_OPTION + 2];
+	char sUndo[MAX_OPTION + 2];
 
 	iDebug = 0;
 	iExtras = 0;
@@ -632,6 +994,11 @@ int main (int argc, char *argv[])
 	iStartLevel = 1;
 	iMednafen = 0;
 	iModified = 0;
+	iBackups = BACKUPS;
+	iBAKCRCKnown = 0;
+	iCache = 0;
+	iUndoSize = UNDO_SIZE;
+	iJournal = 0;
 
 	if (argc > 1)
 	{
@@ -679,6 +1046,31 @@ int main (int argc, char *argv[])
 					iStartLevel = 1;
 				}
 			}
+			else if ((strncmp (argv[iArgLoop], "-b=", 3) == 0) ||
+				(strncmp (argv[iArgLoop], "--backups=", 10) == 0))
+			{
+				GetOptionValue (argv[iArgLoop], sBackups);
+				iBackups = atoi (sBackups);
+				if ((iBackups < 0) || (iBackups > MAX_BACKUPS))
+				{
+					iBackups = BACKUPS;
+				}
+			}
+			else if ((strncmp (argv[iArgLoop], "-u=", 3) == 0) ||
+				(strncmp (argv[iArgLoop], "--undo=", 7) == 0))
+			{
+				GetOptionValue (argv[iArgLoop], sUndo);
+				iUndoSize = atoi (sUndo);
+				if ((iUndoSize < 0) || (iUndoSize > MAX_UNDO))
+				{
+					iUndoSize = UNDO_SIZE;
+				}
+			}
+			else if ((strcmp (argv[iArgLoop], "-c") == 0) ||
+				(strcmp (argv[iArgLoop], "--cache") == 0))
+			{
+				iCache = 1;
+			}
 			else if ((strcmp (argv[iArgLoop], "-k") == 0) ||
 				(strcmp (argv[iArgLoop], "--keyboard") == 0))
 			{
@@ -695,7 +1087,12 @@ int main (int argc, char *argv[])
 
 	srand ((unsigned)time(&tm));
 
-	LoadLevels();
+	if ((iCache == 0) || (LoadCache() == 0))
+	{
+		LoadLevels();
+		EXELoad();
+		if (iCache == 1) { SaveCache(); }
+	}
 
 	/*** Show the SDL version used for compiling and linking. ***/
 	if (iDebug == 1)
@@ -728,6 +1125,14 @@ void ShowUsage (void)
 	printf ("  -f,        --fullscreen     start in fullscreen mode\n");
 	printf ("  -l=NR,     --level=NR       start in level NR\n");
 	printf ("  -k,        --keyboard       do not use a game controller\n");
+	printf ("  -b=NR,     --backups=NR     keep NR ROM backups (default: %i)\n",
+		BACKUPS);
+	printf ("  -u=NR,     --undo=NR        keep NR changes to undo"
+		" (default: %i)\n", UNDO_SIZE);
+	printf ("                              (about 100 bytes each, plus at"
+		" most %i MiB)\n", UNDO_BYTES / (1024 * 1024));
+	printf ("  -c,        --cache          keep the parsed levels in a cache"
+		" file\n");
 	printf ("\n");
 	exit (EXIT_NORMAL);
 }
@@ -740,10 +1145,10 @@ void GetPathFile (void)
 	struct dirent *stDirent;
 	char sExtension[100 + 2];
 	char sError[MAX_ERROR + 2];
-	int iFd;
+	unsigned char *sROM;
 	char sVerify1[VERIFY_SIZE + 2], sVerify1Up[VERIFY_SIZE + 2];
 	char sVerify2[VERIFY_SIZE + 2], sVerify2Up[VERIFY_SIZE + 2];
-	char sEXEType[1 + 2];
+	char cEXEType;
 
 	iFound = 0;
 
@@ -799,19 +1204,19 @@ void GetPathFile (void)
 		exit (EXIT_ERROR);
 	}
 
-	iFd = open (sPathFile, O_RDONLY|O_BINARY);
-	if (iFd == -1)
-	{
-		printf ("[FAILED] Could not open \"%s\": %s!\n",
-			sPathFile, strerror (errno));
-		exit (EXIT_ERROR);
-	}
+	OpenROM();
+	sROM = stROM.stPristine.sData;
+
+	/*** A known revision or hack? ***/
+	LoadLayouts();
+	if (DetectLayout() == 1) { return; }
 
 	/*** Is the file a PoP1 for MD ROM file? ***/
-	lseek (iFd, VERIFY_OFFSET1, SEEK_SET);
-	read (iFd, sVerify1, VERIFY_SIZE);
-	lseek (iFd, VERIFY_OFFSET2, SEEK_SET);
-	read (iFd, sVerify2, VERIFY_SIZE);
+	CheckRange (VERIFY_OFFSET1, VERIFY_SIZE, stROM.stPristine.iSize, "verify");
+	CheckRange (VERIFY_OFFSET2, VERIFY_SIZE, stROM.stPristine.iSize, "verify");
+	CheckRange (OFFSET_REGION, 1, stROM.stPristine.iSize, "region");
+	memcpy (sVerify1, sROM + VERIFY_OFFSET1, VERIFY_SIZE);
+	memcpy (sVerify2, sROM + VERIFY_OFFSET2, VERIFY_SIZE);
 	sVerify1[VERIFY_SIZE] = '\0';
 	sVerify2[VERIFY_SIZE] = '\0';
 	StringToUpper (sVerify1, sVerify1Up);
@@ -828,217 +1233,63 @@ void GetPathFile (void)
 	}
 
 	/*** Store iEXEType. ***/
-	lseek (iFd, OFFSET_REGION, SEEK_SET);
-	read (iFd, sEXEType, 1);
-	switch (sEXEType[0])
+	cEXEType = sROM[OFFSET_REGION];
+	switch (cEXEType)
 	{
 		case 'U': iEXEType = 1; break; /*** US ***/
 		case 'E': iEXEType = 2; break; /*** EU ***/
 		default:
-			printf ("[FAILED] Unknown EXE type: %c!\n", sEXEType[0]);
+			printf ("[FAILED] Unknown EXE type: %c!\n", cEXEType);
 			exit (EXIT_ERROR); break;
 	}
 	if (iDebug == 1)
 	{
 		printf ("[ INFO ] Region (1 = US, 2 = EU): %i\n", iEXEType);
 	}
-	
-	close (iFd);
+
+	DefaultLayout (&stLayout, iEXEType);
+	if (LayoutFits (&stLayout) == 0)
+	{
+		snprintf (sError, MAX_ERROR, "The levels of %s are not where they"
+			" usually are. Add the ROM to %s%s%s.", sPathFile,
+			ROM_DIR, SLASH, LAYOUTS_FILE);
+		printf ("[FAILED] %s\n", sError);
+		SDL_ShowSimpleMessageBox (SDL_MESSAGEBOX_ERROR,
+			"Error", sError, NULL);
+		exit (EXIT_ERROR);
+	}
 }
 /*****************************************************************************/
 void LoadLevels (void)
 /*****************************************************************************/
 {
-	int iFd;
-	unsigned char sRead[MAX_BYTES + 2];
-	char sReadW[10 + 2];
-	char sReadDW[10 + 2];
-	int iObjects, iGraphics;
+	unsigned char *sROM;
+	int iROMSize;
 	int iObjectValue, iGraphicsValue;
-	int iSprite;
 
 	/*** Used for looping. ***/
 	int iLevelLoop;
 	int iHeightLoop;
 	int iWidthLoop;
-	int iGuardLoop;
-	int iDoorLoop;
-	int iGateLoop;
-	int iLooseLoop;
-	int iRaiseLoop;
-	int iDropLoop;
-	int iChomperLoop;
-	int iSpikeLoop;
-	int iPotionLoop;
-
-	iFd = open (sPathFile, O_RDONLY|O_BINARY);
-	if (iFd == -1)
-	{
-		printf ("[FAILED] Could not open \"%s\": %s!\n",
-			sPathFile, strerror (errno));
-		exit (EXIT_ERROR);
-	}
+	int iTypeLoop;
 
-	SetTypeDefaults();
-
-	/*** Prince ***/
-	lseek (iFd, iOffsetPrince, SEEK_SET);
-	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
-	{
-		/*** Y ***/
-		read (iFd, sRead, 2);
-		snprintf (sReadW, 10, "%02x%02x", sRead[0], sRead[1]);
-		arPrinceYP[iLevelLoop] = strtoul (sReadW, NULL, 16);
-		arPrinceY[iLevelLoop] = LoadYBottom (arPrinceYP[iLevelLoop]);
-
-		/*** X ***/
-		read (iFd, sRead, 2);
-		snprintf (sReadW, 10, "%02x%02x", sRead[0], sRead[1]);
-		arPrinceXP[iLevelLoop] = strtoul (sReadW, NULL, 16);
-		arPrinceX[iLevelLoop] =
-			(arPrinceXP[iLevelLoop] / 32) + 1;
-
-		/*** Dir ***/
-		read (iFd, sRead, 2);
-		snprintf (sReadW, 10, "%02x%02x", sRead[0], sRead[1]);
-		arPrinceDir[iLevelLoop] = strtoul (sReadW, NULL, 16);
-
-		if (iDebug == 1)
-		{
-			printf ("[ INFO ] Level %i, prince: y=%i (%i), x=%i (%i), dir=%i\n",
-				iLevelLoop,
-				arPrinceY[iLevelLoop],
-				arPrinceYP[iLevelLoop],
-				arPrinceX[iLevelLoop],
-				arPrinceXP[iLevelLoop],
-				arPrinceDir[iLevelLoop]);
-		}
-	}
+	/*** All values are decoded with big-endian loads from the ROM image. ***/
+	sROM = stROM.stPristine.sData;
+	iROMSize = stROM.stPristine.iSize;
 
-	lseek (iFd, iOffsetLevels, SEEK_SET);
-	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
-	{
-		/*** Height ***/
-		read (iFd, sRead, 2);
-		snprintf (sReadW, 10, "%02x%02x", sRead[0], sRead[1]);
-		arLevelHeightP[iLevelLoop] = strtoul (sReadW, NULL, 16);
-		arLevelHeight[iLevelLoop] = arLevelHeightP[iLevelLoop] / 192;
-
-		/*** Width ***/
-		read (iFd, sRead, 2);
-		snprintf (sReadW, 10, "%02x%02x", sRead[0], sRead[1]);
-		arLevelWidthP[iLevelLoop] = strtoul (sReadW, NULL, 16);
-		arLevelWidth[iLevelLoop] = arLevelWidthP[iLevelLoop] / 320;
-
-		/*** NrTiles ***/
-		read (iFd, sRead, 2);
-		snprintf (sReadW, 10, "%02x%02x", sRead[0], sRead[1]);
-		arLevelNrTiles[iLevelLoop] = strtoul (sReadW, NULL, 16);
-
-		/*** Warn if the number of tiles is off. ***/
-		if (arLevelNrTiles[iLevelLoop] != (arLevelHeight[iLevelLoop] *
-			arLevelWidth[iLevelLoop] * TILES))
-		{
-			printf ("[ WARN ] Incorrect number of tiles in level %i!\n",
-				iLevelLoop);
-		}
-
-		/*** Offset Graphics ***/
-		read (iFd, sRead, 4);
-		snprintf (sReadDW, 10, "%02x%02x%02x%02x",
-			sRead[0], sRead[1], sRead[2], sRead[3]);
-		arLevelOffsetGraphics[iLevelLoop] = strtoul (sReadDW, NULL, 16);
-
-		/*** Offset Objects ***/
-		read (iFd, sRead, 4);
-		snprintf (sReadDW, 10, "%02x%02x%02x%02x",
-			sRead[0], sRead[1], sRead[2], sRead[3]);
-		arLevelOffsetObjects[iLevelLoop] = strtoul (sReadDW, NULL, 16);
-
-		/*** Starting Y ***/
-		read (iFd, sRead, 2);
-		snprintf (sReadW, 10, "%02x%02x", sRead[0], sRead[1]);
-		arLevelStartingY[iLevelLoop] = (strtoul (sReadW, NULL, 16) / 192) + 1;
-
-		/*** Starting X ***/
-		read (iFd, sRead, 2);
-		snprintf (sReadW, 10, "%02x%02x", sRead[0], sRead[1]);
-		arLevelStartingX[iLevelLoop] = (strtoul (sReadW, NULL, 16) / 320) + 1;
-
-		/*** Type ***/
-		read (iFd, sRead, 2);
-		snprintf (sReadW, 10, "%02x%02x", sRead[0], sRead[1]);
-		arLevelType[iLevelLoop] = strtoul (sReadW, NULL, 16);
-
-		if (iDebug == 1)
-		{
-			printf ("========== Level %i ==========\n", iLevelLoop);
-			printf ("Height: %i (%i pixels)\n",
-				arLevelHeight[iLevelLoop], arLevelHeightP[iLevelLoop]);
-			printf ("Width: %i (%i pixels)\n",
-				arLevelWidth[iLevelLoop], arLevelWidthP[iLevelLoop]);
-			printf ("Tiles: %i (%i x %i x %i)\n",
-				arLevelNrTiles[iLevelLoop],
-				arLevelHeight[iLevelLoop],
-				arLevelWidth[iLevelLoop], TILES);
-			printf ("Offset Graphics: 0x%02X\n", arLevelOffsetGraphics[iLevelLoop]);
-			printf ("Offset Objects: 0x%02X\n", arLevelOffsetObjects[iLevelLoop]);
-			printf ("Starting Y: %i\n", arLevelStartingY[iLevelLoop]);
-			printf ("Starting X: %i\n", arLevelStartingX[iLevelLoop]);
-			printf ("Type (0 = dungeon, 1 = palace): %i\n", arLevelType[iLevelLoop]);
-		}
-	}
-
-	/* For the objects and graphics below, lseek is used in the for loops.
-	 * This is not necessary per se. A single for loop could be used, which,
-	 * for each level, first loads graphics and then objects. Then only
-	 * one lseek to iOffsetGrOb would be required.
-	 */
+	SetTypeDefaults();
 
-	/*** Objects. ***/
-	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
+	CheckRange (iOffsetPrince, iNrLevels * 6, iROMSize, "prince");
+	CheckRange (iOffsetLevels, iNrLevels * 20, iROMSize, "levels");
+	for (iTypeLoop = 0x03; iTypeLoop <= NR_TYPES; iTypeLoop++)
 	{
-		lseek (iFd, arLevelOffsetObjects[iLevelLoop], SEEK_SET);
-		iObjects = 0;
-		for (iWidthLoop = 1; iWidthLoop <= (arLevelWidth[iLevelLoop] * WIDTH);
-			iWidthLoop++)
-		{
-			for (iHeightLoop = 1; iHeightLoop <= (arLevelHeight[iLevelLoop] * HEIGHT);
-				iHeightLoop++)
-			{
-				read (iFd, sRead, 1);
-				arLevelObjects[iLevelLoop][iWidthLoop][iHeightLoop] = sRead[0];
-				iObjects++;
-			}
-		}
-		if (iObjects != arLevelNrTiles[iLevelLoop])
-		{
-			printf ("[ WARN ] Incorrect number of objects in level %i!\n",
-				iLevelLoop);
-		}
+		if (arTypes[iTypeLoop].iWords != 0)
+			{ GetNrsAndOffsets (sROM, iROMSize, iTypeLoop); }
 	}
 
-	/*** Graphics. ***/
 	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
 	{
-		lseek (iFd, arLevelOffsetGraphics[iLevelLoop], SEEK_SET);
-		iGraphics = 0;
-		for (iWidthLoop = 1; iWidthLoop <= (arLevelWidth[iLevelLoop] * WIDTH);
-			iWidthLoop++)
-		{
-			for (iHeightLoop = 1; iHeightLoop <= (arLevelHeight[iLevelLoop] * HEIGHT);
-				iHeightLoop++)
-			{
-				read (iFd, sRead, 1);
-				arLevelGraphics[iLevelLoop][iWidthLoop][iHeightLoop] = sRead[0];
-				iGraphics++;
-			}
-		}
-		if (iGraphics != arLevelNrTiles[iLevelLoop])
-		{
-			printf ("[ WARN ] Incorrect number of graphics in level %i!\n",
-				iLevelLoop);
-		}
+		LoadLevel (iLevelLoop);
 	}
 
 	/*** Show all rooms on the console. ***/
@@ -1054,10 +1305,9 @@ void LoadLevels (void)
 				for (iWidthLoop = 1; iWidthLoop <= (arLevelWidth[iLevelLoop] * WIDTH);
 					iWidthLoop++)
 				{
-					iObjectValue = arLevelObjects[iLevelLoop]
-						[iWidthLoop][iHeightLoop];
-					iGraphicsValue = arLevelGraphics[iLevelLoop]
-						[iWidthLoop][iHeightLoop];
+					iObjectValue = GetTileObject (iLevelLoop, iWidthLoop, iHeightLoop);
+					iGraphicsValue = GetTileGraphics (iLevelLoop,
+						iWidthLoop, iHeightLoop);
 					PrintTileCombo (iObjectValue, iGraphicsValue);
 					if (iWidthLoop != (arLevelWidth[iLevelLoop] * WIDTH))
 						{ printf ("|"); }
@@ -1066,495 +1316,159 @@ void LoadLevels (void)
 			}
 		}
 	}
+}
+/*****************************************************************************/
+void LoadLevel (int iLevel)
+/*****************************************************************************/
+{
+	/* Decodes one level from the pristine ROM image: its header, prince,
+	 * tiles and its slice of each object table. Also used to discard the
+	 * changes to a level.
+	 */
 
-	/*** Guards. ***/
-	lseek (iFd, iOffsetGuards, SEEK_SET);
-	GetNrsAndOffsets (iFd, arNrGuards, arOffsetGuards, 24, "guards");
-	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
-	{
-		if (arNrGuards[iLevelLoop] != 0)
-		{
-			/*** NOT using arOffsetGuards[iLevelLoop] here. ***/
-			for (iGuardLoop = 1; iGuardLoop <= arNrGuards[iLevelLoop]; iGuardLoop++)
-			{
-				read (iFd, sRead, 24);
-
-				ObjectWarn (sRead[0], 0);
-				ObjectWarn (sRead[1], 0);
-
-				/*** Y ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[2], sRead[3]);
-				arGuardYP[iLevelLoop][iGuardLoop] = strtoul (sReadW, NULL, 16);
-				arGuardY[iLevelLoop][iGuardLoop] =
-					LoadYBottom (arGuardYP[iLevelLoop][iGuardLoop]);
-
-				/*** X ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[4], sRead[5]);
-				arGuardXP[iLevelLoop][iGuardLoop] = strtoul (sReadW, NULL, 16);
-				arGuardX[iLevelLoop][iGuardLoop] =
-					(arGuardXP[iLevelLoop][iGuardLoop] / 32) + 1;
-
-				/*** Dir ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[6], sRead[7]);
-				arGuardDir[iLevelLoop][iGuardLoop] = strtoul (sReadW, NULL, 16);
+	unsigned char *sROM;
+	int iROMSize;
+	unsigned char *sRec;
+	int iObjects, iGraphics;
 
-				ObjectWarn (sRead[8], 0);
-				ObjectWarn (sRead[9], 0);
+	/*** Used for looping. ***/
+	int iWidthLoop, iHeightLoop;
+	int iTypeLoop;
 
-				/*** Type ***/
-				snprintf (sReadDW, 10, "%02x%02x%02x%02x",
-					sRead[10], sRead[11], sRead[12], sRead[13]);
-				arGuardSprite[iLevelLoop][iGuardLoop] = strtoul (sReadDW, NULL, 16);
-				iSprite = arGuardSprite[iLevelLoop][iGuardLoop];
-				snprintf (sReadW, 10, "%02x%02x", sRead[14], sRead[15]);
-				arGuardType[iLevelLoop][iGuardLoop] = strtoul (sReadW, NULL, 16);
-				switch (arGuardType[iLevelLoop][iGuardLoop])
-				{
-					case 0: /*** guard ***/
-						if ((iSprite != 0x23838) && (iSprite != 0x53C8C))
-							{ printf ("[ WARN ] Unexpected sprite!\n"); }
-						break;
-					case 1: /*** skeleton ***/
-						if ((iSprite != 0x23954) && (iSprite != 0x53DA2))
-							{ printf ("[ WARN ] Unexpected sprite!\n"); }
-						break;
-					case 2: /*** fat ***/
-						if ((iSprite != 0x23DD8) && (iSprite != 0x54226))
-							{ printf ("[ WARN ] Unexpected sprite!\n"); }
-						break;
-					case 3: /*** shadow ***/
-						if ((iSprite != 0x24000) && (iSprite != 0x54448))
-							{ printf ("[ WARN ] Unexpected sprite!\n"); }
-						break;
-					case 4: /*** Jaffar ***/
-						if ((iSprite != 0x241B2) && (iSprite != 0x545FA))
-							{ printf ("[ WARN ] Unexpected sprite!\n"); }
-						break;
-				}
+	sROM = stROM.stPristine.sData;
+	iROMSize = stROM.stPristine.iSize;
 
-				/*** Skill ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[16], sRead[17]);
-				arGuardSkill[iLevelLoop][iGuardLoop] = strtoul (sReadW, NULL, 16);
+	/*** Prince ***/
+	CheckRange (iOffsetPrince + ((iLevel - 1) * 6), 6, iROMSize, "prince");
+	sRec = sROM + iOffsetPrince + ((iLevel - 1) * 6);
 
-				/*** HP ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[18], sRead[19]);
-				arGuardHP[iLevelLoop][iGuardLoop] = strtoul (sReadW, NULL, 16);
+	/*** Y ***/
+	arPrinceYP[iLevel] = GetWord (sRec + 0);
+	arPrinceY[iLevel] = LoadYBottom (arPrinceYP[iLevel]);
 
-				ObjectWarn (sRead[20], 0);
-				ObjectWarn (sRead[21], 0);
-				ObjectWarn (sRead[22], 0);
-				ObjectWarn (sRead[23], 0);
+	/*** X ***/
+	arPrinceXP[iLevel] = GetWord (sRec + 2);
+	arPrinceX[iLevel] =
+		(arPrinceXP[iLevel] / 32) + 1;
 
-				if (iDebug == 1)
-				{
-					printf ("[ INFO ] Level %i, guard %i: x=%i, y=%i, dir=%i, type=%i,"
-						" skill=%i, hp=%i\n",
-						iLevelLoop,
-						iGuardLoop,
-						arGuardX[iLevelLoop][iGuardLoop],
-						arGuardY[iLevelLoop][iGuardLoop],
-						arGuardDir[iLevelLoop][iGuardLoop],
-						arGuardType[iLevelLoop][iGuardLoop],
-						arGuardSkill[iLevelLoop][iGuardLoop],
-						arGuardHP[iLevelLoop][iGuardLoop]);
-				}
-			}
-		}
-	}
+	/*** Dir ***/
+	arPrinceDir[iLevel] = GetWord (sRec + 4);
 
-	/*** Doors. ***/
-	lseek (iFd, iOffsetDoors, SEEK_SET);
-	GetNrsAndOffsets (iFd, arNrDoors, arOffsetDoors, 10, "doors");
-	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
+	if (iDebug == 1)
 	{
-		if (arNrDoors[iLevelLoop] != 0)
-		{
-			/*** NOT using arOffsetDoors[iLevelLoop] here. ***/
-			for (iDoorLoop = 1; iDoorLoop <= arNrDoors[iLevelLoop]; iDoorLoop++)
-			{
-				read (iFd, sRead, 10);
-
-				/*** Type ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[0], sRead[1]);
-				arDoorType[iLevelLoop][iDoorLoop] = strtoul (sReadW, NULL, 16);
-
-				/*** Y ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[2], sRead[3]);
-				arDoorYP[iLevelLoop][iDoorLoop] = strtoul (sReadW, NULL, 16);
-				arDoorY[iLevelLoop][iDoorLoop] =
-					LoadYTop (arDoorYP[iLevelLoop][iDoorLoop]);
-
-				/*** X ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[4], sRead[5]);
-				arDoorXP[iLevelLoop][iDoorLoop] = strtoul (sReadW, NULL, 16);
-				arDoorX[iLevelLoop][iDoorLoop] =
-					(arDoorXP[iLevelLoop][iDoorLoop] / 32) + 1;
-
-				ObjectWarn (sRead[6], 0);
-				ObjectWarn (sRead[7], 0);
-				ObjectWarn (sRead[8], 0);
-				ObjectWarn (sRead[9], 0);
-
-				if (iDebug == 1)
-				{
-					printf ("[ INFO ] Level %i, door %i: type=%i, y:%i, x:%i\n",
-						iLevelLoop,
-						iDoorLoop,
-						arDoorType[iLevelLoop][iDoorLoop],
-						arDoorY[iLevelLoop][iDoorLoop],
-						arDoorX[iLevelLoop][iDoorLoop]);
-				}
-			}
-		}
+		printf ("[ INFO ] Level %i, prince: y=%i (%i), x=%i (%i), dir=%i\n",
+			iLevel,
+			arPrinceY[iLevel],
+			arPrinceYP[iLevel],
+			arPrinceX[iLevel],
+			arPrinceXP[iLevel],
+			arPrinceDir[iLevel]);
 	}
 
-	/*** Gates. ***/
-	lseek (iFd, iOffsetGates, SEEK_SET);
-	GetNrsAndOffsets (iFd, arNrGates, arOffsetGates, 12, "gates");
-	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
-	{
-		if (arNrGates[iLevelLoop] != 0)
-		{
-			/*** NOT using arOffsetGates[iLevelLoop] here. ***/
-			for (iGateLoop = 1; iGateLoop <= arNrGates[iLevelLoop]; iGateLoop++)
-			{
-				read (iFd, sRead, 12);
+	CheckRange (iOffsetLevels + ((iLevel - 1) * 20), 20, iROMSize, "levels");
+	sRec = sROM + iOffsetLevels + ((iLevel - 1) * 20);
 
-				/*** State 1 ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[0], sRead[1]);
-				arGateState1[iLevelLoop][iGateLoop] = strtoul (sReadW, NULL, 16);
+	/*** Height ***/
+	arLevelHeightP[iLevel] = GetWord (sRec + 0);
+	arLevelHeight[iLevel] = arLevelHeightP[iLevel] / 192;
 
-				/*** Y ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[2], sRead[3]);
-				arGateYP[iLevelLoop][iGateLoop] = strtoul (sReadW, NULL, 16);
-				arGateY[iLevelLoop][iGateLoop] =
-					LoadYTop (arGateYP[iLevelLoop][iGateLoop]);
+	/*** Width ***/
+	arLevelWidthP[iLevel] = GetWord (sRec + 2);
+	arLevelWidth[iLevel] = arLevelWidthP[iLevel] / 320;
 
-				/*** X ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[4], sRead[5]);
-				arGateXP[iLevelLoop][iGateLoop] = strtoul (sReadW, NULL, 16);
-				arGateX[iLevelLoop][iGateLoop] =
-					(arGateXP[iLevelLoop][iGateLoop] / 32) + 1;
+	/*** NrTiles ***/
+	arLevelNrTiles[iLevel] = GetWord (sRec + 4);
 
-				/*** State 2 ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[6], sRead[7]);
-				arGateState2[iLevelLoop][iGateLoop] = strtoul (sReadW, NULL, 16);
-
-				/*** State 3 ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[8], sRead[9]);
-				arGateState3[iLevelLoop][iGateLoop] = strtoul (sReadW, NULL, 16);
-
-				/*** Unk ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[10], sRead[11]);
-				arGateUnk[iLevelLoop][iGateLoop] = strtoul (sReadW, NULL, 16);
-
-				if (iDebug == 1)
-				{
-					printf ("[ INFO ] Level %i, gate %i: s1=%i, y=%i, x=%i, s2=%i"
-						", s3=%i, unk=%i\n",
-						iLevelLoop,
-						iGateLoop,
-						arGateState1[iLevelLoop][iGateLoop],
-						arGateY[iLevelLoop][iGateLoop],
-						arGateX[iLevelLoop][iGateLoop],
-						arGateState2[iLevelLoop][iGateLoop],
-						arGateState3[iLevelLoop][iGateLoop],
-						arGateUnk[iLevelLoop][iGateLoop]);
-				}
-			}
-		}
+	/*** Warn if the number of tiles is off. ***/
+	if (arLevelNrTiles[iLevel] != (arLevelHeight[iLevel] *
+		arLevelWidth[iLevel] * TILES))
+	{
+		printf ("[ WARN ] Incorrect number of tiles in level %i!\n",
+			iLevel);
 	}
 
-	/*** Loose. ***/
-	lseek (iFd, iOffsetLoose, SEEK_SET);
-	GetNrsAndOffsets (iFd, arNrLoose, arOffsetLoose, 10, "loose");
-	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
-	{
-		if (arNrLoose[iLevelLoop] != 0)
-		{
-			/*** NOT using arOffsetLoose[iLevelLoop] here. ***/
-			for (iLooseLoop = 1; iLooseLoop <= arNrLoose[iLevelLoop]; iLooseLoop++)
-			{
-				read (iFd, sRead, 10);
+	/*** Offset Graphics ***/
+	arLevelOffsetGraphics[iLevel] = GetDWord (sRec + 6);
 
-				ObjectWarn (sRead[0], 0);
-				ObjectWarn (sRead[1], 1);
+	/*** Offset Objects ***/
+	arLevelOffsetObjects[iLevel] = GetDWord (sRec + 10);
 
-				/*** Y ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[2], sRead[3]);
-				arLooseYP[iLevelLoop][iLooseLoop] = strtoul (sReadW, NULL, 16);
-				arLooseY[iLevelLoop][iLooseLoop] =
-					LoadYBottom (arLooseYP[iLevelLoop][iLooseLoop]);
+	/*** Starting Y ***/
+	arLevelStartingY[iLevel] = (GetWord (sRec + 14) / 192) + 1;
 
-				/*** X ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[4], sRead[5]);
-				arLooseXP[iLevelLoop][iLooseLoop] = strtoul (sReadW, NULL, 16);
-				arLooseX[iLevelLoop][iLooseLoop] =
-					(arLooseXP[iLevelLoop][iLooseLoop] / 32) + 1;
+	/*** Starting X ***/
+	arLevelStartingX[iLevel] = (GetWord (sRec + 16) / 320) + 1;
 
-				ObjectWarn (sRead[6], 0);
-				ObjectWarn (sRead[7], 0);
-				ObjectWarn (sRead[8], 0);
-				ObjectWarn (sRead[9], 0);
+	/*** Type ***/
+	arLevelType[iLevel] = GetWord (sRec + 18);
 
-				if (iDebug == 1)
-				{
-					printf ("[ INFO ] Level %i, loose %i: y=%i, x=%i\n",
-						iLevelLoop,
-						iLooseLoop,
-						arLooseY[iLevelLoop][iLooseLoop],
-						arLooseX[iLevelLoop][iLooseLoop]);
-				}
-			}
-		}
-	}
+	if (iDebug == 1)
+	{
+		printf ("========== Level %i ==========\n", iLevel);
+		printf ("Height: %i (%i pixels)\n",
+			arLevelHeight[iLevel], arLevelHeightP[iLevel]);
+		printf ("Width: %i (%i pixels)\n",
+			arLevelWidth[iLevel], arLevelWidthP[iLevel]);
+		printf ("Tiles: %i (%i x %i x %i)\n",
+			arLevelNrTiles[iLevel],
+			arLevelHeight[iLevel],
+			arLevelWidth[iLevel], TILES);
+		printf ("Offset Graphics: 0x%02X\n", arLevelOffsetGraphics[iLevel]);
+		printf ("Offset Objects: 0x%02X\n", arLevelOffsetObjects[iLevel]);
+		printf ("Starting Y: %i\n", arLevelStartingY[iLevel]);
+		printf ("Starting X: %i\n", arLevelStartingX[iLevel]);
+		printf ("Type (0 = dungeon, 1 = palace): %i\n", arLevelType[iLevel]);
+	}
+
+	SizeTiles (iLevel, arLevelWidth[iLevel] * WIDTH,
+		arLevelHeight[iLevel] * HEIGHT);
 
-	/*** Raise. ***/
-	lseek (iFd, iOffsetRaise, SEEK_SET);
-	GetNrsAndOffsets (iFd, arNrRaise, arOffsetRaise, 14, "raise");
-	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
+	/*** Objects. ***/
+	iObjects = arLevelWidth[iLevel] * WIDTH * arLevelHeight[iLevel] * HEIGHT;
+	CheckRange (arLevelOffsetObjects[iLevel], iObjects, iROMSize, "objects");
+	for (iWidthLoop = 1; iWidthLoop <= arLevelTiles[iLevel].iWidth; iWidthLoop++)
 	{
-		if (arNrRaise[iLevelLoop] != 0)
+		sRec = sROM + arLevelOffsetObjects[iLevel] +
+			((iWidthLoop - 1) * arLevelTiles[iLevel].iHeight);
+		for (iHeightLoop = 1; iHeightLoop <= arLevelTiles[iLevel].iHeight;
+			iHeightLoop++)
 		{
-			/*** NOT using arOffsetRaise[iLevelLoop] here. ***/
-			for (iRaiseLoop = 1; iRaiseLoop <= arNrRaise[iLevelLoop]; iRaiseLoop++)
-			{
-				read (iFd, sRead, 14);
-
-				ObjectWarn (sRead[0], 0);
-				ObjectWarn (sRead[1], 1);
-
-				/*** Y ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[2], sRead[3]);
-				arRaiseYP[iLevelLoop][iRaiseLoop] = strtoul (sReadW, NULL, 16);
-				arRaiseY[iLevelLoop][iRaiseLoop] =
-					LoadYBottom (arRaiseYP[iLevelLoop][iRaiseLoop]);
-
-				/*** X ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[4], sRead[5]);
-				arRaiseXP[iLevelLoop][iRaiseLoop] = strtoul (sReadW, NULL, 16);
-				arRaiseX[iLevelLoop][iRaiseLoop] =
-					(arRaiseXP[iLevelLoop][iRaiseLoop] / 32) + 1;
-
-				ObjectWarn (sRead[6], 0);
-				ObjectWarn (sRead[7], 0);
-
-				/*** Gates 1, 2 and 3 ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[8], sRead[9]);
-				arRaiseGate1[iLevelLoop][iRaiseLoop] = strtoul (sReadW, NULL, 16);
-				snprintf (sReadW, 10, "%02x%02x", sRead[10], sRead[11]);
-				arRaiseGate2[iLevelLoop][iRaiseLoop] = strtoul (sReadW, NULL, 16);
-				snprintf (sReadW, 10, "%02x%02x", sRead[12], sRead[13]);
-				arRaiseGate3[iLevelLoop][iRaiseLoop] = strtoul (sReadW, NULL, 16);
-
-				if (iDebug == 1)
-				{
-					printf ("[ INFO ] Level %i, raise %i: y=%i, x=%i, g1=%s"
-						", g2=%s, g3=%s\n",
-						iLevelLoop,
-						iRaiseLoop,
-						arRaiseY[iLevelLoop][iRaiseLoop],
-						arRaiseX[iLevelLoop][iRaiseLoop],
-						GateAsText (arRaiseGate1[iLevelLoop][iRaiseLoop]),
-						GateAsText (arRaiseGate2[iLevelLoop][iRaiseLoop]),
-						GateAsText (arRaiseGate3[iLevelLoop][iRaiseLoop]));
-				}
-			}
+			SetTileObject (iLevel, iWidthLoop, iHeightLoop, sRec[iHeightLoop - 1]);
 		}
 	}
-
-	/*** Drop. ***/
-	lseek (iFd, iOffsetDrop, SEEK_SET);
-	GetNrsAndOffsets (iFd, arNrDrop, arOffsetDrop, 14, "drop");
-	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
+	if (iObjects != arLevelNrTiles[iLevel])
 	{
-		if (arNrDrop[iLevelLoop] != 0)
-		{
-			/*** NOT using arOffsetDrop[iLevelLoop] here. ***/
-			for (iDropLoop = 1; iDropLoop <= arNrDrop[iLevelLoop]; iDropLoop++)
-			{
-				read (iFd, sRead, 14);
-
-				ObjectWarn (sRead[0], 0);
-				ObjectWarn (sRead[1], 1);
-
-				/*** Y ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[2], sRead[3]);
-				arDropYP[iLevelLoop][iDropLoop] = strtoul (sReadW, NULL, 16);
-				arDropY[iLevelLoop][iDropLoop] =
-					LoadYBottom (arDropYP[iLevelLoop][iDropLoop]);
-
-				/*** X ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[4], sRead[5]);
-				arDropXP[iLevelLoop][iDropLoop] = strtoul (sReadW, NULL, 16);
-				arDropX[iLevelLoop][iDropLoop] =
-					(arDropXP[iLevelLoop][iDropLoop] / 32) + 1;
-
-				ObjectWarn (sRead[6], 0);
-				ObjectWarn (sRead[7], 0);
-
-				/*** Gates 1, 2 and 3 ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[8], sRead[9]);
-				arDropGate1[iLevelLoop][iDropLoop] = strtoul (sReadW, NULL, 16);
-				snprintf (sReadW, 10, "%02x%02x", sRead[10], sRead[11]);
-				arDropGate2[iLevelLoop][iDropLoop] = strtoul (sReadW, NULL, 16);
-				snprintf (sReadW, 10, "%02x%02x", sRead[12], sRead[13]);
-				arDropGate3[iLevelLoop][iDropLoop] = strtoul (sReadW, NULL, 16);
-
-				if (iDebug == 1)
-				{
-					printf ("[ INFO ] Level %i, drop %i: y=%i, x=%i, g1=%s"
-						", g2=%s, g3=%s\n",
-						iLevelLoop,
-						iDropLoop,
-						arDropY[iLevelLoop][iDropLoop],
-						arDropX[iLevelLoop][iDropLoop],
-						GateAsText (arDropGate1[iLevelLoop][iDropLoop]),
-						GateAsText (arDropGate2[iLevelLoop][iDropLoop]),
-						GateAsText (arDropGate3[iLevelLoop][iDropLoop]));
-				}
-			}
-		}
+		printf ("[ WARN ] Incorrect number of objects in level %i!\n",
+			iLevel);
 	}
 
-	/*** Chompers. ***/
-	lseek (iFd, iOffsetChompers, SEEK_SET);
-	GetNrsAndOffsets (iFd, arNrChompers, arOffsetChompers, 10, "chompers");
-	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
+	/*** Graphics. ***/
+	iGraphics = arLevelWidth[iLevel] * WIDTH * arLevelHeight[iLevel] * HEIGHT;
+	CheckRange (arLevelOffsetGraphics[iLevel], iGraphics, iROMSize, "graphics");
+	for (iWidthLoop = 1; iWidthLoop <= arLevelTiles[iLevel].iWidth; iWidthLoop++)
 	{
-		if (arNrChompers[iLevelLoop] != 0)
+		sRec = sROM + arLevelOffsetGraphics[iLevel] +
+			((iWidthLoop - 1) * arLevelTiles[iLevel].iHeight);
+		for (iHeightLoop = 1; iHeightLoop <= arLevelTiles[iLevel].iHeight;
+			iHeightLoop++)
 		{
-			/*** NOT using arOffsetChompers[iLevelLoop] here. ***/
-			for (iChomperLoop = 1; iChomperLoop <=
-				arNrChompers[iLevelLoop]; iChomperLoop++)
-			{
-				read (iFd, sRead, 10);
-
-				ObjectWarn (sRead[0], 0);
-				ObjectWarn (sRead[1], 1);
-
-				/*** Y ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[2], sRead[3]);
-				arChomperYP[iLevelLoop][iChomperLoop] = strtoul (sReadW, NULL, 16);
-				arChomperY[iLevelLoop][iChomperLoop] =
-					LoadYTop (arChomperYP[iLevelLoop][iChomperLoop]);
-
-				/*** X ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[4], sRead[5]);
-				arChomperXP[iLevelLoop][iChomperLoop] = strtoul (sReadW, NULL, 16);
-				arChomperX[iLevelLoop][iChomperLoop] =
-					(arChomperXP[iLevelLoop][iChomperLoop] / 32) + 1;
-
-				ObjectWarn (sRead[6], 0);
-				ObjectWarn (sRead[7], 0);
-				ObjectWarn (sRead[8], 0);
-				ObjectWarn (sRead[9], 0);
-
-				if (iDebug == 1)
-				{
-					printf ("[ INFO ] Level %i, chomper %i: y=%i, x=%i\n",
-						iLevelLoop,
-						iChomperLoop,
-						arChomperY[iLevelLoop][iChomperLoop],
-						arChomperX[iLevelLoop][iChomperLoop]);
-				}
-			}
+			SetTileGraphics (iLevel, iWidthLoop, iHeightLoop,
+				sRec[iHeightLoop - 1]);
 		}
 	}
-
-	/*** Spikes. ***/
-	lseek (iFd, iOffsetSpikes, SEEK_SET);
-	GetNrsAndOffsets (iFd, arNrSpikes, arOffsetSpikes, 8, "spikes");
-	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
+	if (iGraphics != arLevelNrTiles[iLevel])
 	{
-		if (arNrSpikes[iLevelLoop] != 0)
-		{
-			/*** NOT using arOffsetSpikes[iLevelLoop] here. ***/
-			for (iSpikeLoop = 1; iSpikeLoop <= arNrSpikes[iLevelLoop]; iSpikeLoop++)
-			{
-				read (iFd, sRead, 8);
-
-				ObjectWarn (sRead[0], 0);
-				ObjectWarn (sRead[1], 1);
-
-				/*** Y ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[2], sRead[3]);
-				arSpikeYP[iLevelLoop][iSpikeLoop] = strtoul (sReadW, NULL, 16);
-				arSpikeY[iLevelLoop][iSpikeLoop] =
-					LoadYBottom (arSpikeYP[iLevelLoop][iSpikeLoop]);
-
-				/*** X ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[4], sRead[5]);
-				arSpikeXP[iLevelLoop][iSpikeLoop] = strtoul (sReadW, NULL, 16);
-				arSpikeX[iLevelLoop][iSpikeLoop] =
-					(arSpikeXP[iLevelLoop][iSpikeLoop] / 32) + 1;
-
-				ObjectWarn (sRead[6], 0xFF);
-				ObjectWarn (sRead[7], 0xFF);
-
-				if (iDebug == 1)
-				{
-					printf ("[ INFO ] Level %i, spike %i: y=%i, x=%i\n",
-						iLevelLoop,
-						iSpikeLoop,
-						arSpikeY[iLevelLoop][iSpikeLoop],
-						arSpikeX[iLevelLoop][iSpikeLoop]);
-				}
-			}
-		}
+		printf ("[ WARN ] Incorrect number of graphics in level %i!\n",
+			iLevel);
 	}
 
-	/*** Potions. ***/
-	lseek (iFd, iOffsetPotions, SEEK_SET);
-	GetNrsAndOffsets (iFd, arNrPotions, arOffsetPotions, 10, "potion");
-	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
+	/*** Objects with attributes, and guards. ***/
+	for (iTypeLoop = 0x03; iTypeLoop <= NR_TYPES; iTypeLoop++)
 	{
-		if (arNrPotions[iLevelLoop] != 0)
-		{
-			/*** NOT using arOffsetPotions[iLevelLoop] here. ***/
-			for (iPotionLoop = 1; iPotionLoop <=
-				arNrPotions[iLevelLoop]; iPotionLoop++)
-			{
-				read (iFd, sRead, 10);
-
-				/*** Color ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[0], sRead[1]);
-				arPotionColor[iLevelLoop][iPotionLoop] = strtoul (sReadW, NULL, 16);
-
-				/*** Y ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[2], sRead[3]);
-				arPotionYP[iLevelLoop][iPotionLoop] = strtoul (sReadW, NULL, 16);
-				arPotionY[iLevelLoop][iPotionLoop] =
-					LoadYBottom (arPotionYP[iLevelLoop][iPotionLoop]);
-
-				/*** X ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[4], sRead[5]);
-				arPotionXP[iLevelLoop][iPotionLoop] = strtoul (sReadW, NULL, 16);
-				arPotionX[iLevelLoop][iPotionLoop] =
-					(arPotionXP[iLevelLoop][iPotionLoop] / 32) + 1;
-
-				ObjectWarn (sRead[6], 0);
-				ObjectWarn (sRead[7], 0);
-
-				/*** Effect ***/
-				snprintf (sReadW, 10, "%02x%02x", sRead[8], sRead[9]);
-				arPotionEffect[iLevelLoop][iPotionLoop] = strtoul (sReadW, NULL, 16);
-
-				if (iDebug == 1)
-				{
-					printf ("[ INFO ] Level %i, potion %i: c=%i, y=%i, x=%i, e=%i\n",
-						iLevelLoop,
-						iPotionLoop,
-						arPotionColor[iLevelLoop][iPotionLoop],
-						arPotionY[iLevelLoop][iPotionLoop],
-						arPotionX[iLevelLoop][iPotionLoop],
-						arPotionEffect[iLevelLoop][iPotionLoop]);
-				}
-			}
-		}
+		if (arTypes[iTypeLoop].iWords != 0)
+			{ LoadObjects (sROM, iROMSize, iLevel, iTypeLoop); }
 	}
-
-	close (iFd);
+	GateHandles (iLevel);
 }
 /*****************************************************************************/
 void StringToUpper (char *sInput, char *sOutput)
@@ -1570,61 +1484,54 @@ void StringToUpper (char *sInput, char *sOutput)
 	sOutput[iCharLoop] = '\0';
 }
 /*****************************************************************************/
-void SaveLevels (void)
+int SaveLevels (void)
 /*****************************************************************************/
 {
-	int iFd;
+	/*** Returns 1 if the levels were saved, 0 if nothing was saved. ***/
+
+	struct image *stImage;
 	int iToWrite;
 	int iNrTiles;
 	int iNrTilesTotal;
-	int iObject;
 	int iSwordLevel, iSwordX, iSwordY;
+	int iWritten;
 
 	/*** Used for looping. ***/
 	int iLevelLoop;
 	int iWidthLoop, iHeightLoop;
-	int iGuardLoop;
-	int iDoorLoop;
-	int iGateLoop;
-	int iLooseLoop;
-	int iRaiseLoop;
-	int iDropLoop;
-	int iChomperLoop;
-	int iSpikeLoop;
-	int iPotionLoop;
-
-	iFd = open (sPathFile, O_WRONLY|O_BINARY);
-	if (iFd == -1)
-	{
-		printf ("[FAILED] Could not open \"%s\": %s!\n",
-			sPathFile, strerror (errno));
-		exit (EXIT_ERROR);
-	}
+	int iTypeLoop;
+
+	/* Everything is serialized into the working image of the ROM. The first
+	 * save writes that image. Later saves compare it with the pristine image
+	 * first, and skip the write if no byte ranges differ.
+	 */
+	stImage = &stROM.stWorking;
+	stImage->iFailed = 0;
 
 	SetTypeDefaults();
 
 	/*** Prince ***/
-	lseek (iFd, iOffsetPrince, SEEK_SET);
+	stImage->iPos = iOffsetPrince;
 	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
 	{
 		iToWrite = SaveYBottom (arPrinceY[iLevelLoop]);
 		if ((iEXEType == 1) && (iLevelLoop == 7)) { iToWrite+=31; }
 		if ((iEXEType == 2) && (iLevelLoop == 9)) { iToWrite+=31; }
-		WriteWord (iFd, iToWrite); /*** Y ***/
+		PutWord (stImage, iToWrite); /*** Y ***/
 
 		iToWrite = (arPrinceX[iLevelLoop] - 1) * 32;
 		if ((iEXEType == 2) && (iLevelLoop == 1)) { iToWrite+=12; }
-		WriteWord (iFd, iToWrite); /*** X ***/
+		PutWord (stImage, iToWrite); /*** X ***/
 
-		WriteWord (iFd, arPrinceDir[iLevelLoop]); /*** Dir ***/
+		PutWord (stImage, arPrinceDir[iLevelLoop]); /*** Dir ***/
 	}
 
-	lseek (iFd, iOffsetLevels, SEEK_SET);
+	stImage->iPos = iOffsetLevels;
 	iNrTilesTotal = 0;
 	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
 	{
-		WriteWord (iFd, arLevelHeight[iLevelLoop] * 192); /*** Height ***/
-		WriteWord (iFd, arLevelWidth[iLevelLoop] * 320); /*** Width ***/
+		PutWord (stImage, arLevelHeight[iLevelLoop] * 192); /*** Height ***/
+		PutWord (stImage, arLevelWidth[iLevelLoop] * 320); /*** Width ***/
 		iNrTiles = arLevelWidth[iLevelLoop] *
 			arLevelHeight[iLevelLoop] * TILES;
 		if (iNrTiles != arLevelNrTiles[iLevelLoop])
@@ -1632,19 +1539,17 @@ void SaveLevels (void)
 			printf ("[ WARN ] Incorrect number of tiles in level %i: %i vs %i!\n",
 				iLevelLoop, iNrTiles, arLevelNrTiles[iLevelLoop]);
 		}
-		WriteWord (iFd, iNrTiles); /*** NrTiles ***/
-		WriteDWord (iFd, iOffsetGrOb + iNrTilesTotal); /*** Offset Graphics. ***/
-		WriteDWord (iFd, iOffsetGrOb + iNrTilesTotal + iNrTiles); /*** Off. O. ***/
-		WriteWord (iFd, (arLevelStartingY[iLevelLoop] - 1) * 192); /*** St. Y ***/
-		WriteWord (iFd, (arLevelStartingX[iLevelLoop] - 1) * 320); /*** St. X ***/
-		WriteWord (iFd, arLevelType[iLevelLoop]); /*** Type ***/
+		PutWord (stImage, iNrTiles); /*** NrTiles ***/
+		PutDWord (stImage, iOffsetGrOb + iNrTilesTotal); /*** Offset Graphics. ***/
+		PutDWord (stImage, iOffsetGrOb + iNrTilesTotal + iNrTiles); /*** O. O. ***/
+		PutWord (stImage, (arLevelStartingY[iLevelLoop] - 1) * 192); /*** St. Y ***/
+		PutWord (stImage, (arLevelStartingX[iLevelLoop] - 1) * 320); /*** St. X ***/
+		PutWord (stImage, arLevelType[iLevelLoop]); /*** Type ***/
 		iNrTilesTotal = iNrTilesTotal + (2 * iNrTiles);
 	}
 
 	/*** Graphics and objects. ***/
-	iSwordLevel = MAX_LEVELS + 1; /*** Default. In case there's no s. anywh. ***/
-	iSwordX = 1; iSwordY = 1; /*** Defaults. ***/
-	lseek (iFd, iOffsetGrOb, SEEK_SET);
+	stImage->iPos = iOffsetGrOb;
 	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
 	{
 		for (iWidthLoop = 1; iWidthLoop <= (arLevelWidth[iLevelLoop]
@@ -1653,7 +1558,8 @@ void SaveLevels (void)
 			for (iHeightLoop = 1; iHeightLoop <= (arLevelHeight[iLevelLoop]
 				* HEIGHT); iHeightLoop++)
 			{
-				WriteByte (iFd, arLevelGraphics[iLevelLoop][iWidthLoop][iHeightLoop]);
+				PutByte (stImage, GetTileGraphics (iLevelLoop,
+					iWidthLoop, iHeightLoop));
 			}
 		}
 		for (iWidthLoop = 1; iWidthLoop <= (arLevelWidth[iLevelLoop]
@@ -1662,235 +1568,65 @@ void SaveLevels (void)
 			for (iHeightLoop = 1; iHeightLoop <= (arLevelHeight[iLevelLoop]
 				* HEIGHT); iHeightLoop++)
 			{
-				iObject = arLevelObjects[iLevelLoop][iWidthLoop][iHeightLoop];
-				WriteByte (iFd, iObject);
-				if (iObject == 0x0B)
-				{
-					iSwordLevel = iLevelLoop;
-					iSwordX = iWidthLoop;
-					iSwordY = iHeightLoop;
-				}
+				PutByte (stImage, GetTileObject (iLevelLoop,
+					iWidthLoop, iHeightLoop));
 			}
 		}
 	}
 
-	/*** Save sword information. ***/
-	SaveSword (iFd, iSwordLevel, iSwordX, iSwordY);
-
-	/*** Guards. ***/
-	lseek (iFd, iOffsetGuards, SEEK_SET);
-	SetNrsAndOffsets (iFd, arNrGuards, iOffsetGuards, 24);
+	/*** Save sword information; of the last level with a sword. ***/
+	iSwordLevel = MAX_LEVELS + 1; /*** Default. In case there's no s. anywh. ***/
+	iSwordX = 1; iSwordY = 1; /*** Defaults. ***/
 	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
 	{
-		if (arNrGuards[iLevelLoop] != 0)
+		if (arLevelTiles[iLevelLoop].iSwords != 0)
 		{
-			for (iGuardLoop = 1; iGuardLoop <= arNrGuards[iLevelLoop]; iGuardLoop++)
-			{
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 0);
-				WriteWord (iFd, SaveYBottom
-					(arGuardY[iLevelLoop][iGuardLoop])); /*** Y ***/
-				WriteWord (iFd, (arGuardX[iLevelLoop][iGuardLoop]
-					- 1) * 32); /*** X ***/
-				WriteWord (iFd, arGuardDir[iLevelLoop][iGuardLoop]); /*** Dir ***/
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 0);
-				WriteDWord (iFd, arGuardSprite[iLevelLoop][iGuardLoop]); /*** Sp. ***/
-				WriteWord (iFd, arGuardType[iLevelLoop][iGuardLoop]); /*** Type ***/
-				WriteWord (iFd, arGuardSkill[iLevelLoop][iGuardLoop]); /*** Skill ***/
-				WriteWord (iFd, arGuardHP[iLevelLoop][iGuardLoop]); /*** HP ***/
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 0);
-			}
+			iSwordLevel = iLevelLoop;
+			iSwordX = arLevelTiles[iLevelLoop].iSwordX;
+			iSwordY = arLevelTiles[iLevelLoop].iSwordY;
 		}
 	}
+	SaveSword (stImage, iSwordLevel, iSwordX, iSwordY);
 
-	/*** Doors. ***/
-	lseek (iFd, iOffsetDoors, SEEK_SET);
-	SetNrsAndOffsets (iFd, arNrDoors, iOffsetDoors, 10);
-	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
+	/*** Objects with attributes, and guards. ***/
+	for (iTypeLoop = 0x03; iTypeLoop <= NR_TYPES; iTypeLoop++)
 	{
-		if (arNrDoors[iLevelLoop] != 0)
-		{
-			for (iDoorLoop = 1; iDoorLoop <= arNrDoors[iLevelLoop]; iDoorLoop++)
-			{
-				WriteWord (iFd, arDoorType[iLevelLoop][iDoorLoop]); /*** Type ***/
-				WriteWord (iFd, SaveYTop (arDoorY[iLevelLoop][iDoorLoop])); /*** Y ***/
-				WriteWord (iFd, (arDoorX[iLevelLoop][iDoorLoop] - 1) * 32); /*** X ***/
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 0);
-			}
-		}
-	}
-
-	/*** Gates. ***/
-	lseek (iFd, iOffsetGates, SEEK_SET);
-	SetNrsAndOffsets (iFd, arNrGates, iOffsetGates, 12);
-	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
-	{
-		if (arNrGates[iLevelLoop] != 0)
-		{
-			for (iGateLoop = 1; iGateLoop <= arNrGates[iLevelLoop]; iGateLoop++)
-			{
-				WriteWord (iFd, arGateState1[iLevelLoop][iGateLoop]); /*** State 1 ***/
-				WriteWord (iFd, SaveYTop (arGateY[iLevelLoop][iGateLoop])); /*** Y ***/
-				WriteWord (iFd, (arGateX[iLevelLoop][iGateLoop] - 1) * 32); /*** X ***/
-				WriteWord (iFd, arGateState2[iLevelLoop][iGateLoop]); /*** State 2 ***/
-				WriteWord (iFd, arGateState3[iLevelLoop][iGateLoop]); /*** State 3 ***/
-				WriteWord (iFd, arGateUnk[iLevelLoop][iGateLoop]); /*** Unk ***/
-			}
-		}
-	}
-
-	/*** Loose. ***/
-	lseek (iFd, iOffsetLoose, SEEK_SET);
-	SetNrsAndOffsets (iFd, arNrLoose, iOffsetLoose, 10);
-	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
-	{
-		if (arNrLoose[iLevelLoop] != 0)
-		{
-			for (iLooseLoop = 1; iLooseLoop <= arNrLoose[iLevelLoop]; iLooseLoop++)
-			{
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 1);
-				WriteWord (iFd, SaveYBottom
-					(arLooseY[iLevelLoop][iLooseLoop])); /*** Y ***/
-				WriteWord (iFd, (arLooseX[iLevelLoop][iLooseLoop]
-					- 1) * 32); /*** X ***/
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 0);
-			}
-		}
+		if (arTypes[iTypeLoop].iWords != 0)
+			{ SaveObjects (stImage, iTypeLoop); }
 	}
 
-	/*** Raise. ***/
-	lseek (iFd, iOffsetRaise, SEEK_SET);
-	SetNrsAndOffsets (iFd, arNrRaise, iOffsetRaise, 14);
-	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
+	/*** The working image must again match the ROM on disk. ***/
+	if (stImage->iFailed == 1)
 	{
-		if (arNrRaise[iLevelLoop] != 0)
-		{
-			for (iRaiseLoop = 1; iRaiseLoop <= arNrRaise[iLevelLoop]; iRaiseLoop++)
-			{
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 1);
-				WriteWord (iFd, SaveYBottom
-					(arRaiseY[iLevelLoop][iRaiseLoop])); /*** Y ***/
-				WriteWord (iFd, (arRaiseX[iLevelLoop][iRaiseLoop]
-					- 1) * 32); /*** X ***/
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 0);
-				WriteWord (iFd, arRaiseGate1[iLevelLoop][iRaiseLoop]);
-				WriteWord (iFd, arRaiseGate2[iLevelLoop][iRaiseLoop]);
-				WriteWord (iFd, arRaiseGate3[iLevelLoop][iRaiseLoop]);
-			}
-		}
+		printf ("[FAILED] The levels do not fit in the ROM; nothing was"
+			" saved!\n");
+		memcpy (stImage->sData, stROM.stPristine.sData, stImage->iSize);
+		return (0);
 	}
 
-	/*** Drop. ***/
-	lseek (iFd, iOffsetDrop, SEEK_SET);
-	SetNrsAndOffsets (iFd, arNrDrop, iOffsetDrop, 14);
-	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
+	if (stROM.iSaved == 0)
 	{
-		if (arNrDrop[iLevelLoop] != 0)
-		{
-			for (iDropLoop = 1; iDropLoop <= arNrDrop[iLevelLoop]; iDropLoop++)
-			{
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 1);
-				WriteWord (iFd, SaveYBottom
-					(arDropY[iLevelLoop][iDropLoop])); /*** Y ***/
-				WriteWord (iFd, (arDropX[iLevelLoop][iDropLoop]
-					- 1) * 32); /*** X ***/
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 0);
-				WriteWord (iFd, arDropGate1[iLevelLoop][iDropLoop]);
-				WriteWord (iFd, arDropGate2[iLevelLoop][iDropLoop]);
-				WriteWord (iFd, arDropGate3[iLevelLoop][iDropLoop]);
-			}
-		}
+		SetChecksum();
+		iWritten = WriteImage();
+		if (iWritten == 1) { stROM.iSaved = 1; }
+	} else {
+		iWritten = WriteChanges();
 	}
-
-	/*** Chompers. ***/
-	lseek (iFd, iOffsetChompers, SEEK_SET);
-	SetNrsAndOffsets (iFd, arNrChompers, iOffsetChompers, 10);
-	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
+	if (iWritten == 0)
 	{
-		if (arNrChompers[iLevelLoop] != 0)
-		{
-			for (iChomperLoop = 1; iChomperLoop <=
-				arNrChompers[iLevelLoop]; iChomperLoop++)
-			{
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 1);
-				WriteWord (iFd, SaveYTop
-					(arChomperY[iLevelLoop][iChomperLoop])); /*** Y ***/
-				WriteWord (iFd, (arChomperX[iLevelLoop][iChomperLoop]
-					- 1) * 32); /*** X ***/
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 0);
-			}
-		}
+		memcpy (stImage->sData, stROM.stPristine.sData, stImage->iSize);
+		return (0);
 	}
 
-	/*** Spikes. ***/
-	lseek (iFd, iOffsetSpikes, SEEK_SET);
-	SetNrsAndOffsets (iFd, arNrSpikes, iOffsetSpikes, 8);
-	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
-	{
-		if (arNrSpikes[iLevelLoop] != 0)
-		{
-			for (iSpikeLoop = 1; iSpikeLoop <= arNrSpikes[iLevelLoop]; iSpikeLoop++)
-			{
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 1);
-				WriteWord (iFd, SaveYBottom
-					(arSpikeY[iLevelLoop][iSpikeLoop])); /*** Y ***/
-				WriteWord (iFd, (arSpikeX[iLevelLoop][iSpikeLoop]
-					- 1) * 32); /*** X ***/
-				WriteByte (iFd, 0xFF);
-				WriteByte (iFd, 0xFF);
-			}
-		}
-	}
+	PlaySound ("wav/save.wav");
 
-	/*** Potions. ***/
-	lseek (iFd, iOffsetPotions, SEEK_SET);
-	SetNrsAndOffsets (iFd, arNrPotions, iOffsetPotions, 10);
 	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
-	{
-		if (arNrPotions[iLevelLoop] != 0)
-		{
-			for (iPotionLoop = 1; iPotionLoop <=
-				arNrPotions[iLevelLoop]; iPotionLoop++)
-			{
-				WriteWord (iFd,
-					arPotionColor[iLevelLoop][iPotionLoop]); /*** Color ***/
-				WriteWord (iFd, SaveYBottom
-					(arPotionY[iLevelLoop][iPotionLoop])); /*** Y ***/
-				WriteWord (iFd, (arPotionX[iLevelLoop][iPotionLoop]
-					- 1) * 32); /*** X ***/
-				WriteByte (iFd, 0);
-				WriteByte (iFd, 0);
-				WriteWord (iFd,
-					arPotionEffect[iLevelLoop][iPotionLoop]); /*** Effect ***/
-			}
-		}
-	}
-
-	close (iFd);
+		{ arLevelChanged[iLevelLoop] = 0; }
+	iChanged = 0;
 
-	PlaySound ("wav/save.wav");
+	if (iCache == 1) { SaveCache(); }
 
-	iChanged = 0;
+	return (1);
 }
 /*****************************************************************************/
 void PrintTileCombo (int iObjectValue, int iGraphicsValue)
@@ -2089,7 +1825,7 @@ void InitScreen (void)
 
 	/*** Loading... ***/
 	PreLoad (PNG_VARIOUS, "loading.png", &imgloading);
-	ShowImage (imgloading, 0, 0, "imgloading");
+	ShowImage (imgloading, 0, 0, PLAIN ("imgloading"));
 	SDL_SetRenderDrawColor (ascreen, 0x22, 0x22, 0x22, SDL_ALPHA_OPAQUE);
 	barbox.x = 10 * iScale;
 	barbox.y = 10 * iScale;
@@ -2307,6 +2043,7 @@ void InitScreen (void)
 
 	if (iDebug == 1)
 		{ printf ("[ INFO ] Preloaded images: %i\n", iPreLoaded); }
+	EndPreLoad();
 	SDL_SetCursor (curArrow);
 
 	/*** Defaults. ***/
@@ -2341,10 +2078,12 @@ void InitScreen (void)
 
 	ShowScreen();
 	InitPopUp();
+	iJournal = 1;
 	while (1)
 	{
 		while (SDL_PollEvent (&event))
 		{
+			CloseChanges();
 			switch (event.type)
 			{
 				case SDL_CONTROLLERBUTTONDOWN:
@@ -2511,6 +2250,19 @@ void InitScreen (void)
 					ShowScreen();
 					break;
 				case SDL_KEYDOWN: /*** https://wiki.libsdl.org/SDL2/SDL_Keycode ***/
+					if ((event.key.keysym.sym >= SDLK_0) &&
+						(event.key.keysym.sym <= SDLK_9) &&
+						(event.key.keysym.mod & (KMOD_CTRL | KMOD_ALT)))
+					{
+						if (event.key.keysym.mod & KMOD_ALT)
+						{
+							Snapshot (event.key.keysym.sym - SDLK_0, 1);
+						} else {
+							Snapshot (event.key.keysym.sym - SDLK_0, 0);
+						}
+						ShowScreen();
+						break;
+					}
 					switch (event.key.keysym.sym)
 					{
 						case SDLK_F1:
@@ -2716,13 +2468,19 @@ void InitScreen (void)
 						case SDLK_s:
 							if (iChanged != 0) { CallSave(); } break;
 						case SDLK_z:
-							if (iScreen == 1)
+							if (event.key.keysym.mod & KMOD_CTRL)
 							{
+								if (event.key.keysym.mod & KMOD_SHIFT)
+									{ UndoRedo (1); } else { UndoRedo (0); }
+							} else if (iScreen == 1) {
 								Zoom (0);
 								iExtras = 0;
 								PlaySound ("wav/extras.wav");
 							}
 							break;
+						case SDLK_y:
+							if (event.key.keysym.mod & KMOD_CTRL) { UndoRedo (1); }
+							break;
 						case SDLK_f:
 							if (iScreen == 1)
 							{
@@ -2787,15 +2545,9 @@ void InitScreen (void)
 								iGateX = ((iCurX - 1) * WIDTH) + iSelectedX;
 								iGateY = ((iCurY - 1) * HEIGHT) + iSelectedY;
 								SetLocation (iGateX, iGateY, 0x05, -1);
-								SetAttribute (iGateX, iGateY,
-									arGateX[iCurLevel], arGateY[iCurLevel],
-									arGateState1[iCurLevel], arNrGates[iCurLevel], 0);
-								SetAttribute (iGateX, iGateY,
-									arGateX[iCurLevel], arGateY[iCurLevel],
-									arGateState2[iCurLevel], arNrGates[iCurLevel], 0);
-								SetAttribute (iGateX, iGateY,
-								arGateX[iCurLevel], arGateY[iCurLevel],
-									arGateState3[iCurLevel], arNrGates[iCurLevel], 0);
+								SetAttribute (iGateX, iGateY, 0x05, GATE_STATE1, 0);
+								SetAttribute (iGateX, iGateY, 0x05, GATE_STATE2, 0);
+								SetAttribute (iGateX, iGateY, 0x05, GATE_STATE3, 0);
 								PlaySound ("wav/ok_close.wav"); iChanged++;
 							}
 							break;
@@ -2806,15 +2558,9 @@ void InitScreen (void)
 								iGateX = ((iCurX - 1) * WIDTH) + iSelectedX;
 								iGateY = ((iCurY - 1) * HEIGHT) + iSelectedY;
 								SetLocation (iGateX, iGateY, 0x05, -1);
-								SetAttribute (iGateX, iGateY,
-									arGateX[iCurLevel], arGateY[iCurLevel],
-									arGateState1[iCurLevel], arNrGates[iCurLevel], 3);
-								SetAttribute (iGateX, iGateY,
-									arGateX[iCurLevel], arGateY[iCurLevel],
-									arGateState2[iCurLevel], arNrGates[iCurLevel], 12);
-								SetAttribute (iGateX, iGateY,
-								arGateX[iCurLevel], arGateY[iCurLevel],
-									arGateState3[iCurLevel], arNrGates[iCurLevel], 0xFFFF);
+								SetAttribute (iGateX, iGateY, 0x05, GATE_STATE1, 3);
+								SetAttribute (iGateX, iGateY, 0x05, GATE_STATE2, 12);
+								SetAttribute (iGateX, iGateY, 0x05, GATE_STATE3, 0xFFFF);
 								PlaySound ("wav/ok_close.wav"); iChanged++;
 							}
 							break;
@@ -3325,6 +3071,15 @@ void InitScreen (void)
 				case SDL_WINDOWEVENT:
 					if (event.window.event == SDL_WINDOWEVENT_EXPOSED)
 						{ ShowScreen(); } break;
+				case SDL_RENDER_TARGETS_RESET:
+					iSceneValid = 0; ShowScreen(); break;
+				case SDL_RENDER_DEVICE_RESET:
+					/*** All textures are gone; the scene, texts and images. ***/
+					iSceneW = 0;
+					iSceneValid = 0;
+					DropTexts();
+					ReloadSprites();
+					ShowScreen(); break;
 				case SDL_QUIT:
 					Quit(); break;
 				default: break;
@@ -3440,23 +3195,31 @@ void ShowPopUpSave (void)
 	char arText[9 + 2][MAX_TEXT + 2];
 
 	/*** faded background ***/
-	ShowImage (imgfadedl, 0, 0, "imgfadedl");
+	ShowImage (imgfadedl, 0, 0, PLAIN ("imgfadedl"));
 
 	/*** popup ***/
-	ShowImage (imgpopup_yn, 150, 95, "imgpopup_yn");
+	ShowImage (imgpopup_yn, 150, 95, PLAIN ("imgpopup_yn"));
 
 	/*** Yes ***/
 	switch (iYesOn)
 	{
-		case 0: ShowImage (imgyes[1], 440, 323, "imgyes[1]"); break; /*** off ***/
-		case 1: ShowImage (imgyes[2], 440, 323, "imgyes[2]"); break; /*** on ***/
+		case 0: /*** off ***/
+			ShowImage (imgyes[1], 440, 323,
+				PLAIN ("imgyes[1]")); break;
+		case 1: /*** on ***/
+			ShowImage (imgyes[2], 440, 323,
+				PLAIN ("imgyes[2]")); break;
 	}
 
 	/*** No ***/
 	switch (iNoOn)
 	{
-		case 0: ShowImage (imgno[1], 167, 323, "imgno[1]"); break; /*** off ***/
-		case 1: ShowImage (imgno[2], 167, 323, "imgno[2]"); break; /*** on ***/
+		case 0: /*** off ***/
+			ShowImage (imgno[1], 167, 323,
+				PLAIN ("imgno[1]")); break;
+		case 1: /*** on ***/
+			ShowImage (imgno[2], 167, 323,
+				PLAIN ("imgno[2]")); break;
 	}
 
 	if (iChanged == 1)
@@ -3477,6 +3240,9 @@ void ShowPopUpSave (void)
 void LoadFonts (void)
 /*****************************************************************************/
 {
+	/*** The cached texts were rendered with the old fonts. ***/
+	DropTexts();
+
 	font1 = TTF_OpenFont ("ttf/Bitstream-Vera-Sans-Bold.ttf",
 		FONT_SIZE_15 * iScale);
 	if (font1 == NULL) { printf ("[FAILED] Font gone!\n"); exit (EXIT_ERROR); }
@@ -3563,15 +3329,10 @@ void PreLoadSet (int iTile)
 
 	snprintf (sDir, MAX_PATHFILE, "png%sobject%s", SLASH, SLASH);
 	snprintf (sImage, MAX_IMG, "%s0x%02x.png", sDir, iTile);
-	imgo[iTile][1] = IMG_LoadTexture (ascreen, sImage); /*** regular ***/
+	LoadSprite (sImage, &imgo[iTile][1]); /*** regular ***/
 	snprintf (sDir, MAX_PATHFILE, "png%ssobject%s", SLASH, SLASH);
 	snprintf (sImage, MAX_IMG, "%s0x%02x.png", sDir, iTile);
-	imgo[iTile][2] = IMG_LoadTexture (ascreen, sImage);
-	if ((!imgo[iTile][1]) || (!imgo[iTile][2]))
-	{
-		printf ("[FAILED] IMG_LoadTexture: %s!\n", IMG_GetError());
-		exit (EXIT_ERROR);
-	}
+	LoadSprite (sImage, &imgo[iTile][2]);
 
 	iPreLoaded+=2;
 	iBarHeight = (int)(((float)iPreLoaded/(float)iNrToPreLoad) * BAR_FULL);
@@ -3585,12 +3346,7 @@ void PreLoad (char *sPath, char *sPNG, SDL_Texture **imgImage)
 	int iBarHeight;
 
 	snprintf (sImage, MAX_IMG, "png%s%s%s%s", SLASH, sPath, SLASH, sPNG);
-	*imgImage = IMG_LoadTexture (ascreen, sImage);
-	if (!*imgImage)
-	{
-		printf ("[FAILED] IMG_LoadTexture: %s!\n", IMG_GetError());
-		exit (EXIT_ERROR);
-	}
+	LoadSprite (sImage, imgImage);
 
 	iPreLoaded++;
 	iBarHeight = (int)(((float)iPreLoaded/(float)iNrToPreLoad) * BAR_FULL);
@@ -3613,20 +3369,19 @@ void ShowScreen (void)
 	SDL_Color clr;
 	int iPrinceX, iPrinceY;
 
+	int iX, iY;
+	int iNr;
+	struct imginfo *stInfo;
+
 	/*** Used for looping. ***/
 	int iTileLoop;
-	int iGuardLoop;
-	int iDoorLoop;
-	int iGateLoop;
-	int iLooseLoop;
-	int iRaiseLoop;
-	int iDropLoop;
-	int iChomperLoop;
-	int iSpikeLoop;
-	int iPotionLoop;
+	int iButtonLoop;
+	int iBudgetLoop;
+
+	BeginScene();
 
 	/*** black background ***/
-	ShowImage (imgblack, 0, 0, "imgblack");
+	ShowImage (imgblack, 0, 0, PLAIN ("imgblack"));
 
 	if (iScreen == 1)
 	{
@@ -3636,39 +3391,39 @@ void ShowScreen (void)
 			iVerL = iVer0 - 32;
 			if (iCurY > 1)
 			{
-				iGraphics = arLevelGraphics[iCurLevel]
-					[((iCurX - 1) * WIDTH) + iTileLoop][((iCurY - 1) * HEIGHT)];
-				iObject = arLevelObjects[iCurLevel]
-					[((iCurX - 1) * WIDTH) + iTileLoop][((iCurY - 1) * HEIGHT)];
+				iGraphics = GetTileGraphics (iCurLevel,
+					((iCurX - 1) * WIDTH) + iTileLoop, ((iCurY - 1) * HEIGHT));
+				iObject = GetTileObject (iCurLevel,
+					((iCurX - 1) * WIDTH) + iTileLoop, ((iCurY - 1) * HEIGHT));
 			} else {
 				iGraphics = 0x00;
 				iObject = 0x00;
 			}
 			if (imgd[iGraphics][1] == NULL)
 				{ iUnknownG = 1; } else { iUnknownG = 0; }
-			snprintf (sInfo, MAX_INFO, "gra1=%i", iGraphics);
+			stInfo = IMGINFO (INFO_GRAPHICS, iGraphics, 1, "gra1");
 			if (iUnknownG == 1)
 			{
-				ShowImage (imgunkgraphics[1], iHor[iTileLoop], iVer0, sInfo);
+				ShowImage (imgunkgraphics[1], iHor[iTileLoop], iVer0, stInfo);
 			} else {
 				switch (arLevelType[iCurLevel])
 				{
 					case 0: /*** dungeon ***/
-						ShowImage (imgd[iGraphics][1], iHor[iTileLoop], iVer0, sInfo);
+						ShowImage (imgd[iGraphics][1], iHor[iTileLoop], iVer0, stInfo);
 						break;
 					case 1: /*** palace ***/
-						ShowImage (imgp[iGraphics][1], iHor[iTileLoop], iVer0, sInfo);
+						ShowImage (imgp[iGraphics][1], iHor[iTileLoop], iVer0, stInfo);
 						break;
 				}
 			}
 			if (imgo[iObject][1] == NULL)
 				{ iUnknownO = 1; } else { iUnknownO = 0; }
-			snprintf (sInfo, MAX_INFO, "obj1=%i", iObject);
+			stInfo = IMGINFO (INFO_OBJECT, iObject, 1, "obj1");
 			if (iUnknownO == 1)
 			{
-				ShowImage (imgunkobject[1], iHor[iTileLoop], iVerL, sInfo);
+				ShowImage (imgunkobject[1], iHor[iTileLoop], iVerL, stInfo);
 			} else {
-				ShowImage (imgo[iObject][1], iHor[iTileLoop], iVerL, sInfo);
+				ShowImage (imgo[iObject][1], iHor[iTileLoop], iVerL, stInfo);
 			}
 		}
 
@@ -3704,43 +3459,40 @@ void ShowScreen (void)
 				iVerL = iVer1;
 			}
 
-			iGraphics = arLevelGraphics[iCurLevel]
-				[((iCurX - 1) * WIDTH) + iLocX][((iCurY - 1) * HEIGHT) + iLocY];
+			iGraphics = GetTileGraphics (iCurLevel,
+				((iCurX - 1) * WIDTH) + iLocX, ((iCurY - 1) * HEIGHT) + iLocY);
 			if (imgd[iGraphics][1] == NULL)
 				{ iUnknownG = 1; } else { iUnknownG = 0; }
+			stInfo = IMGINFO (INFO_GRAPHICS, iGraphics, 1, "gra1");
 			if (iUnknownG == 1)
 			{
-				snprintf (sInfo, MAX_INFO, "gra1=%i", iGraphics);
-				ShowImage (imgunkgraphics[1], iHorL, iVerL, sInfo);
+				ShowImage (imgunkgraphics[1], iHorL, iVerL, stInfo);
 			} else {
 				switch (arLevelType[iCurLevel])
 				{
 					case 0: /*** dungeon ***/
-						snprintf (sInfo, MAX_INFO, "gra1=%i", iGraphics);
-						ShowImage (imgd[iGraphics][1], iHorL, iVerL, sInfo);
+						ShowImage (imgd[iGraphics][1], iHorL, iVerL, stInfo);
 						break;
 					case 1: /*** palace ***/
-						snprintf (sInfo, MAX_INFO, "gra1=%i", iGraphics);
-						ShowImage (imgp[iGraphics][1], iHorL, iVerL, sInfo);
+						ShowImage (imgp[iGraphics][1], iHorL, iVerL, stInfo);
 						break;
 				}
 			}
 			if ((iLocX == iSelectedX) && (iLocY == iSelectedY))
 			{
+				/*** The label is shown again, on top. ***/
+				stInfo = IMGINFO (INFO_GRAPHICS, iGraphics, 1, "gra2");
 				if (iUnknownG == 1)
 				{
-					snprintf (sInfo, MAX_INFO, "gra2=%i", iGraphics);
-					ShowImage (imgunkgraphics[2], iHorL, iVerL, sInfo);
+					ShowImage (imgunkgraphics[2], iHorL, iVerL, stInfo);
 				} else {
 					switch (arLevelType[iCurLevel])
 					{
 						case 0: /*** dungeon ***/
-							snprintf (sInfo, MAX_INFO, "gra2=%i", iGraphics);
-							ShowImage (imgd[iGraphics][2], iHorL, iVerL, sInfo);
+							ShowImage (imgd[iGraphics][2], iHorL, iVerL, stInfo);
 							break;
 						case 1: /*** palace ***/
-							snprintf (sInfo, MAX_INFO, "gra2=%i", iGraphics);
-							ShowImage (imgp[iGraphics][2], iHorL, iVerL, sInfo);
+							ShowImage (imgp[iGraphics][2], iHorL, iVerL, stInfo);
 							break;
 					}
 				}
@@ -3752,60 +3504,60 @@ void ShowScreen (void)
 		/*** One object: top row, room left. ***/
 		if (iCurX > 1)
 		{
-			iTile = arLevelObjects[iCurLevel]
-				[((iCurX - 1) * WIDTH)][((iCurY - 1) * HEIGHT) + 1];
+			iTile = GetTileObject (iCurLevel,
+				((iCurX - 1) * WIDTH), ((iCurY - 1) * HEIGHT) + 1);
 		} else {
 			iTile = 0x01;
 		}
-		snprintf (sInfo, MAX_INFO, "obj1=%i", iTile);
+		stInfo = IMGINFO (INFO_OBJECT, iTile, 1, "obj1");
 		iVerL = iVer1 - 32;
-		ShowImage (imgo[iTile][1], iHor[0], iVerL, sInfo);
-		ShowImage (imgfadeds, iHor[1], iVer1, "imgfadeds");
+		ShowImage (imgo[iTile][1], iHor[0], iVerL, stInfo);
+		ShowImage (imgfadeds, iHor[1], iVer1, PLAIN ("imgfadeds"));
 
 		/*** One object: middle row, room left. ***/
 		if (iCurX > 1)
 		{
-			iTile = arLevelObjects[iCurLevel]
-				[((iCurX - 1) * WIDTH)][((iCurY - 1) * HEIGHT) + 2];
+			iTile = GetTileObject (iCurLevel,
+				((iCurX - 1) * WIDTH), ((iCurY - 1) * HEIGHT) + 2);
 		} else {
 			iTile = 0x01;
 		}
-		snprintf (sInfo, MAX_INFO, "obj1=%i", iTile);
+		stInfo = IMGINFO (INFO_OBJECT, iTile, 1, "obj1");
 		iVerL = iVer2 - 32;
-		ShowImage (imgo[iTile][1], iHor[0], iVerL, sInfo);
-		ShowImage (imgfadeds, iHor[1], iVer2, "imgfadeds");
+		ShowImage (imgo[iTile][1], iHor[0], iVerL, stInfo);
+		ShowImage (imgfadeds, iHor[1], iVer2, PLAIN ("imgfadeds"));
 
 		/*** One object: 'top' row, room left down. ***/
 		if (iCurX > 1) /*** left ***/
 		{
 			if (iCurY < arLevelHeight[iCurLevel]) /*** down ***/
 			{
-				iTile = arLevelObjects[iCurLevel]
-					[((iCurX - 1) * WIDTH)][((iCurY - 1) * HEIGHT) + 4];
+				iTile = GetTileObject (iCurLevel,
+					((iCurX - 1) * WIDTH), ((iCurY - 1) * HEIGHT) + 4);
 			} else {
 				iTile = 0x01;
 			}
 		}
-		snprintf (sInfo, MAX_INFO, "obj1=%i", iTile);
+		stInfo = IMGINFO (INFO_OBJECT, iTile, 1, "obj1");
 		iVerL = iVer4 - 32;
 		/* This works, but, as with "under this room", there's no
 		 * need to show these images.
 		 */
-		/*** ShowImage (imgo[iTile][1], iHor[0], iVerL, sInfo); ***/
-		/*** ShowImage (imgfadeds, iHor[1], iVer4, "imgfadeds"); ***/
+		/*** ShowImage (imgo[iTile][1], iHor[0], iVerL, stInfo); ***/
+		/*** ShowImage (imgfadeds, iHor[1], iVer4, PLAIN ("imgfadeds")); ***/
 
 		/*** One object: bottom row, room left. ***/
 		if (iCurX > 1)
 		{
-			iTile = arLevelObjects[iCurLevel]
-				[((iCurX - 1) * WIDTH)][((iCurY - 1) * HEIGHT) + 3];
+			iTile = GetTileObject (iCurLevel,
+				((iCurX - 1) * WIDTH), ((iCurY - 1) * HEIGHT) + 3);
 		} else {
 			iTile = 0x01;
 		}
-		snprintf (sInfo, MAX_INFO, "obj1=%i", iTile);
+		stInfo = IMGINFO (INFO_OBJECT, iTile, 1, "obj1");
 		iVerL = iVer3 - 32;
-		ShowImage (imgo[iTile][1], iHor[0], iVerL, sInfo);
-		ShowImage (imgfadeds, iHor[1], iVer3, "imgfadeds");
+		ShowImage (imgo[iTile][1], iHor[0], iVerL, stInfo);
+		ShowImage (imgfadeds, iHor[1], iVer3, PLAIN ("imgfadeds"));
 
 		/*** Room tiles: objects. ***/
 		for (iTileLoop = 1; iTileLoop <= TILES; iTileLoop++)
@@ -3839,27 +3591,25 @@ void ShowScreen (void)
 				iVerL = iVer1 - 32;
 			}
 
-			iObject = arLevelObjects[iCurLevel]
-				[((iCurX - 1) * WIDTH) + iLocX][((iCurY - 1) * HEIGHT) + iLocY];
+			iObject = GetTileObject (iCurLevel,
+				((iCurX - 1) * WIDTH) + iLocX, ((iCurY - 1) * HEIGHT) + iLocY);
 			if (imgo[iObject][1] == NULL)
 				{ iUnknownO = 1; } else { iUnknownO = 0; }
+			stInfo = IMGINFO (INFO_OBJECT, iObject, 1, "obj1");
 			if (iUnknownO == 1)
 			{
-				snprintf (sInfo, MAX_INFO, "obj1=%i", iObject);
-				ShowImage (imgunkobject[1], iHorL, iVerL, sInfo);
+				ShowImage (imgunkobject[1], iHorL, iVerL, stInfo);
 			} else {
-				snprintf (sInfo, MAX_INFO, "obj1=%i", iObject);
-				ShowImage (imgo[iObject][1], iHorL, iVerL, sInfo);
+				ShowImage (imgo[iObject][1], iHorL, iVerL, stInfo);
 			}
 			if ((iLocX == iSelectedX) && (iLocY == iSelectedY))
 			{
+				stInfo = IMGINFO (INFO_OBJECT, iObject, 1, "obj2");
 				if (iUnknownO == 1)
 				{
-					snprintf (sInfo, MAX_INFO, "obj2=%i", iObject);
-					ShowImage (imgunkobject[2], iHorL, iVerL, sInfo);
+					ShowImage (imgunkobject[2], iHorL, iVerL, stInfo);
 				} else {
-					snprintf (sInfo, MAX_INFO, "obj2=%i", iObject);
-					ShowImage (imgo[iObject][2], iHorL, iVerL, sInfo);
+					ShowImage (imgo[iObject][2], iHorL, iVerL, stInfo);
 				}
 			}
 
@@ -3891,278 +3641,186 @@ void ShowScreen (void)
 				if (((iEXEType == 1) && (iCurLevel == 7)) || /*** US ***/
 					((iEXEType == 2) && (iCurLevel == 9))) /*** EU ***/
 					{ iPrinceY+=31; }
-				ShowImage (imgprince[1], iPrinceX, iPrinceY, "imgprince[1]");
+				ShowImage (imgprince[1], iPrinceX, iPrinceY, PLAIN ("imgprince[1]"));
 				if ((iLocX == iSelectedX) && (iLocY == iSelectedY))
-					{ ShowImage (imgprince[2], iPrinceX, iPrinceY, "imgprince[2]"); }
+					{ ShowImage (imgprince[2], iPrinceX, iPrinceY,
+						PLAIN ("imgprince[2]")); }
 			}
 
-			/*** guard(s) ***/
-			if (arNrGuards[iCurLevel] > 0)
+			/*** The object(s) on this tile. ***/
+			iX = ((iCurX - 1) * WIDTH) + iLocX;
+			iY = ((iCurY - 1) * HEIGHT) + iLocY;
+
+			/*** guard ***/
+			iNr = FindObject (iCurLevel, 0x0C, iX, iY);
+			if (iNr != 0)
 			{
-				for (iGuardLoop = 1; iGuardLoop <= arNrGuards[iCurLevel]; iGuardLoop++)
+				switch (GetField (iCurLevel, 0x0C, iNr, GUARD_DIR))
 				{
-					if ((arGuardX[iCurLevel][iGuardLoop] ==
-						((iCurX - 1) * WIDTH) + iLocX) &&
-						(arGuardY[iCurLevel][iGuardLoop] ==
-						((iCurY - 1) * HEIGHT) + iLocY))
-					{
-						switch (arGuardDir[iCurLevel][iGuardLoop])
+					case 0x00: /*** l ***/
+						switch (GetField (iCurLevel, 0x0C, iNr, GUARD_TYPE))
 						{
-							case 0x00: /*** l ***/
-								switch (arGuardType[iCurLevel][iGuardLoop])
-								{
-									case 0: /*** guard ***/
-										imgguard[1] = imgguardl[1];
-										imgguard[2] = imgguardl[2];
-										break;
-									case 1: /*** skeleton ***/
-										imgguard[1] = imgskeletonl[1];
-										imgguard[2] = imgskeletonl[2];
-										break;
-									case 2: /*** fat ***/
-										imgguard[1] = imgfatl[1];
-										imgguard[2] = imgfatl[2];
-										break;
-									case 3: /*** shadow ***/
-										imgguard[1] = imgshadowl[1];
-										imgguard[2] = imgshadowl[2];
-										break;
-									case 4: /*** Jaffar ***/
-										imgguard[1] = imgjaffarl[1];
-										imgguard[2] = imgjaffarl[2];
-										break;
-									default:
-										printf ("[FAILED] Incorrect guard type: %i!\n",
-											arGuardType[iCurLevel][iGuardLoop]);
-										exit (EXIT_ERROR);
-								}
+							case 0: /*** guard ***/
+								imgguard[1] = imgguardl[1];
+								imgguard[2] = imgguardl[2];
 								break;
-							case 0x800: /*** r ***/
-								switch (arGuardType[iCurLevel][iGuardLoop])
-								{
-									case 0: /*** guard ***/
-										imgguard[1] = imgguardr[1];
-										imgguard[2] = imgguardr[2];
-										break;
-									case 1: /*** skeleton ***/
-										imgguard[1] = imgskeletonr[1];
-										imgguard[2] = imgskeletonr[2];
-										break;
-									case 2: /*** fat ***/
-										imgguard[1] = imgfatr[1];
-										imgguard[2] = imgfatr[2];
-										break;
-									case 3: /*** shadow ***/
-										imgguard[1] = imgshadowr[1];
-										imgguard[2] = imgshadowr[2];
-										break;
-									case 4: /*** Jaffar ***/
-										imgguard[1] = imgjaffarr[1];
-										imgguard[2] = imgjaffarr[2];
-										break;
-									default:
-										printf ("[FAILED] Incorrect guard type: %i!\n",
-											arGuardType[iCurLevel][iGuardLoop]);
-										exit (EXIT_ERROR);
-								}
+							case 1: /*** skeleton ***/
+								imgguard[1] = imgskeletonl[1];
+								imgguard[2] = imgskeletonl[2];
+								break;
+							case 2: /*** fat ***/
+								imgguard[1] = imgfatl[1];
+								imgguard[2] = imgfatl[2];
+								break;
+							case 3: /*** shadow ***/
+								imgguard[1] = imgshadowl[1];
+								imgguard[2] = imgshadowl[2];
+								break;
+							case 4: /*** Jaffar ***/
+								imgguard[1] = imgjaffarl[1];
+								imgguard[2] = imgjaffarl[2];
 								break;
 							default:
-								printf ("[FAILED] Incorrect guard direction: 0x%02x!\n",
-									arGuardDir[iCurLevel][iGuardLoop]);
+								printf ("[FAILED] Incorrect guard type: %i!\n",
+									GetField (iCurLevel, 0x0C, iNr, GUARD_TYPE));
 								exit (EXIT_ERROR);
 						}
-						ShowImage (imgguard[1], iHorL, iVerL + 65, "imgguard[1]");
-						if ((iLocX == iSelectedX) && (iLocY == iSelectedY))
-							{ ShowImage (imgguard[2], iHorL, iVerL + 65, "imgguard[2]"); }
-						snprintf (arText[0], MAX_TEXT, "S:%i H:%i",
-							arGuardSkill[iCurLevel][iGuardLoop],
-							arGuardHP[iCurLevel][iGuardLoop]);
-						DisplayText (iHorL, iVerL + 151 - FONT_SIZE_11,
-							FONT_SIZE_11, arText, 1, font2, color_wh, color_bl);
-					}
-				}
-			}
-
-			/*** door ***/
-			if (arNrDoors[iCurLevel] > 0)
-			{
-				for (iDoorLoop = 1; iDoorLoop <= arNrDoors[iCurLevel]; iDoorLoop++)
-				{
-					if ((arDoorX[iCurLevel][iDoorLoop] ==
-						((iCurX - 1) * WIDTH) + iLocX) &&
-						(arDoorY[iCurLevel][iDoorLoop] ==
-						((iCurY - 1) * HEIGHT) + iLocY))
-					{
-						switch (arDoorType[iCurLevel][iDoorLoop])
+						break;
+					case 0x800: /*** r ***/
+						switch (GetField (iCurLevel, 0x0C, iNr, GUARD_TYPE))
 						{
-							case 0: /*** entrance ***/
-								snprintf (arText[0], MAX_TEXT, "%s", "entrance"); break;
-							case 2: /*** exit ***/
-								snprintf (arText[0], MAX_TEXT, "%s", "exit"); break;
-							default:
-								snprintf (arText[0], MAX_TEXT, "%s", "?");
-								printf ("[ WARN ] Strange door type: %i!\n",
-									arDoorType[iCurLevel][iDoorLoop]);
+							case 0: /*** guard ***/
+								imgguard[1] = imgguardr[1];
+								imgguard[2] = imgguardr[2];
+								break;
+							case 1: /*** skeleton ***/
+								imgguard[1] = imgskeletonr[1];
+								imgguard[2] = imgskeletonr[2];
 								break;
+							case 2: /*** fat ***/
+								imgguard[1] = imgfatr[1];
+								imgguard[2] = imgfatr[2];
+								break;
+							case 3: /*** shadow ***/
+								imgguard[1] = imgshadowr[1];
+								imgguard[2] = imgshadowr[2];
+								break;
+							case 4: /*** Jaffar ***/
+								imgguard[1] = imgjaffarr[1];
+								imgguard[2] = imgjaffarr[2];
+								break;
+							default:
+								printf ("[FAILED] Incorrect guard type: %i!\n",
+									GetField (iCurLevel, 0x0C, iNr, GUARD_TYPE));
+								exit (EXIT_ERROR);
 						}
-						DisplayText (iHorL, iVerL + 151 - FONT_SIZE_11,
-							FONT_SIZE_11, arText, 1, font2, color_wh, color_bl);
-					}
+						break;
+					default:
+						printf ("[FAILED] Incorrect guard direction: 0x%02x!\n",
+							GetField (iCurLevel, 0x0C, iNr, GUARD_DIR));
+						exit (EXIT_ERROR);
 				}
+				ShowImage (imgguard[1], iHorL, iVerL + 65, PLAIN ("imgguard[1]"));
+				if ((iLocX == iSelectedX) && (iLocY == iSelectedY))
+					{ ShowImage (imgguard[2], iHorL, iVerL + 65, PLAIN ("imgguard[2]")); }
+				snprintf (arText[0], MAX_TEXT, "S:%i H:%i",
+					GetField (iCurLevel, 0x0C, iNr, GUARD_SKILL),
+					GetField (iCurLevel, 0x0C, iNr, GUARD_HP));
+				DisplayText (iHorL, iVerL + 151 - FONT_SIZE_11,
+					FONT_SIZE_11, arText, 1, font2, color_wh, color_bl);
 			}
 
-			/*** gate ***/
-			if (arNrGates[iCurLevel] > 0)
+			/*** door ***/
+			iNr = FindObject (iCurLevel, 0x0A, iX, iY);
+			if (iNr != 0)
 			{
-				for (iGateLoop = 1; iGateLoop <= arNrGates[iCurLevel]; iGateLoop++)
+				switch (GetField (iCurLevel, 0x0A, iNr, DOOR_TYPE))
 				{
-					if ((arGateX[iCurLevel][iGateLoop] ==
-						((iCurX - 1) * WIDTH) + iLocX) &&
-						(arGateY[iCurLevel][iGateLoop] ==
-						((iCurY - 1) * HEIGHT) + iLocY))
-					{
-						snprintf (arText[0], MAX_TEXT, "%i", iGateLoop - 1);
-						snprintf (arText[1], MAX_TEXT, "%s", StateAsText (
-							arGateState1[iCurLevel][iGateLoop],
-							arGateState2[iCurLevel][iGateLoop],
-							arGateState3[iCurLevel][iGateLoop]));
-						DisplayText (iHorL, iVerL + 151 - 26,
-							FONT_SIZE_11, arText, 2, font2, color_wh, color_bl);
-					}
+					case 0: /*** entrance ***/
+						snprintf (arText[0], MAX_TEXT, "%s", "entrance"); break;
+					case 2: /*** exit ***/
+						snprintf (arText[0], MAX_TEXT, "%s", "exit"); break;
+					default:
+						snprintf (arText[0], MAX_TEXT, "%s", "?");
+						printf ("[ WARN ] Strange door type: %i!\n",
+							GetField (iCurLevel, 0x0A, iNr, DOOR_TYPE));
+						break;
 				}
+				DisplayText (iHorL, iVerL + 151 - FONT_SIZE_11,
+					FONT_SIZE_11, arText, 1, font2, color_wh, color_bl);
 			}
 
-			/*** loose ***/
-			if (arNrLoose[iCurLevel] > 0)
+			/*** gate ***/
+			iNr = FindObject (iCurLevel, 0x05, iX, iY);
+			if (iNr != 0)
 			{
-				for (iLooseLoop = 1; iLooseLoop <= arNrLoose[iCurLevel]; iLooseLoop++)
-				{
-					if ((arLooseX[iCurLevel][iLooseLoop] ==
-						((iCurX - 1) * WIDTH) + iLocX) &&
-						(arLooseY[iCurLevel][iLooseLoop] ==
-						((iCurY - 1) * HEIGHT) + iLocY))
-					{
-						if (iDebug == 1)
-						{
-							snprintf (arText[0], MAX_TEXT, "%s", "loose");
-							DisplayText (iHorL, iVerL + 151 - FONT_SIZE_11,
-								FONT_SIZE_11, arText, 1, font2, color_wh, color_bl);
-						}
-					}
-				}
+				snprintf (arText[0], MAX_TEXT, "%i", iNr - 1);
+				snprintf (arText[1], MAX_TEXT, "%s", StateAsText (
+					GetField (iCurLevel, 0x05, iNr, GATE_STATE1),
+					GetField (iCurLevel, 0x05, iNr, GATE_STATE2),
+					GetField (iCurLevel, 0x05, iNr, GATE_STATE3)));
+				DisplayText (iHorL, iVerL + 151 - 26,
+					FONT_SIZE_11, arText, 2, font2, color_wh, color_bl);
 			}
 
-			/*** raise ***/
-			if (arNrRaise[iCurLevel] > 0)
+			/*** loose ***/
+			if ((iDebug == 1) && (FindObject (iCurLevel, 0x06, iX, iY) != 0))
 			{
-				for (iRaiseLoop = 1; iRaiseLoop <= arNrRaise[iCurLevel]; iRaiseLoop++)
-				{
-					if ((arRaiseX[iCurLevel][iRaiseLoop] ==
-						((iCurX - 1) * WIDTH) + iLocX) &&
-						(arRaiseY[iCurLevel][iRaiseLoop] ==
-						((iCurY - 1) * HEIGHT) + iLocY))
-					{
-						snprintf (arText[0], MAX_TEXT, "%s",
-							GateAsText (arRaiseGate1[iCurLevel][iRaiseLoop]));
-						snprintf (arText[1], MAX_TEXT, "%s",
-							GateAsText (arRaiseGate2[iCurLevel][iRaiseLoop]));
-						snprintf (arText[2], MAX_TEXT, "%s",
-							GateAsText (arRaiseGate3[iCurLevel][iRaiseLoop]));
-						DisplayText (iHorL, iVerL + 151 - 41,
-							FONT_SIZE_11, arText, 3, font2, color_wh, color_bl);
-					}
-				}
+				snprintf (arText[0], MAX_TEXT, "%s", "loose");
+				DisplayText (iHorL, iVerL + 151 - FONT_SIZE_11,
+					FONT_SIZE_11, arText, 1, font2, color_wh, color_bl);
 			}
 
-			/*** drop ***/
-			if (arNrDrop[iCurLevel] > 0)
+			/*** raise (0x03) and drop (0x04) ***/
+			for (iButtonLoop = 0x03; iButtonLoop <= 0x04; iButtonLoop++)
 			{
-				for (iDropLoop = 1; iDropLoop <= arNrDrop[iCurLevel]; iDropLoop++)
+				iNr = FindObject (iCurLevel, iButtonLoop, iX, iY);
+				if (iNr != 0)
 				{
-					if ((arDropX[iCurLevel][iDropLoop] ==
-						((iCurX - 1) * WIDTH) + iLocX) &&
-						(arDropY[iCurLevel][iDropLoop] ==
-						((iCurY - 1) * HEIGHT) + iLocY))
-					{
-						snprintf (arText[0], MAX_TEXT, "%s",
-							GateAsText (arDropGate1[iCurLevel][iDropLoop]));
-						snprintf (arText[1], MAX_TEXT, "%s",
-							GateAsText (arDropGate2[iCurLevel][iDropLoop]));
-						snprintf (arText[2], MAX_TEXT, "%s",
-							GateAsText (arDropGate3[iCurLevel][iDropLoop]));
-						DisplayText (iHorL, iVerL + 151 - 41,
-							FONT_SIZE_11, arText, 3, font2, color_wh, color_bl);
-					}
+					snprintf (arText[0], MAX_TEXT, "%s", GateAsText
+						(GetField (iCurLevel, iButtonLoop, iNr, BUTTON_GATE1)));
+					snprintf (arText[1], MAX_TEXT, "%s", GateAsText
+						(GetField (iCurLevel, iButtonLoop, iNr, BUTTON_GATE2)));
+					snprintf (arText[2], MAX_TEXT, "%s", GateAsText
+						(GetField (iCurLevel, iButtonLoop, iNr, BUTTON_GATE3)));
+					DisplayText (iHorL, iVerL + 151 - 41,
+						FONT_SIZE_11, arText, 3, font2, color_wh, color_bl);
 				}
 			}
 
 			/*** chomper ***/
-			if (arNrChompers[iCurLevel] > 0)
+			if ((iDebug == 1) && (FindObject (iCurLevel, 0x08, iX, iY) != 0))
 			{
-				for (iChomperLoop = 1; iChomperLoop <=
-					arNrChompers[iCurLevel]; iChomperLoop++)
-				{
-					if ((arChomperX[iCurLevel][iChomperLoop] ==
-						((iCurX - 1) * WIDTH) + iLocX) &&
-						(arChomperY[iCurLevel][iChomperLoop] ==
-						((iCurY - 1) * HEIGHT) + iLocY))
-					{
-						if (iDebug == 1)
-						{
-							snprintf (arText[0], MAX_TEXT, "%s", "chomper");
-							DisplayText (iHorL, iVerL + 151 - FONT_SIZE_11,
-								FONT_SIZE_11, arText, 1, font2, color_wh, color_bl);
-						}
-					}
-				}
+				snprintf (arText[0], MAX_TEXT, "%s", "chomper");
+				DisplayText (iHorL, iVerL + 151 - FONT_SIZE_11,
+					FONT_SIZE_11, arText, 1, font2, color_wh, color_bl);
 			}
 
 			/*** spike ***/
-			if (arNrSpikes[iCurLevel] > 0)
+			if ((iDebug == 1) && (FindObject (iCurLevel, 0x07, iX, iY) != 0))
 			{
-				for (iSpikeLoop = 1; iSpikeLoop <= arNrSpikes[iCurLevel]; iSpikeLoop++)
-				{
-					if ((arSpikeX[iCurLevel][iSpikeLoop] ==
-						((iCurX - 1) * WIDTH) + iLocX) &&
-						(arSpikeY[iCurLevel][iSpikeLoop] ==
-						((iCurY - 1) * HEIGHT) + iLocY))
-					{
-						if (iDebug == 1)
-						{
-							snprintf (arText[0], MAX_TEXT, "%s", "spike");
-							DisplayText (iHorL, iVerL + 151 - FONT_SIZE_11,
-								FONT_SIZE_11, arText, 1, font2, color_wh, color_bl);
-						}
-					}
-				}
+				snprintf (arText[0], MAX_TEXT, "%s", "spike");
+				DisplayText (iHorL, iVerL + 151 - FONT_SIZE_11,
+					FONT_SIZE_11, arText, 1, font2, color_wh, color_bl);
 			}
 
 			/*** potion ***/
-			if (arNrPotions[iCurLevel] > 0)
+			iNr = FindObject (iCurLevel, 0x09, iX, iY);
+			if (iNr != 0)
 			{
-				for (iPotionLoop = 1; iPotionLoop <=
-					arNrPotions[iCurLevel]; iPotionLoop++)
-				{
-					if ((arPotionX[iCurLevel][iPotionLoop] ==
-						((iCurX - 1) * WIDTH) + iLocX) &&
-						(arPotionY[iCurLevel][iPotionLoop] ==
-						((iCurY - 1) * HEIGHT) + iLocY))
-					{
-						snprintf (arText[0], MAX_TEXT, "%s",
-							ColorAsText (arPotionColor[iCurLevel][iPotionLoop]));
-						snprintf (arText[1], MAX_TEXT, "%s",
-							EffectAsText (arPotionEffect[iCurLevel][iPotionLoop]));
-						DisplayText (iHorL, iVerL + 125,
-							FONT_SIZE_11, arText, 2, font2, color_wh, color_bl);
-					}
-				}
+				snprintf (arText[0], MAX_TEXT, "%s",
+					ColorAsText (GetField (iCurLevel, 0x09, iNr, POTION_COLOR)));
+				snprintf (arText[1], MAX_TEXT, "%s",
+					EffectAsText (GetField (iCurLevel, 0x09, iNr, POTION_EFFECT)));
+				DisplayText (iHorL, iVerL + 125,
+					FONT_SIZE_11, arText, 2, font2, color_wh, color_bl);
 			}
 		}
 	}
 	if (iScreen == 2) /*** R ***/
 	{
 		/*** background ***/
-		ShowImage (imgrooms, 25, 50, "imgrooms");
+		ShowImage (imgrooms, 25, 50, PLAIN ("imgrooms"));
 
 		/*** level width ***/
 		CenterNumber (arLevelWidth[iCurLevel], 349, 75, color_wh, 0);
@@ -4175,35 +3833,10 @@ void ShowScreen (void)
 	if (iScreen == 3) /*** E ***/
 	{
 		/*** background ***/
-		ShowImage (imgenumerate, 25, 50, "imgenumerate");
-
-		switch (iEXEType)
-		{
-			case 1: /*** US ***/
-				TotalLine ("rooms", ALLOWED_US_ROOMS, 0);
-				TotalLine ("guards", ALLOWED_US_GUARDS, 1);
-				TotalLine ("doors", ALLOWED_US_DOORS, 2);
-				TotalLine ("gates", ALLOWED_US_GATES, 3);
-				TotalLine ("loose", ALLOWED_US_LOOSE, 4);
-				TotalLine ("raise", ALLOWED_US_RAISE, 5);
-				TotalLine ("drop", ALLOWED_US_DROP, 6);
-				TotalLine ("chompers", ALLOWED_US_CHOMPERS, 7);
-				TotalLine ("spikes", ALLOWED_US_SPIKES, 8);
-				TotalLine ("potions", ALLOWED_US_POTIONS, 9);
-				break;
-			case 2: /*** EU ***/
-				TotalLine ("rooms", ALLOWED_EU_ROOMS, 0);
-				TotalLine ("guards", ALLOWED_EU_GUARDS, 1);
-				TotalLine ("doors", ALLOWED_EU_DOORS, 2);
-				TotalLine ("gates", ALLOWED_EU_GATES, 3);
-				TotalLine ("loose", ALLOWED_EU_LOOSE, 4);
-				TotalLine ("raise", ALLOWED_EU_RAISE, 5);
-				TotalLine ("drop", ALLOWED_EU_DROP, 6);
-				TotalLine ("chompers", ALLOWED_EU_CHOMPERS, 7);
-				TotalLine ("spikes", ALLOWED_EU_SPIKES, 8);
-				TotalLine ("potions", ALLOWED_EU_POTIONS, 9);
-				break;
-		}
+		ShowImage (imgenumerate, 25, 50, PLAIN ("imgenumerate"));
+
+		for (iBudgetLoop = 0; iBudgetLoop < NR_BUDGETS; iBudgetLoop++)
+			{ TotalLine (iBudgetLoop, iBudgetLoop); }
 
 		if (IsSavingAllowed() == 1)
 		{
@@ -4222,13 +3855,13 @@ void ShowScreen (void)
 		/*** yes ***/
 		if (iDownAt == 1)
 		{
-			ShowImage (imgleft_1, 0, 50, "imgleft_1"); /*** down ***/
+			ShowImage (imgleft_1, 0, 50, PLAIN ("imgleft_1")); /*** down ***/
 		} else {
-			ShowImage (imgleft_0, 0, 50, "imgleft_0"); /*** up ***/
+			ShowImage (imgleft_0, 0, 50, PLAIN ("imgleft_0")); /*** up ***/
 		}
 	} else {
 		/*** no ***/
-		ShowImage (imglrno, 0, 50, "imglrno");
+		ShowImage (imglrno, 0, 50, PLAIN ("imglrno"));
 	}
 
 	/*** right ***/
@@ -4237,13 +3870,13 @@ void ShowScreen (void)
 		/*** yes ***/
 		if (iDownAt == 2)
 		{
-			ShowImage (imgright_1, 667, 50, "imgright_1"); /*** down ***/
+			ShowImage (imgright_1, 667, 50, PLAIN ("imgright_1")); /*** down ***/
 		} else {
-			ShowImage (imgright_0, 667, 50, "imgright_0"); /*** up ***/
+			ShowImage (imgright_0, 667, 50, PLAIN ("imgright_0")); /*** up ***/
 		}
 	} else {
 		/*** no ***/
-		ShowImage (imglrno, 667, 50, "imglrno");
+		ShowImage (imglrno, 667, 50, PLAIN ("imglrno"));
 	}
 
 	/*** up ***/
@@ -4252,17 +3885,17 @@ void ShowScreen (void)
 		/*** yes ***/
 		if (iDownAt == 3)
 		{
-			ShowImage (imgup_1, 25, 25, "imgup_1"); /*** down ***/
+			ShowImage (imgup_1, 25, 25, PLAIN ("imgup_1")); /*** down ***/
 		} else {
-			ShowImage (imgup_0, 25, 25, "imgup_0"); /*** up ***/
+			ShowImage (imgup_0, 25, 25, PLAIN ("imgup_0")); /*** up ***/
 		}
 	} else {
 		/*** no ***/
 		if (iScreen != 1)
 		{
-			ShowImage (imgudno, 25, 25, "imgudno"); /*** without info ***/
+			ShowImage (imgudno, 25, 25, PLAIN ("imgudno")); /*** without info ***/
 		} else {
-			ShowImage (imgudnonfo, 25, 25, "imgudnonfo"); /*** with info ***/
+			ShowImage (imgudnonfo, 25, 25, PLAIN ("imgudnonfo")); /*** with info ***/
 		}
 	}
 
@@ -4272,13 +3905,13 @@ void ShowScreen (void)
 		/*** yes ***/
 		if (iDownAt == 4)
 		{
-			ShowImage (imgdown_1, 25, 442, "imgdown_1"); /*** down ***/
+			ShowImage (imgdown_1, 25, 442, PLAIN ("imgdown_1")); /*** down ***/
 		} else {
-			ShowImage (imgdown_0, 25, 442, "imgdown_0"); /*** up ***/
+			ShowImage (imgdown_0, 25, 442, PLAIN ("imgdown_0")); /*** up ***/
 		}
 	} else {
 		/*** no ***/
-		ShowImage (imgudno, 25, 442, "imgudno");
+		ShowImage (imgudno, 25, 442, PLAIN ("imgudno"));
 	}
 
 	switch (iScreen)
@@ -4287,40 +3920,40 @@ void ShowScreen (void)
 			/*** rooms on ***/
 			if (iDownAt == 5)
 			{
-				ShowImage (imgroomson_1, 0, 25, "imgroomson_1"); /*** down ***/
+				ShowImage (imgroomson_1, 0, 25, PLAIN ("imgroomson_1")); /*** down ***/
 			} else {
-				ShowImage (imgroomson_0, 0, 25, "imgroomson_0"); /*** up ***/
+				ShowImage (imgroomson_0, 0, 25, PLAIN ("imgroomson_0")); /*** up ***/
 			}
 			/*** enumerate on ***/
 			if (iDownAt == 6)
 			{
-				ShowImage (imgenumon_1, 667, 25, "imgenumon_1"); /*** down ***/
+				ShowImage (imgenumon_1, 667, 25, PLAIN ("imgenumon_1")); /*** down ***/
 			} else {
-				ShowImage (imgenumon_0, 667, 25, "imgenumon_0"); /*** up ***/
+				ShowImage (imgenumon_0, 667, 25, PLAIN ("imgenumon_0")); /*** up ***/
 			}
 			break;
 		case 2:
 			/*** rooms off ***/
-			ShowImage (imgroomsoff, 0, 25, "imgroomsoff");
+			ShowImage (imgroomsoff, 0, 25, PLAIN ("imgroomsoff"));
 
 			/*** enumerate on ***/
 			if (iDownAt == 6)
 			{
-				ShowImage (imgenumon_1, 667, 25, "imgenumon_1"); /*** down ***/
+				ShowImage (imgenumon_1, 667, 25, PLAIN ("imgenumon_1")); /*** down ***/
 			} else {
-				ShowImage (imgenumon_0, 667, 25, "imgenumon_0"); /*** up ***/
+				ShowImage (imgenumon_0, 667, 25, PLAIN ("imgenumon_0")); /*** up ***/
 			}
 			break;
 		case 3:
 			/*** rooms on ***/
 			if (iDownAt == 5)
 			{
-				ShowImage (imgroomson_1, 0, 25, "imgroomson_1"); /*** down ***/
+				ShowImage (imgroomson_1, 0, 25, PLAIN ("imgroomson_1")); /*** down ***/
 			} else {
-				ShowImage (imgroomson_0, 0, 25, "imgroomson_0"); /*** up ***/
+				ShowImage (imgroomson_0, 0, 25, PLAIN ("imgroomson_0")); /*** up ***/
 			}
 			/*** enumerate off ***/
-			ShowImage (imgenumoff, 667, 25, "imgenumoff");
+			ShowImage (imgenumoff, 667, 25, PLAIN ("imgenumoff"));
 			break;
 	}
 
@@ -4330,21 +3963,21 @@ void ShowScreen (void)
 		/*** on ***/
 		if (iDownAt == 7)
 		{
-			ShowImage (imgsaveon_1, 0, 442, "imgsaveon_1"); /*** down ***/
+			ShowImage (imgsaveon_1, 0, 442, PLAIN ("imgsaveon_1")); /*** down ***/
 		} else {
-			ShowImage (imgsaveon_0, 0, 442, "imgsaveon_0"); /*** up ***/
+			ShowImage (imgsaveon_0, 0, 442, PLAIN ("imgsaveon_0")); /*** up ***/
 		}
 	} else {
 		/*** off ***/
-		ShowImage (imgsaveoff, 0, 442, "imgsaveoff");
+		ShowImage (imgsaveoff, 0, 442, PLAIN ("imgsaveoff"));
 	}
 
 	/*** quit ***/
 	if (iDownAt == 8)
 	{
-		ShowImage (imgquit_1, 667, 442, "imgquit_1"); /*** down ***/
+		ShowImage (imgquit_1, 667, 442, PLAIN ("imgquit_1")); /*** down ***/
 	} else {
-		ShowImage (imgquit_0, 667, 442, "imgquit_0"); /*** up ***/
+		ShowImage (imgquit_0, 667, 442, PLAIN ("imgquit_0")); /*** up ***/
 	}
 
 	/*** previous ***/
@@ -4353,13 +3986,13 @@ void ShowScreen (void)
 		/*** on ***/
 		if (iDownAt == 9)
 		{
-			ShowImage (imgprevon_1, 0, 0, "imgprevon_1"); /*** down ***/
+			ShowImage (imgprevon_1, 0, 0, PLAIN ("imgprevon_1")); /*** down ***/
 		} else {
-			ShowImage (imgprevon_0, 0, 0, "imgprevon_0"); /*** up ***/
+			ShowImage (imgprevon_0, 0, 0, PLAIN ("imgprevon_0")); /*** up ***/
 		}
 	} else {
 		/*** off ***/
-		ShowImage (imgprevoff, 0, 0, "imgprevoff");
+		ShowImage (imgprevoff, 0, 0, PLAIN ("imgprevoff"));
 	}
 
 	/*** next ***/
@@ -4368,17 +4001,17 @@ void ShowScreen (void)
 		/*** on ***/
 		if (iDownAt == 10)
 		{
-			ShowImage (imgnexton_1, 667, 0, "imgnexton_1"); /*** down ***/
+			ShowImage (imgnexton_1, 667, 0, PLAIN ("imgnexton_1")); /*** down ***/
 		} else {
-			ShowImage (imgnexton_0, 667, 0, "imgnexton_0"); /*** up ***/
+			ShowImage (imgnexton_0, 667, 0, PLAIN ("imgnexton_0")); /*** up ***/
 		}
 	} else {
 		/*** off ***/
-		ShowImage (imgnextoff, 667, 0, "imgnextoff");
+		ShowImage (imgnextoff, 667, 0, PLAIN ("imgnextoff"));
 	}
 
 	/*** level bar ***/
-	ShowImage (imgbar, 25, 0, "imgbar");
+	ShowImage (imgbar, 25, 0, PLAIN ("imgbar"));
 
 	/*** Assemble level bar text. ***/
 	if (iEXEType == 1) /*** US ***/
@@ -4429,7 +4062,7 @@ void ShowScreen (void)
 		case 1:
 			snprintf (sLevelBarF, MAX_TEXT, "%s room x:%i y:%i",
 				sLevelBar, iCurX, iCurY);
-			ShowImage (imgextras[iExtras], 610, 3, "imgextras[...]");
+			ShowImage (imgextras[iExtras], 610, 3, PLAIN ("imgextras[...]"));
 			break;
 		case 2:
 			snprintf (sLevelBarF, MAX_TEXT, "%s rooms", sLevelBar); break;
@@ -4438,16 +4071,13 @@ void ShowScreen (void)
 	}
 
 	/*** Mednafen information. ***/
-	if (iMednafen == 1) { ShowImage (imgmednafen, 25, 50, "imgmednafen"); }
+	if (iMednafen == 1)
+		{ ShowImage (imgmednafen, 25, 50, PLAIN ("imgmednafen")); }
 
 	/*** Display level bar text. ***/
-	message = TTF_RenderText_Shaded (font1, sLevelBarF, color_bl, color_wh);
-	messaget = SDL_CreateTextureFromSurface (ascreen, message);
-	offset.x = 31;
-	offset.y = 5;
-	offset.w = message->w; offset.h = message->h;
-	CustomRenderCopy (messaget, NULL, &offset, "message");
-	SDL_DestroyTexture (messaget); SDL_FreeSurface (message);
+	ShowText (font1, sLevelBarF, color_bl, color_wh, 0, 31, 5);
+
+	EndScene();
 
 	/*** refresh screen ***/
 	SDL_RenderPresent (ascreen);
@@ -4541,16 +4171,20 @@ void ShowPopUp (void)
 	char arText[9 + 2][MAX_TEXT + 2];
 
 	/*** faded background ***/
-	ShowImage (imgfadedl, 0, 0, "imgfadedl");
+	ShowImage (imgfadedl, 0, 0, PLAIN ("imgfadedl"));
 
 	/*** popup ***/
-	ShowImage (imgpopup, 83, 11, "imgpopup");
+	ShowImage (imgpopup, 83, 11, PLAIN ("imgpopup"));
 
 	/*** OK ***/
 	switch (iOKOn)
 	{
-		case 0: ShowImage (imgok[1], 440, 323, "imgok[1]"); break; /*** off ***/
-		case 1: ShowImage (imgok[2], 440, 323, "imgok[2]"); break; /*** on ***/
+		case 0: /*** off ***/
+			ShowImage (imgok[1], 440, 323,
+				PLAIN ("imgok[1]")); break;
+		case 1: /*** on ***/
+			ShowImage (imgok[2], 440, 323,
+				PLAIN ("imgok[2]")); break;
 	}
 
 	snprintf (arText[0], MAX_TEXT, "%s %s", EDITOR_NAME, EDITOR_VERSION);
@@ -4669,13 +4303,17 @@ void ShowHelp (void)
 /*****************************************************************************/
 {
 	/*** background ***/
-	ShowImage (imghelp, 0, 0, "imghelp");
+	ShowImage (imghelp, 0, 0, PLAIN ("imghelp"));
 
 	/*** OK ***/
 	switch (iHelpOK)
 	{
-		case 0: ShowImage (imgok[1], 590, 417, "imgok[1]"); break; /*** off ***/
-		case 1: ShowImage (imgok[2], 590, 417, "imgok[2]"); break; /*** on ***/
+		case 0: /*** off ***/
+			ShowImage (imgok[1], 590, 417,
+				PLAIN ("imgok[1]")); break;
+		case 1: /*** on ***/
+			ShowImage (imgok[2], 590, 417,
+				PLAIN ("imgok[2]")); break;
 	}
 
 	/*** refresh screen ***/
@@ -4800,15 +4438,15 @@ void ShowEXE (void)
 	SDL_Color clr;
 
 	/*** background ***/
-	ShowImage (imgexe, 0, 0, "imgexe");
+	ShowImage (imgexe, 0, 0, PLAIN ("imgexe"));
 
 	/*** save button ***/
 	switch (iEXESave)
 	{
 		case 0: /*** off ***/
-			ShowImage (imgsave[1], 590, 417, "imgsave[1]"); break;
+			ShowImage (imgsave[1], 590, 417, PLAIN ("imgsave[1]")); break;
 		case 1: /*** on ***/
-			ShowImage (imgsave[2], 590, 417, "imgsave[2]"); break;
+			ShowImage (imgsave[2], 590, 417, PLAIN ("imgsave[2]")); break;
 	}
 
 	/*** Starting minutes. ***/
@@ -4926,8 +4564,8 @@ void InitScreenAction (char *sAction)
 	{
 		switch (arLevelType[iCurLevel])
 		{
-			case 0: arLevelType[iCurLevel] = 1; break;
-			case 1: arLevelType[iCurLevel] = 0; break;
+			case 0: SetLevelValue (&arLevelType[iCurLevel], 1); break;
+			case 1: SetLevelValue (&arLevelType[iCurLevel], 0); break;
 		}
 		PlaySound ("wav/extras.wav");
 		iChanged++;
@@ -5079,30 +4717,63 @@ void ClearRoom (int iRoomX, int iRoomY)
 /*****************************************************************************/
 {
 	int iX, iY;
+	int iObject;
 	int iHasGuard;
 
 	/*** Used for looping. ***/
 	int iXLoop, iYLoop;
 
-	/*** Remove tiles and guard(s). ***/
+	/*** Remove the attributes of objects, and guard(s). ***/
+	BeginEdits();
 	for (iXLoop = 1; iXLoop <= WIDTH; iXLoop++)
 	{
 		for (iYLoop = 1; iYLoop <= HEIGHT; iYLoop++)
 		{
 			iX = iXLoop + ((iRoomX - 1) * WIDTH);
 			iY = iYLoop + ((iRoomY - 1) * HEIGHT);
-			SetLocation (iX, iY, 0x00, 0x00);
+
+			/*** object, as SetLocation() would ***/
+			iObject = GetTileObject (iCurLevel, iX, iY);
+			if ((iObject >= 0x03) && (iObject <= NR_TYPES) &&
+				(arTypes[iObject].iWords != 0))
+			{
+				AddRemoveAttributes (iObject, iX, iY, 0);
+			}
+			if (iObject == 0x0B) { SetTileObject (iCurLevel, iX, iY, 0x00); }
 
 			/*** guard ***/
-			iHasGuard = HasObject (iX, iY, arGuardX[iCurLevel],
-				arGuardY[iCurLevel], arNrGuards[iCurLevel]);
+			iHasGuard = HasObject (iX, iY, 0x0C);
 			if (iHasGuard == 1)
 			{
-				AddRemoveAttributes (0x0C, iX, iY, arNrGuards,
-					arGuardX[iCurLevel], arGuardY[iCurLevel], 0);
+				AddRemoveAttributes (0x0C, iX, iY, 0);
 			}
 		}
 	}
+	EndEdits();
+
+	/*** Remove the tiles; LevelResized() may pass rooms outside them. ***/
+	if ((iRoomX * WIDTH <= arLevelTiles[iCurLevel].iWidth) &&
+		(iRoomY * HEIGHT <= arLevelTiles[iCurLevel].iHeight))
+	{
+		for (iXLoop = 1; iXLoop <= WIDTH; iXLoop++)
+		{
+			for (iYLoop = 1; iYLoop <= HEIGHT; iYLoop++)
+			{
+				iX = iXLoop + ((iRoomX - 1) * WIDTH);
+				iY = iYLoop + ((iRoomY - 1) * HEIGHT);
+				JournalTile (CHANGE_OBJECT, iCurLevel, iX, iY,
+					GetTileObject (iCurLevel, iX, iY), 0x00);
+				JournalTile (CHANGE_GRAPHICS, iCurLevel, iX, iY,
+					GetTileGraphics (iCurLevel, iX, iY), 0x00);
+			}
+		}
+		KeepRoom (iCurLevel, (RoomObjects (iCurLevel, iRoomX, iRoomY) -
+			arLevelTiles[iCurLevel].sObjects) / TILES);
+		memset (RoomObjects (iCurLevel, iRoomX, iRoomY), 0x00, TILES);
+		memset (RoomGraphics (iCurLevel, iRoomX, iRoomY), 0x00, TILES);
+	}
+	iLastObject = 0x00;
+	iLastGraphics = 0x00;
 
 	/*** No PlaySound() or iChanged++ here. ***/
 }
@@ -5140,11 +4811,13 @@ void UseTile (int iTile, int iX, int iY)
 				(arLevelStartingX[iCurLevel] != iCurX) ||
 				(arLevelStartingY[iCurLevel] != iCurY))
 			{
-				arPrinceDir[iCurLevel] = 0x800;
-				arPrinceX[iCurLevel] = ((iCurX - 1) * WIDTH) + iSelectedX;
-				arPrinceY[iCurLevel] = ((iCurY - 1) * HEIGHT) + iSelectedY;
-				arLevelStartingX[iCurLevel] = iCurX;
-				arLevelStartingY[iCurLevel] = iCurY;
+				SetLevelValue (&arPrinceDir[iCurLevel], 0x800);
+				SetLevelValue (&arPrinceX[iCurLevel],
+					((iCurX - 1) * WIDTH) + iSelectedX);
+				SetLevelValue (&arPrinceY[iCurLevel],
+					((iCurY - 1) * HEIGHT) + iSelectedY);
+				SetLevelValue (&arLevelStartingX[iCurLevel], iCurX);
+				SetLevelValue (&arLevelStartingY[iCurLevel], iCurY);
 				PlaySound ("wav/hum_adj.wav");
 			}
 			break;
@@ -5155,11 +4828,13 @@ void UseTile (int iTile, int iX, int iY)
 				(arLevelStartingX[iCurLevel] != iCurX) ||
 				(arLevelStartingY[iCurLevel] != iCurY))
 			{
-				arPrinceDir[iCurLevel] = 0x00;
-				arPrinceX[iCurLevel] = ((iCurX - 1) * WIDTH) + iSelectedX;
-				arPrinceY[iCurLevel] = ((iCurY - 1) * HEIGHT) + iSelectedY;
-				arLevelStartingX[iCurLevel] = iCurX;
-				arLevelStartingY[iCurLevel] = iCurY;
+				SetLevelValue (&arPrinceDir[iCurLevel], 0x00);
+				SetLevelValue (&arPrinceX[iCurLevel],
+					((iCurX - 1) * WIDTH) + iSelectedX);
+				SetLevelValue (&arPrinceY[iCurLevel],
+					((iCurY - 1) * HEIGHT) + iSelectedY);
+				SetLevelValue (&arLevelStartingX[iCurLevel], iCurX);
+				SetLevelValue (&arLevelStartingY[iCurLevel], iCurY);
 				PlaySound ("wav/hum_adj.wav");
 			}
 			break;
@@ -5175,59 +4850,42 @@ void UseTile (int iTile, int iX, int iY)
 		switch (iNewObject)
 		{
 			case 0x03: /*** raise ***/
-				SetAttribute (iX, iY, arRaiseX[iCurLevel], arRaiseY[iCurLevel],
-					arRaiseGate1[iCurLevel], arNrRaise[iCurLevel], iRaiseGate1);
-				SetAttribute (iX, iY, arRaiseX[iCurLevel], arRaiseY[iCurLevel],
-					arRaiseGate2[iCurLevel], arNrRaise[iCurLevel], iRaiseGate2);
-				SetAttribute (iX, iY, arRaiseX[iCurLevel], arRaiseY[iCurLevel],
-					arRaiseGate3[iCurLevel], arNrRaise[iCurLevel], iRaiseGate3);
+				SetAttribute (iX, iY, 0x03, BUTTON_GATE1, iRaiseGate1);
+				SetAttribute (iX, iY, 0x03, BUTTON_GATE2, iRaiseGate2);
+				SetAttribute (iX, iY, 0x03, BUTTON_GATE3, iRaiseGate3);
 				break;
 			case 0x04: /*** drop ***/
-				SetAttribute (iX, iY, arDropX[iCurLevel], arDropY[iCurLevel],
-					arDropGate1[iCurLevel], arNrDrop[iCurLevel], iDropGate1);
-				SetAttribute (iX, iY, arDropX[iCurLevel], arDropY[iCurLevel],
-					arDropGate2[iCurLevel], arNrDrop[iCurLevel], iDropGate2);
-				SetAttribute (iX, iY, arDropX[iCurLevel], arDropY[iCurLevel],
-					arDropGate3[iCurLevel], arNrDrop[iCurLevel], iDropGate3);
+				SetAttribute (iX, iY, 0x04, BUTTON_GATE1, iDropGate1);
+				SetAttribute (iX, iY, 0x04, BUTTON_GATE2, iDropGate2);
+				SetAttribute (iX, iY, 0x04, BUTTON_GATE3, iDropGate3);
 				break;
 			case 0x05: /*** gate ***/
 				iS3 = iGateDelay * 257; /*** Because 255 * 257 = 0xFFFF. ***/
-				SetAttribute (iX, iY, arGateX[iCurLevel], arGateY[iCurLevel],
-					arGateState1[iCurLevel], arNrGates[iCurLevel], iGateState);
-				SetAttribute (iX, iY, arGateX[iCurLevel], arGateY[iCurLevel],
-					arGateState2[iCurLevel], arNrGates[iCurLevel], iGateOpenness);
-				SetAttribute (iX, iY, arGateX[iCurLevel], arGateY[iCurLevel],
-					arGateState3[iCurLevel], arNrGates[iCurLevel], iS3);
+				SetAttribute (iX, iY, 0x05, GATE_STATE1, iGateState);
+				SetAttribute (iX, iY, 0x05, GATE_STATE2, iGateOpenness);
+				SetAttribute (iX, iY, 0x05, GATE_STATE3, iS3);
 				break;
 			case 0x09: /*** potion ***/
-				SetAttribute (iX, iY, arPotionX[iCurLevel], arPotionY[iCurLevel],
-					arPotionColor[iCurLevel], arNrPotions[iCurLevel], iPotionColor);
-				SetAttribute (iX, iY, arPotionX[iCurLevel], arPotionY[iCurLevel],
-					arPotionEffect[iCurLevel], arNrPotions[iCurLevel], iPotionEffect);
+				SetAttribute (iX, iY, 0x09, POTION_COLOR, iPotionColor);
+				SetAttribute (iX, iY, 0x09, POTION_EFFECT, iPotionEffect);
 				break;
 			case 0x0A: /*** door ***/
-				SetAttribute (iX, iY, arDoorX[iCurLevel], arDoorY[iCurLevel],
-					arDoorType[iCurLevel], arNrDoors[iCurLevel], iDoorType);
+				SetAttribute (iX, iY, 0x0A, DOOR_TYPE, iDoorType);
 				break;
 		}
 	}
 
 	if (iGuard == 1)
 	{
-		if (HasObject (iX, iY, arGuardX[iCurLevel], arGuardY[iCurLevel],
-			arNrGuards[iCurLevel]) == 1)
+		if (HasObject (iX, iY, 0x0C) == 1)
 		{
-			iOldDir = GetAttribute (iX, iY, arGuardX[iCurLevel], arGuardY[iCurLevel],
-				arGuardDir[iCurLevel], arNrGuards[iCurLevel]);
-			iOldType = GetAttribute (iX, iY, arGuardX[iCurLevel], arGuardY[iCurLevel],
-				arGuardType[iCurLevel], arNrGuards[iCurLevel]);
+			iOldDir = GetAttribute (iX, iY, 0x0C, GUARD_DIR);
+			iOldType = GetAttribute (iX, iY, 0x0C, GUARD_TYPE);
 			if ((iOldDir == iNewDir) && (iOldType == iNewType))
 			{
-				AddRemoveAttributes (0x0C, iX, iY, arNrGuards,
-					arGuardX[iCurLevel], arGuardY[iCurLevel], 0);
+				AddRemoveAttributes (0x0C, iX, iY, 0);
 			} else {
-				AddRemoveAttributes (0x0C, iX, iY, arNrGuards,
-					arGuardX[iCurLevel], arGuardY[iCurLevel], 0);
+				AddRemoveAttributes (0x0C, iX, iY, 0);
 				iGuardAdd = 1;
 			}
 		} else {
@@ -5238,18 +4896,12 @@ void UseTile (int iTile, int iX, int iY)
 	/*** Add a guard and set his attributes. ***/
 	if (iGuardAdd == 1)
 	{
-		AddRemoveAttributes (0x0C, iX, iY, arNrGuards,
-			arGuardX[iCurLevel], arGuardY[iCurLevel], 1);
-		SetAttribute (iX, iY, arGuardX[iCurLevel], arGuardY[iCurLevel],
-			arGuardDir[iCurLevel], arNrGuards[iCurLevel], iNewDir);
-		SetAttribute (iX, iY, arGuardX[iCurLevel], arGuardY[iCurLevel],
-			arGuardSprite[iCurLevel], arNrGuards[iCurLevel], GuardSprite (iNewType));
-		SetAttribute (iX, iY, arGuardX[iCurLevel], arGuardY[iCurLevel],
-			arGuardType[iCurLevel], arNrGuards[iCurLevel], iNewType);
-		SetAttribute (iX, iY, arGuardX[iCurLevel], arGuardY[iCurLevel],
-			arGuardSkill[iCurLevel], arNrGuards[iCurLevel], iNewSkill);
-		SetAttribute (iX, iY, arGuardX[iCurLevel], arGuardY[iCurLevel],
-			arGuardHP[iCurLevel], arNrGuards[iCurLevel], iNewHP);
+		AddRemoveAttributes (0x0C, iX, iY, 1);
+		SetAttribute (iX, iY, 0x0C, GUARD_DIR, iNewDir);
+		SetAttribute (iX, iY, 0x0C, GUARD_SPRITE, GuardSprite (iNewType));
+		SetAttribute (iX, iY, 0x0C, GUARD_TYPE, iNewType);
+		SetAttribute (iX, iY, 0x0C, GUARD_SKILL, iNewSkill);
+		SetAttribute (iX, iY, 0x0C, GUARD_HP, iNewHP);
 		PlaySound ("wav/hum_adj.wav");
 	}
 }
@@ -5308,11 +4960,15 @@ void Prev (int iDiscard)
 {
 	if (iCurLevel != 1)
 	{
-		iCurLevel--;
 		if (iDiscard == 1)
 		{
-			LoadLevels(); iChanged = 0;
+			DiscardChanges();
+		} else if (iChanged != 0) {
+			/*** Kept, so a later discard must reload this level too. ***/
+			arLevelChanged[iCurLevel] = 1;
 		}
+		ClearChanges();
+		iCurLevel--;
 		iCurX = arLevelStartingX[iCurLevel];
 		iCurY = arLevelStartingY[iCurLevel];
 		PlaySound ("wav/level_change.wav");
@@ -5324,11 +4980,15 @@ void Next (int iDiscard)
 {
 	if (iCurLevel != iNrLevels)
 	{
-		iCurLevel++;
 		if (iDiscard == 1)
 		{
-			LoadLevels(); iChanged = 0;
+			DiscardChanges();
+		} else if (iChanged != 0) {
+			/*** Kept, so a later discard must reload this level too. ***/
+			arLevelChanged[iCurLevel] = 1;
 		}
+		ClearChanges();
+		iCurLevel++;
 		iCurX = arLevelStartingX[iCurLevel];
 		iCurY = arLevelStartingY[iCurLevel];
 		PlaySound ("wav/level_change.wav");
@@ -5341,7 +5001,11 @@ void CallSave (void)
 	if (IsSavingAllowed() == 1)
 	{
 		CreateBAK();
-		SaveLevels();
+		if (SaveLevels() == 0)
+		{
+			SDL_ShowSimpleMessageBox (SDL_MESSAGEBOX_ERROR, "Error",
+				"Could not save the levels. Your changes were kept.", NULL);
+		}
 	} else {
 		if (iScreen != 3)
 		{
@@ -5357,10 +5021,10 @@ void SetLocation (int iX, int iY, int iObject, int iGraphics)
 	int iObjectOld;
 
 	/*** Remember the old object. ***/
-	iObjectOld = arLevelObjects[iCurLevel][iX][iY];
+	iObjectOld = GetTileObject (iCurLevel, iX, iY);
 
 	/*** Object. ***/
-	arLevelObjects[iCurLevel][iX][iY] = iObject;
+	SetTileObject (iCurLevel, iX, iY, iObject);
 	iLastObject = iObject;
 
 	/*** Remove all other swords. ***/
@@ -5370,104 +5034,73 @@ void SetLocation (int iX, int iY, int iObject, int iGraphics)
 	switch (iObjectOld)
 	{
 		case 0x03: /*** raise (buttons) ***/
-			AddRemoveAttributes (0x03, iX, iY, arNrRaise,
-				arRaiseX[iCurLevel], arRaiseY[iCurLevel], 0); break;
+			AddRemoveAttributes (0x03, iX, iY, 0); break;
 		case 0x04: /*** drop (buttons) ***/
-			AddRemoveAttributes (0x04, iX, iY, arNrDrop,
-				arDropX[iCurLevel], arDropY[iCurLevel], 0); break;
+			AddRemoveAttributes (0x04, iX, iY, 0); break;
 		case 0x05: /*** gates ***/
-			AddRemoveAttributes (0x05, iX, iY, arNrGates,
-				arGateX[iCurLevel], arGateY[iCurLevel], 0); break;
+			AddRemoveAttributes (0x05, iX, iY, 0); break;
 		case 0x06: /*** loose (floors) ***/
-			AddRemoveAttributes (0x06, iX, iY, arNrLoose,
-				arLooseX[iCurLevel], arLooseY[iCurLevel], 0); break;
+			AddRemoveAttributes (0x06, iX, iY, 0); break;
 		case 0x07: /*** spikes ***/
-			AddRemoveAttributes (0x07, iX, iY, arNrSpikes,
-				arSpikeX[iCurLevel], arSpikeY[iCurLevel], 0); break;
+			AddRemoveAttributes (0x07, iX, iY, 0); break;
 		case 0x08: /*** chompers ***/
-			AddRemoveAttributes (0x08, iX, iY, arNrChompers,
-				arChomperX[iCurLevel], arChomperY[iCurLevel], 0); break;
+			AddRemoveAttributes (0x08, iX, iY, 0); break;
 		case 0x09: /*** potions ***/
-			AddRemoveAttributes (0x09, iX, iY, arNrPotions,
-				arPotionX[iCurLevel], arPotionY[iCurLevel], 0); break;
+			AddRemoveAttributes (0x09, iX, iY, 0); break;
 		case 0x0A: /*** (level) doors ***/
-			AddRemoveAttributes (0x0A, iX, iY, arNrDoors,
-				arDoorX[iCurLevel], arDoorY[iCurLevel], 0); break;
+			AddRemoveAttributes (0x0A, iX, iY, 0); break;
 		case 0x0C: /*** guards ***/
-			AddRemoveAttributes (0x0C, iX, iY, arNrGuards,
-				arGuardX[iCurLevel], arGuardY[iCurLevel], 0); break;
+			AddRemoveAttributes (0x0C, iX, iY, 0); break;
 	}
 
 	/*** If necessary, add the new object's (X and Y) attributes. ***/
 	switch (iObject)
 	{
 		case 0x03: /*** raise (buttons) ***/
-			AddRemoveAttributes (0x03, iX, iY, arNrRaise,
-				arRaiseX[iCurLevel], arRaiseY[iCurLevel], 1); break;
+			AddRemoveAttributes (0x03, iX, iY, 1); break;
 		case 0x04: /*** drop (buttons) ***/
-			AddRemoveAttributes (0x04, iX, iY, arNrDrop,
-				arDropX[iCurLevel], arDropY[iCurLevel], 1); break;
+			AddRemoveAttributes (0x04, iX, iY, 1); break;
 		case 0x05: /*** gates ***/
-			AddRemoveAttributes (0x05, iX, iY, arNrGates,
-				arGateX[iCurLevel], arGateY[iCurLevel], 1); break;
+			AddRemoveAttributes (0x05, iX, iY, 1); break;
 		case 0x06: /*** loose (floors) ***/
-			AddRemoveAttributes (0x06, iX, iY, arNrLoose,
-				arLooseX[iCurLevel], arLooseY[iCurLevel], 1); break;
+			AddRemoveAttributes (0x06, iX, iY, 1); break;
 		case 0x07: /*** spikes ***/
-			AddRemoveAttributes (0x07, iX, iY, arNrSpikes,
-				arSpikeX[iCurLevel], arSpikeY[iCurLevel], 1); break;
+			AddRemoveAttributes (0x07, iX, iY, 1); break;
 		case 0x08: /*** chompers ***/
-			AddRemoveAttributes (0x08, iX, iY, arNrChompers,
-				arChomperX[iCurLevel], arChomperY[iCurLevel], 1); break;
+			AddRemoveAttributes (0x08, iX, iY, 1); break;
 		case 0x09: /*** potions ***/
-			AddRemoveAttributes (0x09, iX, iY, arNrPotions,
-				arPotionX[iCurLevel], arPotionY[iCurLevel], 1); break;
+			AddRemoveAttributes (0x09, iX, iY, 1); break;
 		case 0x0A: /*** (level) doors ***/
-			AddRemoveAttributes (0x0A, iX, iY, arNrDoors,
-				arDoorX[iCurLevel], arDoorY[iCurLevel], 1); break;
+			AddRemoveAttributes (0x0A, iX, iY, 1); break;
 		case 0x0C: /*** guards ***/
-			AddRemoveAttributes (0x0C, iX, iY, arNrGuards,
-				arGuardX[iCurLevel], arGuardY[iCurLevel], 1); break;
+			AddRemoveAttributes (0x0C, iX, iY, 1); break;
 	}
 
 	/*** Graphics. ***/
 	if (iGraphics != -1)
 	{
-		arLevelGraphics[iCurLevel][iX][iY] = iGraphics;
+		SetTileGraphics (iCurLevel, iX, iY, iGraphics);
 		iLastGraphics = iGraphics;
 	} else {
-		iLastGraphics = arLevelGraphics[iCurLevel][iX][iY];
+		iLastGraphics = GetTileGraphics (iCurLevel, iX, iY);
 	}
 }
 /*****************************************************************************/
-void SetAttribute (int iX, int iY, int *arX, int *arY, int *arAttr,
-	int iNrObjects, int iValue)
+void SetAttribute (int iX, int iY, int iObject, int iField, int iValue)
 /*****************************************************************************/
 {
-	/*** Used for looping. ***/
-	int iObjectLoop;
+	int iNr;
 
-	for (iObjectLoop = 1; iObjectLoop <= iNrObjects; iObjectLoop++)
-	{
-		if ((arX[iObjectLoop] == iX) && (arY[iObjectLoop] == iY))
-		{
-			arAttr[iObjectLoop] = iValue;
-		}
-	}
+	iNr = FindObject (iCurLevel, iObject, iX, iY);
+	if (iNr != 0) { SetField (iCurLevel, iObject, iNr, iField, iValue); }
 }
 /*****************************************************************************/
-int HasObject (int iX, int iY, int *arX, int *arY, int iNrObjects)
+int HasObject (int iX, int iY, int iObject)
 /*****************************************************************************/
 {
-	/*** Used for looping. ***/
-	int iObjectLoop;
-
-	for (iObjectLoop = 1; iObjectLoop <= iNrObjects; iObjectLoop++)
+	if (FindObject (iCurLevel, iObject, iX, iY) != 0)
 	{
-		if ((arX[iObjectLoop] == iX) && (arY[iObjectLoop] == iY))
-		{
-			return (1);
-		}
+		return (1);
 	}
 
 	return (0);
@@ -5517,20 +5150,20 @@ void ChangePos (void)
 	/* Store old values. Used for custom tile creation and showing
 	 * the new image of the object and graphics combo.
 	 */
-	iNewObject = arLevelObjects[iCurLevel]
-		[((iCurX - 1) * WIDTH) + iSelectedX][((iCurY - 1) * HEIGHT) + iSelectedY];
-	iNewGraphics = arLevelGraphics[iCurLevel]
-		[((iCurX - 1) * WIDTH) + iSelectedX][((iCurY - 1) * HEIGHT) + iSelectedY];
+	iNewObject = GetTileObject (iCurLevel,
+		((iCurX - 1) * WIDTH) + iSelectedX, ((iCurY - 1) * HEIGHT) + iSelectedY);
+	iNewGraphics = GetTileGraphics (iCurLevel,
+		((iCurX - 1) * WIDTH) + iSelectedX, ((iCurY - 1) * HEIGHT) + iSelectedY);
 	iNewXLeft = ((iCurX - 1) * WIDTH) + iSelectedX - 1;
 	if (iNewXLeft < 1)
 	{
 		iNewObjectLeft = 0x01; /*** wall ***/
 		iNewGraphicsLeft = 0x00; /*** black ***/
 	} else {
-		iNewObjectLeft = arLevelObjects[iCurLevel]
-			[iNewXLeft][((iCurY - 1) * HEIGHT) + iSelectedY];
-		iNewGraphicsLeft = arLevelGraphics[iCurLevel]
-			[iNewXLeft][((iCurY - 1) * HEIGHT) + iSelectedY];
+		iNewObjectLeft = GetTileObject (iCurLevel,
+			iNewXLeft, ((iCurY - 1) * HEIGHT) + iSelectedY);
+		iNewGraphicsLeft = GetTileGraphics (iCurLevel,
+			iNewXLeft, ((iCurY - 1) * HEIGHT) + iSelectedY);
 	}
 	iNewXRight = ((iCurX - 1) * WIDTH) + iSelectedX + 1;
 	if (iNewXRight > (arLevelWidth[iCurLevel] * WIDTH))
@@ -5538,10 +5171,10 @@ void ChangePos (void)
 		iNewObjectRight = 0x01; /*** wall ***/
 		iNewGraphicsRight = 0x00; /*** black ***/
 	} else {
-		iNewObjectRight = arLevelObjects[iCurLevel]
-			[iNewXRight][((iCurY - 1) * HEIGHT) + iSelectedY];
-		iNewGraphicsRight = arLevelGraphics[iCurLevel]
-			[iNewXRight][((iCurY - 1) * HEIGHT) + iSelectedY];
+		iNewObjectRight = GetTileObject (iCurLevel,
+			iNewXRight, ((iCurY - 1) * HEIGHT) + iSelectedY);
+		iNewGraphicsRight = GetTileGraphics (iCurLevel,
+			iNewXRight, ((iCurY - 1) * HEIGHT) + iSelectedY);
 	}
 
 	/*** Old graphics. ***/
@@ -5571,9 +5204,7 @@ void ChangePos (void)
 	switch (iNewObject)
 	{
 		case 0x03: /*** raise ***/
-			iRaiseGate1 = GetSelectedTileValue (arRaiseGate1[iCurLevel],
-				arRaiseX[iCurLevel], arRaiseY[iCurLevel],
-				arNrRaise[iCurLevel], 0);
+			iRaiseGate1 = GetSelectedTileValue (0x03, BUTTON_GATE1, 0);
 			switch (iRaiseGate1)
 			{
 				case 0xFFFD: iRaiseGate1Check = 0xFFFD; break; /*** none ***/
@@ -5581,9 +5212,7 @@ void ChangePos (void)
 				case 0xFFFF: iRaiseGate1Check = 0xFFFF; break; /*** exit ***/
 				default: iRaiseGate1Check = -1; break; /*** gate no ***/
 			}
-			iRaiseGate2 = GetSelectedTileValue (arRaiseGate2[iCurLevel],
-				arRaiseX[iCurLevel], arRaiseY[iCurLevel],
-				arNrRaise[iCurLevel], 0xFFFD);
+			iRaiseGate2 = GetSelectedTileValue (0x03, BUTTON_GATE2, 0xFFFD);
 			switch (iRaiseGate2)
 			{
 				case 0xFFFD: iRaiseGate2Check = 0xFFFD; break; /*** none ***/
@@ -5591,9 +5220,7 @@ void ChangePos (void)
 				case 0xFFFF: iRaiseGate2Check = 0xFFFF; break; /*** exit ***/
 				default: iRaiseGate2Check = -1; break; /*** gate no ***/
 			}
-			iRaiseGate3 = GetSelectedTileValue (arRaiseGate3[iCurLevel],
-				arRaiseX[iCurLevel], arRaiseY[iCurLevel],
-				arNrRaise[iCurLevel], 0xFFFD);
+			iRaiseGate3 = GetSelectedTileValue (0x03, BUTTON_GATE3, 0xFFFD);
 			switch (iRaiseGate3)
 			{
 				case 0xFFFD: iRaiseGate3Check = 0xFFFD; break; /*** none ***/
@@ -5603,9 +5230,7 @@ void ChangePos (void)
 			}
 			break;
 		case 0x04: /*** drop ***/
-			iDropGate1 = GetSelectedTileValue (arDropGate1[iCurLevel],
-				arDropX[iCurLevel], arDropY[iCurLevel],
-				arNrDrop[iCurLevel], 0);
+			iDropGate1 = GetSelectedTileValue (0x04, BUTTON_GATE1, 0);
 			switch (iDropGate1)
 			{
 				case 0xFFFD: iDropGate1Check = 0xFFFD; break; /*** none ***/
@@ -5613,9 +5238,7 @@ void ChangePos (void)
 				case 0xFFFF: iDropGate1Check = 0xFFFF; break; /*** exit ***/
 				default: iDropGate1Check = -1; break; /*** gate no ***/
 			}
-			iDropGate2 = GetSelectedTileValue (arDropGate2[iCurLevel],
-				arDropX[iCurLevel], arDropY[iCurLevel],
-				arNrDrop[iCurLevel], 0xFFFD);
+			iDropGate2 = GetSelectedTileValue (0x04, BUTTON_GATE2, 0xFFFD);
 			switch (iDropGate2)
 			{
 				case 0xFFFD: iDropGate2Check = 0xFFFD; break; /*** none ***/
@@ -5623,9 +5246,7 @@ void ChangePos (void)
 				case 0xFFFF: iDropGate2Check = 0xFFFF; break; /*** exit ***/
 				default: iDropGate2Check = -1; break; /*** gate no ***/
 			}
-			iDropGate3 = GetSelectedTileValue (arDropGate3[iCurLevel],
-				arDropX[iCurLevel], arDropY[iCurLevel],
-				arNrDrop[iCurLevel], 0xFFFD);
+			iDropGate3 = GetSelectedTileValue (0x04, BUTTON_GATE3, 0xFFFD);
 			switch (iDropGate3)
 			{
 				case 0xFFFD: iDropGate3Check = 0xFFFD; break; /*** none ***/
@@ -5635,15 +5256,9 @@ void ChangePos (void)
 			}
 			break;
 		case 0x05: /*** gate ***/
-			iS1 = GetSelectedTileValue (arGateState1[iCurLevel],
-				arGateX[iCurLevel], arGateY[iCurLevel],
-				arNrGates[iCurLevel], 0);
-			iS2 = GetSelectedTileValue (arGateState2[iCurLevel],
-				arGateX[iCurLevel], arGateY[iCurLevel],
-				arNrGates[iCurLevel], 0);
-			iS3 = GetSelectedTileValue (arGateState3[iCurLevel],
-				arGateX[iCurLevel], arGateY[iCurLevel],
-				arNrGates[iCurLevel], 0);
+			iS1 = GetSelectedTileValue (0x05, GATE_STATE1, 0);
+			iS2 = GetSelectedTileValue (0x05, GATE_STATE2, 0);
+			iS3 = GetSelectedTileValue (0x05, GATE_STATE3, 0);
 			iS3 = iS3 / 257; /*** Because 0xFFFF / 257 = 255. ***/
 			if ((iS1 == 0) && (iS2 == 0) && (iS3 == 0)) /*** closed ***/
 			{
@@ -5680,18 +5295,14 @@ void ChangePos (void)
 			iGateDelay = iS3;
 			break;
 		case 0x09: /*** potion ***/
-			iPotionColor = GetSelectedTileValue (arPotionColor[iCurLevel],
-				arPotionX[iCurLevel], arPotionY[iCurLevel],
-				arNrPotions[iCurLevel], 1);
+			iPotionColor = GetSelectedTileValue (0x09, POTION_COLOR, 1);
 			switch (iPotionColor)
 			{
 				case 1: iPotionColorCheck = 1; break; /*** red ***/
 				case 3: iPotionColorCheck = 3; break; /*** green ***/
 				default: iPotionColorCheck = 10; break; /*** color no ***/
 			}
-			iPotionEffect = GetSelectedTileValue (arPotionEffect[iCurLevel],
-				arPotionX[iCurLevel], arPotionY[iCurLevel],
-				arNrPotions[iCurLevel], 0);
+			iPotionEffect = GetSelectedTileValue (0x09, POTION_EFFECT, 0);
 			switch (iPotionEffect)
 			{
 				case 0: iPotionEffectCheck = 0; break; /*** heal ***/
@@ -5708,9 +5319,7 @@ void ChangePos (void)
 			}
 			break;
 		case 0x0A: /*** door ***/
-			iDoorType = GetSelectedTileValue (arDoorType[iCurLevel],
-				arDoorX[iCurLevel], arDoorY[iCurLevel],
-				arNrDoors[iCurLevel], 0);
+			iDoorType = GetSelectedTileValue (0x0A, DOOR_TYPE, 0);
 			switch (iDoorType)
 			{
 				case 0: iDoorTypeCheck = 0; break; /*** entrance ***/
@@ -5720,12 +5329,8 @@ void ChangePos (void)
 	}
 
 	/*** Set the initial guard attributes. ***/
-	iNewSkill = GetSelectedTileValue (arGuardSkill[iCurLevel],
-		arGuardX[iCurLevel], arGuardY[iCurLevel],
-		arNrGuards[iCurLevel], 0);
-	iNewHP = GetSelectedTileValue (arGuardHP[iCurLevel],
-		arGuardX[iCurLevel], arGuardY[iCurLevel],
-		arNrGuards[iCurLevel], 3);
+	iNewSkill = GetSelectedTileValue (0x0C, GUARD_SKILL, 0);
+	iNewHP = GetSelectedTileValue (0x0C, GUARD_HP, 3);
 
 	ShowChange();
 	while (iChanging == 1)
@@ -5865,6 +5470,7 @@ void ChangePos (void)
 							{
 								if ((iOnTile >= 1) && (iOnTile <= 30))
 								{
+									BeginEdits();
 									for (iXLoop = 1; iXLoop <= arLevelWidth[iCurLevel]
 										* WIDTH; iXLoop++)
 									{
@@ -5874,12 +5480,14 @@ void ChangePos (void)
 											UseTile (iOnTile, iXLoop, iYLoop);
 										}
 									}
+									EndEdits();
 									iChanging = 0;
 									iChanged++;
 								}
 							} else if (event.key.keysym.mod & KMOD_SHIFT) {
 								if ((iOnTile >= 1) && (iOnTile <= 30))
 								{
+									BeginEdits();
 									for (iXLoop = 1; iXLoop <= WIDTH; iXLoop++)
 									{
 										for (iYLoop = 1; iYLoop <= HEIGHT; iYLoop++)
@@ -5888,6 +5496,7 @@ void ChangePos (void)
 												iYLoop + ((iCurY - 1) * HEIGHT));
 										}
 									}
+									EndEdits();
 									iChanging = 0;
 									iChanged++;
 								}
@@ -6470,6 +6079,7 @@ void ChangePos (void)
 					{
 						if ((iUseTile == 1) && (iOnTile != 0) && (iOnTile <= 30))
 						{
+							BeginEdits();
 							for (iXLoop = 1; iXLoop <= WIDTH; iXLoop++)
 							{
 								for (iYLoop = 1; iYLoop <= HEIGHT; iYLoop++)
@@ -6478,6 +6088,7 @@ void ChangePos (void)
 										iYLoop + ((iCurY - 1) * HEIGHT));
 								}
 							}
+							EndEdits();
 							iChanging = 0;
 							iChanged++;
 						}
@@ -6487,6 +6098,7 @@ void ChangePos (void)
 					{
 						if ((iUseTile == 1) && (iOnTile != 0) && (iOnTile <= 30))
 						{
+							BeginEdits();
 							for (iXLoop = 1; iXLoop <= arLevelWidth[iCurLevel]
 								* WIDTH; iXLoop++)
 							{
@@ -6496,6 +6108,7 @@ void ChangePos (void)
 									UseTile (iOnTile, iXLoop, iYLoop);
 								}
 							}
+							EndEdits();
 							iChanging = 0;
 							iChanged++;
 						}
@@ -6522,51 +6135,14 @@ void ChangePos (void)
 	PlaySound ("wav/ok_close.wav");
 }
 /*****************************************************************************/
-void ShowImage (SDL_Texture *img, int iX, int iY, char *sImageInfo)
+void ShowImage (SDL_Texture *img, int iX, int iY, struct imginfo *stInfo)
 /*****************************************************************************/
 {
 	SDL_Rect dest;
 	SDL_Rect loc;
 	int iWidth, iHeight;
-	int iInfoC;
 	char arText[9 + 2][MAX_TEXT + 2];
-	int iTileValue;
-	char sTileValue[MAX_OPTION + 2];
-	int iNoGraphics, iNoObject;
-
-	iNoGraphics = 0;
-	iNoObject = 0;
-	iInfoC = 0;
-
-	/*** Graphics ***/
-	if (strncmp (sImageInfo, "gra1=", 5) == 0)
-	{
-		GetOptionValue (sImageInfo, sTileValue);
-		iTileValue = atoi (sTileValue);
-		snprintf (arText[0], MAX_TEXT, "G:0x%02X", iTileValue);
-		snprintf (arText[1], MAX_TEXT, "%s", "");
-		if (imgd[iTileValue][1] == NULL) { iInfoC = 1; } /*** Custom tile. ***/
-	} else if (strncmp (sImageInfo, "gra2=", 5) == 0) {
-		GetOptionValue (sImageInfo, sTileValue);
-		iTileValue = atoi (sTileValue);
-	} else {
-		iNoGraphics = 1;
-	}
-
-	/*** Object ***/
-	if (strncmp (sImageInfo, "obj1=", 5) == 0)
-	{
-		GetOptionValue (sImageInfo, sTileValue);
-		iTileValue = atoi (sTileValue);
-		snprintf (arText[0], MAX_TEXT, "%s", "");
-		snprintf (arText[1], MAX_TEXT, "O:0x%02X", iTileValue);
-		if (imgo[iTileValue][1] == NULL) { iInfoC = 1; } /*** Custom tile. ***/
-	} else if (strncmp (sImageInfo, "obj2=", 5) == 0) {
-		GetOptionValue (sImageInfo, sTileValue);
-		iTileValue = atoi (sTileValue);
-	} else {
-		iNoObject = 1;
-	}
+	int iCustom;
 
 	SDL_QueryTexture (img, NULL, NULL, &iWidth, &iHeight);
 	loc.x = 0;
@@ -6577,11 +6153,21 @@ void ShowImage (SDL_Texture *img, int iX, int iY, char *sImageInfo)
 	dest.y = iY;
 	dest.w = iWidth;
 	dest.h = iHeight;
-	CustomRenderCopy (img, &loc, &dest, sImageInfo);
+	CustomRenderCopy (img, &loc, &dest, stInfo);
 
 	/*** Info ("i"). ***/
-	if (((iNoGraphics != 1) || (iNoObject != 1)) &&
-		((iInfo == 1) || (iInfoC == 1)))
+	if ((stInfo->iKind == INFO_IMAGE) || (stInfo->iLabel == 0)) { return; }
+	if (stInfo->iKind == INFO_GRAPHICS)
+	{
+		snprintf (arText[0], MAX_TEXT, "G:0x%02X", stInfo->iTile);
+		snprintf (arText[1], MAX_TEXT, "%s", "");
+		iCustom = (imgd[stInfo->iTile][1] == NULL) ? 1 : 0;
+	} else {
+		snprintf (arText[0], MAX_TEXT, "%s", "");
+		snprintf (arText[1], MAX_TEXT, "O:0x%02X", stInfo->iTile);
+		iCustom = (imgo[stInfo->iTile][1] == NULL) ? 1 : 0;
+	}
+	if ((iInfo == 1) || (iCustom == 1))
 	{
 		DisplayText (dest.x, dest.y + 108,
 			FONT_SIZE_11, arText, 2, font2, color_wh, color_bl);
@@ -6589,10 +6175,11 @@ void ShowImage (SDL_Texture *img, int iX, int iY, char *sImageInfo)
 }
 /*****************************************************************************/
 void CustomRenderCopy (SDL_Texture* src, SDL_Rect* srcrect,
-	SDL_Rect *dstrect, char *sImageInfo)
+	SDL_Rect *dstrect, struct imginfo *stInfo)
 /*****************************************************************************/
 {
 	SDL_Rect stuff;
+	struct draw stDraw;
 
 	stuff.x = dstrect->x * iScale;
 	stuff.y = dstrect->y * iScale;
@@ -6604,39 +6191,110 @@ void CustomRenderCopy (SDL_Texture* src, SDL_Rect* srcrect,
 		stuff.w = dstrect->w;
 		stuff.h = dstrect->h;
 	}
+	if (iRecording == 1)
+	{
+		memset (&stDraw, 0, sizeof (struct draw));
+		stDraw.iKind = DRAW_IMAGE;
+		stDraw.img = src;
+		if (srcrect != NULL) { stDraw.iSrc = 1; stDraw.src = *srcrect; }
+		stDraw.dst = stuff;
+		AddDraw (&stDraw);
+		return;
+	}
 	if (SDL_RenderCopy (ascreen, src, srcrect, &stuff) != 0)
 	{
+#ifndef NDEBUG
 		printf ("[ WARN ] SDL_RenderCopy (%s): %s!\n",
-			sImageInfo, SDL_GetError());
+			stInfo->sName, SDL_GetError());
+#else
+		printf ("[ WARN ] SDL_RenderCopy (%i, 0x%02X): %s!\n",
+			stInfo->iKind, stInfo->iTile, SDL_GetError());
+#endif
 	}
 }
 /*****************************************************************************/
 void CreateBAK (void)
 /*****************************************************************************/
 {
-	FILE *fDAT;
-	FILE *fBAK;
-	int iData;
+	/* Copies the ROM to a timestamped backup in ROM_DIR, unless its content
+	 * equals that of the newest backup. Only the newest iBackups backups are
+	 * kept.
+	 */
 
-	fDAT = fopen (sPathFile, "rb");
-	if (fDAT == NULL)
-		{ printf ("[FAILED] Could not open %s: %s!\n",
-			sPathFile, strerror (errno)); }
+	char (*arBackups)[MAX_PATHFILE + 2];
+	int iNrBackups;
+	char sBackup[MAX_PATHFILE + 2];
+	char sTime[MAX_TEXT + 2];
+	int iSame;
+	unsigned char *sData;
+	int iSize;
+	unsigned long iCRC;
+	time_t tNow;
 
-	fBAK = fopen (BACKUP, "wb");
-	if (fBAK == NULL)
-		{ printf ("[FAILED] Could not open %s: %s!\n",
-			BACKUP, strerror (errno)); }
+	/*** Used for looping. ***/
+	int iBackupLoop;
 
-	while (1)
+	if (iBackups == 0) { return; }
+
+	/*** The CRC of the ROM. ***/
+	iCRC = CRC32 (stROM.stPristine.sData, stROM.stPristine.iSize);
+
+	/*** The CRC of the newest backup. ***/
+	iNrBackups = ListBackups (&arBackups);
+	if ((iBAKCRCKnown == 0) && (iNrBackups > 0))
+	{
+		/*** An unreadable (e.g. truncated) backup just does not match. ***/
+		sData = ReadBuffer (arBackups[iNrBackups], &iSize);
+		if (sData != NULL)
+		{
+			iBAKCRC = CRC32 (sData, iSize);
+			free (sData);
+			iBAKCRCKnown = 1;
+		}
+	}
+	free (arBackups);
+	if ((iBAKCRCKnown == 1) && (iCRC == iBAKCRC))
 	{
-		iData = fgetc (fDAT);
-		if (iData == EOF) { break; }
-			else { putc (iData, fBAK); }
+		PrIfDe ("[ INFO ] The newest backup is identical to the ROM.\n");
+		return;
 	}
 
-	fclose (fDAT);
-	fclose (fBAK);
+	tNow = time (NULL);
+	strftime (sTime, MAX_TEXT, "%Y%m%d-%H%M%S", localtime (&tNow));
+	snprintf (sBackup, MAX_PATHFILE, "%s%s%s%s%s", ROM_DIR, SLASH,
+		BACKUP_PREFIX, sTime, BACKUP_SUFFIX);
+
+	/*** Saves within a second get a counter; "_" sorts after ".". ***/
+	iSame = 1;
+	while ((access (sBackup, F_OK) == 0) && (iSame < 99))
+	{
+		iSame++;
+		snprintf (sBackup, MAX_PATHFILE, "%s%s%s%s_%02i%s", ROM_DIR, SLASH,
+			BACKUP_PREFIX, sTime, iSame, BACKUP_SUFFIX);
+	}
+	if (access (sBackup, F_OK) == 0)
+	{
+		printf ("[ WARN ] Too many backups in one second!\n");
+		return;
+	}
+	if (DuplicateFile (sPathFile, sBackup) == 0) { return; }
+	iBAKCRC = iCRC;
+	iBAKCRCKnown = 1;
+	if (iDebug == 1)
+		{ printf ("[  OK  ] Created backup \"%s\".\n", sBackup); }
+
+	/*** Remove the oldest backups. ***/
+	iNrBackups = ListBackups (&arBackups);
+	for (iBackupLoop = 1; iBackupLoop <= iNrBackups - iBackups; iBackupLoop++)
+	{
+		unlink (arBackups[iBackupLoop]);
+		if (iDebug == 1)
+		{
+			printf ("[  OK  ] Removed backup \"%s\".\n",
+				arBackups[iBackupLoop]);
+		}
+	}
+	free (arBackups);
 }
 /*****************************************************************************/
 void DisplayText (int iStartX, int iStartY, int iFontSize,
@@ -6650,9 +6308,6 @@ void DisplayText (int iStartX, int iStartY, int iFontSize,
 	{
 		if (strcmp (arText[iTemp], "") != 0)
 		{
-			message = TTF_RenderText_Shaded (font,
-				arText[iTemp], fore, back);
-			messaget = SDL_CreateTextureFromSurface (ascreen, message);
 			if ((strcmp (arText[iTemp], "single tile (change or select)") == 0) ||
 				(strcmp (arText[iTemp], "entire room (clear or fill)") == 0) ||
 				(strcmp (arText[iTemp], "entire level (randomize or fill)") == 0))
@@ -6662,9 +6317,7 @@ void DisplayText (int iStartX, int iStartY, int iFontSize,
 				offset.x = iStartX;
 			}
 			offset.y = iStartY + (iTemp * (iFontSize + 4));
-			offset.w = message->w; offset.h = message->h;
-			CustomRenderCopy (messaget, NULL, &offset, "message");
-			SDL_DestroyTexture (messaget); SDL_FreeSurface (message);
+			ShowText (font, arText[iTemp], fore, back, 0, offset.x, offset.y);
 		}
 	}
 }
@@ -6694,72 +6347,74 @@ void ShowRoom (int iX, int iY)
 {
 	int iXBase, iYBase;
 	int iXLoop, iYLoop;
+	unsigned char *sObjects;
 	unsigned char cObject;
 
 	iXBase = 144 + ((iStartRoomsX + iX - 1) * ((10 * 2) + 1));
 	iYBase = 111 + ((iStartRoomsY + iY - 1) * ((3 * 4) + 1));
-	for (iXLoop = 1; iXLoop <= WIDTH; iXLoop++)
+	sObjects = RoomObjects (iCurLevel, iX, iY);
+	for (iYLoop = 1; iYLoop <= HEIGHT; iYLoop++)
 	{
-		for (iYLoop = 1; iYLoop <= HEIGHT; iYLoop++)
+		for (iXLoop = 1; iXLoop <= WIDTH; iXLoop++)
 		{
-			cObject = arLevelObjects[iCurLevel][((iX - 1) * WIDTH) + iXLoop]
-				[((iY - 1) * HEIGHT) + iYLoop];
+			cObject = *sObjects++;
 			if (cObject > 0x0B) { cObject = 0x0C; }
 			ShowImage (imgm[cObject], iXBase + ((iXLoop - 1) * 2),
-				iYBase + ((iYLoop - 1) * 4), "imgm[...]");
+				iYBase + ((iYLoop - 1) * 4), PLAIN ("imgm[...]"));
 		}
 	}
 
 	/*** prince room ***/
 	if ((iX == arLevelStartingX[iCurLevel]) &&
 		(iY == arLevelStartingY[iCurLevel]))
-		{ ShowImage (imgsrs, iXBase, iYBase, "imgsrs"); }
+		{ ShowImage (imgsrs, iXBase, iYBase, PLAIN ("imgsrs")); }
 
 	/*** current room ***/
 	if ((iX == iCurX) && (iY == iCurY))
-		{ ShowImage (imgsrc, iXBase, iYBase, "imgsrc"); }
+		{ ShowImage (imgsrc, iXBase, iYBase, PLAIN ("imgsrc")); }
 }
 /*****************************************************************************/
 void ShowChange (void)
 /*****************************************************************************/
 {
 	int iX, iY;
+	int iGuard;
 	int iGuardX;
-
-	/*** Used for looping. ***/
-	int iGuardLoop;
+	int iGuardType;
 
 	/*** Three preview graphics. ***/
 	switch (arLevelType[iCurLevel])
 	{
 		case 0:
 			ShowImage (imgd[iNewGraphicsLeft][1],
-				(0 * DD_X) + 6, 333, "imgd[...][1]");
+				(0 * DD_X) + 6, 333, PLAIN ("imgd[...][1]"));
 			ShowImage (imgd[iNewGraphics][1],
-				(1 * DD_X) + 6, 333, "imgd[...][1]");
+				(1 * DD_X) + 6, 333, PLAIN ("imgd[...][1]"));
 			ShowImage (imgd[iNewGraphicsRight][1],
-				(2 * DD_X) + 6, 333, "imgd[...][1]");
+				(2 * DD_X) + 6, 333, PLAIN ("imgd[...][1]"));
 			break;
 		case 1:
 			ShowImage (imgp[iNewGraphicsLeft][1],
-				(0 * DD_X) + 6, 333, "imgp[...][1]");
+				(0 * DD_X) + 6, 333, PLAIN ("imgp[...][1]"));
 			ShowImage (imgp[iNewGraphics][1],
-				(1 * DD_X) + 6, 333, "imgp[...][1]");
+				(1 * DD_X) + 6, 333, PLAIN ("imgp[...][1]"));
 			ShowImage (imgp[iNewGraphicsRight][1],
-				(2 * DD_X) + 6, 333, "imgp[...][1]");
+				(2 * DD_X) + 6, 333, PLAIN ("imgp[...][1]"));
 			break;
 	}
 
 	/*** Three preview objects. ***/
-	ShowImage (imgo[iNewObjectLeft][1], (0 * DD_X) + 6, 301, "imgo[...][1]");
-	ShowImage (imgo[iNewObject][1], (1 * DD_X) + 6, 301, "imgo[...][1]");
-	ShowImage (imgo[iNewObjectRight][1], (2 * DD_X) + 6, 301, "imgo[...][1]");
+	ShowImage (imgo[iNewObjectLeft][1], (0 * DD_X) + 6, 301,
+		PLAIN ("imgo[...][1]"));
+	ShowImage (imgo[iNewObject][1], (1 * DD_X) + 6, 301, PLAIN ("imgo[...][1]"));
+	ShowImage (imgo[iNewObjectRight][1], (2 * DD_X) + 6, 301,
+		PLAIN ("imgo[...][1]"));
 
 	/*** background ***/
-	ShowImage (imgtiles, 0, 0, "imgtiles");
+	ShowImage (imgtiles, 0, 0, PLAIN ("imgtiles"));
 
 	/*** Object tab. ***/
-	ShowImage (imgtabo[iTabObject], 24, 4, "imgtabo[...]");
+	ShowImage (imgtabo[iTabObject], 24, 4, PLAIN ("imgtabo[...]"));
 
 	/*** Object settings. ***/
 	iX = 0; iY = 0; /*** To prevent warnings. ***/
@@ -6774,7 +6429,7 @@ void ShowChange (void)
 				case 0xFFFF: iX = 155; iY = 98; break; /*** exit ***/
 				case -1: iX = 35; iY = 72; break; /*** gate no ***/
 			}
-			ShowImage (imgchkbl, iX, iY, "imgchkbl");
+			ShowImage (imgchkbl, iX, iY, PLAIN ("imgchkbl"));
 			CenterNumber (iRaiseGate1, 141, 69, color_bl, 0);
 			/*========== 2 ==========*/
 			switch (iRaiseGate2Check)
@@ -6784,7 +6439,7 @@ void ShowChange (void)
 				case 0xFFFF: iX = 364; iY = 98; break; /*** exit ***/
 				case -1: iX = 244; iY = 72; break; /*** gate no ***/
 			}
-			ShowImage (imgchkbl, iX, iY, "imgchkbl");
+			ShowImage (imgchkbl, iX, iY, PLAIN ("imgchkbl"));
 			CenterNumber (iRaiseGate2, 350, 69, color_bl, 0);
 			/*========== 3 ==========*/
 			switch (iRaiseGate3Check)
@@ -6794,7 +6449,7 @@ void ShowChange (void)
 				case 0xFFFF: iX = 573; iY = 98; break; /*** exit ***/
 				case -1: iX = 453; iY = 72; break; /*** gate no ***/
 			}
-			ShowImage (imgchkbl, iX, iY, "imgchkbl");
+			ShowImage (imgchkbl, iX, iY, PLAIN ("imgchkbl"));
 			CenterNumber (iRaiseGate3, 559, 69, color_bl, 0);
 			break;
 		case 0x04: /*** drop ***/
@@ -6806,7 +6461,7 @@ void ShowChange (void)
 				case 0xFFFF: iX = 155; iY = 98; break; /*** exit ***/
 				case -1: iX = 35; iY = 72; break; /*** gate no ***/
 			}
-			ShowImage (imgchkbl, iX, iY, "imgchkbl");
+			ShowImage (imgchkbl, iX, iY, PLAIN ("imgchkbl"));
 			CenterNumber (iDropGate1, 141, 69, color_bl, 0);
 			/*========== 2 ==========*/
 			switch (iDropGate2Check)
@@ -6816,7 +6471,7 @@ void ShowChange (void)
 				case 0xFFFF: iX = 364; iY = 98; break; /*** exit ***/
 				case -1: iX = 244; iY = 72; break; /*** gate no ***/
 			}
-			ShowImage (imgchkbl, iX, iY, "imgchkbl");
+			ShowImage (imgchkbl, iX, iY, PLAIN ("imgchkbl"));
 			CenterNumber (iDropGate2, 350, 69, color_bl, 0);
 			/*========== 3 ==========*/
 			switch (iDropGate3Check)
@@ -6826,7 +6481,7 @@ void ShowChange (void)
 				case 0xFFFF: iX = 573; iY = 98; break; /*** exit ***/
 				case -1: iX = 453; iY = 72; break; /*** gate no ***/
 			}
-			ShowImage (imgchkbl, iX, iY, "imgchkbl");
+			ShowImage (imgchkbl, iX, iY, PLAIN ("imgchkbl"));
 			CenterNumber (iDropGate3, 559, 69, color_bl, 0);
 			break;
 		case 0x05: /*** gate ***/
@@ -6844,19 +6499,19 @@ void ShowChange (void)
 					printf ("[ WARN ] Unknown gate state check: %i!\n",
 						iGateStateCheck); break;
 			}
-			ShowImage (imgchkbl, iX, iY, "imgchkbl");
+			ShowImage (imgchkbl, iX, iY, PLAIN ("imgchkbl"));
 			CenterNumber (iGateOpenness, 343, 69, color_bl, 0);
 			CenterNumber (iGateDelay, 400, 95, color_bl, 0);
 			break;
 		case 0x09: /*** potion ***/
 			if (iEXEType != 2) /*** If not EU... ***/
 			{
-				ShowImage (imgeuonly, 301, 98, "imgeuonly"); /*** loose ***/
-				ShowImage (imgeuonly, 358, 98, "imgeuonly"); /*** stop ***/
-				ShowImage (imgeuonly, 415, 98, "imgeuonly"); /*** time ***/
-				ShowImage (imgeuonly, 472, 98, "imgeuonly"); /*** time ***/
-				ShowImage (imgeuonly, 529, 98, "imgeuonly"); /*** time ***/
-				ShowImage (imgeuonly, 586, 98, "imgeuonly"); /*** time ***/
+				ShowImage (imgeuonly, 301, 98, PLAIN ("imgeuonly")); /*** loose ***/
+				ShowImage (imgeuonly, 358, 98, PLAIN ("imgeuonly")); /*** stop ***/
+				ShowImage (imgeuonly, 415, 98, PLAIN ("imgeuonly")); /*** time ***/
+				ShowImage (imgeuonly, 472, 98, PLAIN ("imgeuonly")); /*** time ***/
+				ShowImage (imgeuonly, 529, 98, PLAIN ("imgeuonly")); /*** time ***/
+				ShowImage (imgeuonly, 586, 98, PLAIN ("imgeuonly")); /*** time ***/
 			}
 			switch (iPotionColorCheck)
 			{
@@ -6864,7 +6519,7 @@ void ShowChange (void)
 				case 3: iX = 95; iY = 98; break; /*** green ***/
 				case 10: iX = 35; iY = 72; break; /*** color no ***/
 			}
-			ShowImage (imgchkbl, iX, iY, "imgchkbl");
+			ShowImage (imgchkbl, iX, iY, PLAIN ("imgchkbl"));
 			CenterNumber (iPotionColor, 141, 69, color_bl, 0);
 			switch (iPotionEffectCheck)
 			{
@@ -6880,7 +6535,7 @@ void ShowChange (void)
 				case 9: iX = 586; iY = 98; break; /*** time ***/
 				case 10: iX = 415; iY = 72; break; /*** effect no ***/
 			}
-			ShowImage (imgchkbl, iX, iY, "imgchkbl");
+			ShowImage (imgchkbl, iX, iY, PLAIN ("imgchkbl"));
 			CenterNumber (iPotionEffect, 559, 69, color_bl, 0);
 			break;
 		case 0x0A: /*** door ***/
@@ -6889,7 +6544,7 @@ void ShowChange (void)
 				case 0: iX = 35; iY = 72; break; /*** entrance ***/
 				case 2: iX = 35; iY = 98; break; /*** exit ***/
 			}
-			ShowImage (imgchkbl, iX, iY, "imgchkbl");
+			ShowImage (imgchkbl, iX, iY, PLAIN ("imgchkbl"));
 			break;
 	}
 
@@ -6897,10 +6552,10 @@ void ShowChange (void)
 	switch (arLevelType[iCurLevel])
 	{
 		case 0:
-			ShowImage (imgtabgd[iTabGraphics], 8, 125, "imgtabgd[...]");
+			ShowImage (imgtabgd[iTabGraphics], 8, 125, PLAIN ("imgtabgd[...]"));
 			break;
 		case 1:
-			ShowImage (imgtabgp[iTabGraphics], 8, 125, "imgtabgp[...]");
+			ShowImage (imgtabgp[iTabGraphics], 8, 125, PLAIN ("imgtabgp[...]"));
 			break;
 	}
 
@@ -6908,16 +6563,16 @@ void ShowChange (void)
 	switch (iCloseOn)
 	{
 		case 0: /*** off ***/
-			ShowImage (imgclosebig_0, 656, 0, "imgclosebig_0"); break;
+			ShowImage (imgclosebig_0, 656, 0, PLAIN ("imgclosebig_0")); break;
 		case 1: /*** on ***/
-			ShowImage (imgclosebig_1, 656, 0, "imgclosebig_1"); break;
+			ShowImage (imgclosebig_1, 656, 0, PLAIN ("imgclosebig_1")); break;
 	}
 
 	/*** old graphics ***/
 	if (iTabGraphics == iOldGraphicsTab)
 	{
 		ShowImage (imgborderbl, 10 + ((iOldGraphicsX - 1) * 34),
-			193 + ((iOldGraphicsY - 1) * 66), "imgborderbl");
+			193 + ((iOldGraphicsY - 1) * 66), PLAIN ("imgborderbl"));
 	}
 
 	/*** prince, turned right ***/
@@ -6926,48 +6581,45 @@ void ShowChange (void)
 		(arPrinceY[iCurLevel] == ((iCurY - 1) * HEIGHT) + iSelectedY) &&
 		(arLevelStartingX[iCurLevel] == iCurX) &&
 		(arLevelStartingY[iCurLevel] == iCurY))
-		{ ShowImage (imgbordersl, 204, 396, "imgbordersl"); }
+		{ ShowImage (imgbordersl, 204, 396, PLAIN ("imgbordersl")); }
 	/*** prince, turned left ***/
 	if ((arPrinceDir[iCurLevel] == 0x00) &&
 		(arPrinceX[iCurLevel] == ((iCurX - 1) * WIDTH) + iSelectedX) &&
 		(arPrinceY[iCurLevel] == ((iCurY - 1) * HEIGHT) + iSelectedY) &&
 		(arLevelStartingX[iCurLevel] == iCurX) &&
 		(arLevelStartingY[iCurLevel] == iCurY))
-		{ ShowImage (imgbordersl, 236, 396, "imgbordersl"); }
+		{ ShowImage (imgbordersl, 236, 396, PLAIN ("imgbordersl")); }
 
 	/*** guard ***/
-	for (iGuardLoop = 1; iGuardLoop <= arNrGuards[iCurLevel]; iGuardLoop++)
+	iGuard = FindObject (iCurLevel, 0x0C, ((iCurX - 1) * WIDTH) + iSelectedX,
+		((iCurY - 1) * HEIGHT) + iSelectedY);
+	if (iGuard != 0)
 	{
-		if ((arGuardX[iCurLevel][iGuardLoop] ==
-			((iCurX - 1) * WIDTH) + iSelectedX) &&
-			(arGuardY[iCurLevel][iGuardLoop] ==
-			((iCurY - 1) * HEIGHT) + iSelectedY))
+		iGuardX = 204; /*** To prevent the "uninitialized" warning. ***/
+		iGuardType = GetField (iCurLevel, 0x0C, iGuard, GUARD_TYPE);
+		if (GetField (iCurLevel, 0x0C, iGuard, GUARD_DIR) == 0x800) /*** r ***/
 		{
-			iGuardX = 204; /*** To prevent the "uninitialized" warning. ***/
-			if (arGuardDir[iCurLevel][iGuardLoop] == 0x800) /*** right ***/
+			switch (iGuardType)
 			{
-				switch (arGuardType[iCurLevel][iGuardLoop])
-				{
-					case 0: iGuardX = 204; break; /*** guard ***/
-					case 1: iGuardX = 268; break; /*** skeleton ***/
-					case 2: iGuardX = 332; break; /*** fat ***/
-					case 3: iGuardX = 396; break; /*** shadow ***/
-					case 4: iGuardX = 460; break; /*** Jaffar ***/
-				}
+				case 0: iGuardX = 204; break; /*** guard ***/
+				case 1: iGuardX = 268; break; /*** skeleton ***/
+				case 2: iGuardX = 332; break; /*** fat ***/
+				case 3: iGuardX = 396; break; /*** shadow ***/
+				case 4: iGuardX = 460; break; /*** Jaffar ***/
 			}
-			if (arGuardDir[iCurLevel][iGuardLoop] == 0x00) /*** left ***/
+		}
+		if (GetField (iCurLevel, 0x0C, iGuard, GUARD_DIR) == 0x00) /*** l ***/
+		{
+			switch (iGuardType)
 			{
-				switch (arGuardType[iCurLevel][iGuardLoop])
-				{
-					case 0: iGuardX = 236; break; /*** guard ***/
-					case 1: iGuardX = 300; break; /*** skeleton ***/
-					case 2: iGuardX = 364; break; /*** fat ***/
-					case 3: iGuardX = 428; break; /*** shadow ***/
-					case 4: iGuardX = 492; break; /*** Jaffar ***/
-				}
+				case 0: iGuardX = 236; break; /*** guard ***/
+				case 1: iGuardX = 300; break; /*** skeleton ***/
+				case 2: iGuardX = 364; break; /*** fat ***/
+				case 3: iGuardX = 428; break; /*** shadow ***/
+				case 4: iGuardX = 492; break; /*** Jaffar ***/
 			}
-			ShowImage (imgbordersl, iGuardX, 329, "imgbordersl");
 		}
+		ShowImage (imgbordersl, iGuardX, 329, PLAIN ("imgbordersl"));
 	}
 
 	/*** selected (new) tile ***/
@@ -6999,9 +6651,9 @@ void ShowChange (void)
 
 		if (iOnTile <= 30) /*** graphics ***/
 		{
-			ShowImage (imgborderb, iX, iY, "imgborderb");
+			ShowImage (imgborderb, iX, iY, PLAIN ("imgborderb"));
 		} else { /*** living ***/
-			ShowImage (imgborders, iX, iY, "imgborders");
+			ShowImage (imgborders, iX, iY, PLAIN ("imgborders"));
 		}
 	}
 
@@ -7018,7 +6670,7 @@ void ShowChange (void)
 	CenterNumber (iNewHP, 560, 437, color_bl, 0);
 
 	if (iCustomHover == 1)
-		{ ShowImage (imgchover, 271, 399, "imgchover"); }
+		{ ShowImage (imgchover, 271, 399, PLAIN ("imgchover")); }
 
 	/*** refresh screen ***/
 	SDL_RenderPresent (ascreen);
@@ -7205,12 +6857,6 @@ void CenterNumber (int iNumber, int iX, int iY,
 	} else {
 		snprintf (sText, MAX_TEXT, "%02X", iNumber);
 	}
-	/* The 100000 is a workaround for 0 being broken. SDL devs have fixed that
-	 * see e.g. https://hg.libsdl.org/SDL_ttf/rev/72b8861dbc01 but
-	 * Ubuntu et al. still ship older sdl2-ttf versions.
-	 */
-	message = TTF_RenderText_Blended_Wrapped (font3, sText, fore, 100000);
-	messaget = SDL_CreateTextureFromSurface (ascreen, message);
 	if (iHex == 0)
 	{
 		if ((iNumber >= -9) && (iNumber <= -1))
@@ -7229,9 +6875,7 @@ void CenterNumber (int iNumber, int iX, int iY,
 		offset.x = iX + 14;
 	}
 	offset.y = iY - 1;
-	offset.w = message->w; offset.h = message->h;
-	CustomRenderCopy (messaget, NULL, &offset, "message");
-	SDL_DestroyTexture (messaget); SDL_FreeSurface (message);
+	ShowText (font3, sText, fore, fore, 1, offset.x, offset.y);
 }
 /*****************************************************************************/
 int Unused (int iTile)
@@ -7280,21 +6924,11 @@ if (pid == 0)
 void EXELoad (void)
 /*****************************************************************************/
 {
-	int iFdEXE;
-	unsigned char sRead[2 + 2];
-	char sReadDW[10 + 2];
+	unsigned char *sROM;
 	int iOffsetTime, iOffsetHP, iOffsetLevel, iFPS;
 	int iEXEStartingTime;
 
-	iFdEXE = open (sPathFile, O_RDONLY|O_BINARY);
-	if (iFdEXE == -1)
-	{
-		printf ("[FAILED] Error opening %s: %s!\n",
-			sPathFile, strerror (errno));
-		exit (EXIT_ERROR);
-	}
-
-	switch (iEXEType)
+	switch (iEXEType)
 	{
 		case 1: /*** US ***/
 			iOffsetTime = 0x1DF9C;
@@ -7313,43 +6947,30 @@ void EXELoad (void)
 			exit (EXIT_ERROR); break;
 	}
 
+	/*** As LoadLevels(), read the ROM as it is on disk. ***/
+	sROM = stROM.stPristine.sData;
+	CheckRange (iOffsetTime, 4, stROM.stPristine.iSize, "time");
+	CheckRange (iOffsetHP, 1, stROM.stPristine.iSize, "HP");
+	CheckRange (iOffsetLevel, 1, stROM.stPristine.iSize, "level");
+
 	/*** Starting time. ***/
-	lseek (iFdEXE, iOffsetTime, SEEK_SET);
-	read (iFdEXE, sRead, 4);
-	snprintf (sReadDW, 10, "%02x%02x%02x%02x",
-		sRead[0], sRead[1], sRead[2], sRead[3]);
-	iEXEStartingTime = (strtoul (sReadDW, NULL, 16) + 1) / iFPS;
+	iEXEStartingTime = (GetDWord (sROM + iOffsetTime) + 1) / iFPS;
 	iEXEStartingMin = iEXEStartingTime / 60;
 	iEXEStartingSec = iEXEStartingTime % 60;
 
 	/*** Starting HP. ***/
-	lseek (iFdEXE, iOffsetHP, SEEK_SET);
-	read (iFdEXE, sRead, 1);
-	iEXEStartingHP = sRead[0];
+	iEXEStartingHP = sROM[iOffsetHP];
 
 	/*** Starting level. ***/
-	lseek (iFdEXE, iOffsetLevel, SEEK_SET);
-	read (iFdEXE, sRead, 1);
-	iEXEStartingLevel = sRead[0] + 1;
-
-	close (iFdEXE);
+	iEXEStartingLevel = sROM[iOffsetLevel] + 1;
 }
 /*****************************************************************************/
 void EXESave (void)
 /*****************************************************************************/
 {
-	int iFdEXE;
 	int iOffsetTime, iOffsetHP, iOffsetLevel, iFPS;
 	int iEXEStartingTime;
 
-	iFdEXE = open (sPathFile, O_RDWR|O_BINARY);
-	if (iFdEXE == -1)
-	{
-		printf ("[FAILED] Error opening %s: %s!\n",
-			sPathFile, strerror (errno));
-		exit (EXIT_ERROR);
-	}
-
 	switch (iEXEType)
 	{
 		case 1: /*** US ***/
@@ -7370,19 +6991,25 @@ void EXESave (void)
 	}
 
 	/*** Starting time. ***/
-	lseek (iFdEXE, iOffsetTime, SEEK_SET);
+	stROM.stWorking.iPos = iOffsetTime;
 	iEXEStartingTime = (((iEXEStartingMin * 60) + iEXEStartingSec) * iFPS) - 1;
-	WriteDWord (iFdEXE, iEXEStartingTime);
+	PutDWord (&stROM.stWorking, iEXEStartingTime);
 
 	/*** Starting HP. ***/
-	lseek (iFdEXE, iOffsetHP, SEEK_SET);
-	WriteByte (iFdEXE, iEXEStartingHP);
+	stROM.stWorking.iPos = iOffsetHP;
+	PutByte (&stROM.stWorking, iEXEStartingHP);
 
 	/*** Starting level. ***/
-	lseek (iFdEXE, iOffsetLevel, SEEK_SET);
-	WriteByte (iFdEXE, iEXEStartingLevel - 1);
+	stROM.stWorking.iPos = iOffsetLevel;
+	PutByte (&stROM.stWorking, iEXEStartingLevel - 1);
 
-	close (iFdEXE);
+	if (WriteChanges() == 0)
+	{
+		memcpy (stROM.stWorking.sData, stROM.stPristine.sData,
+			stROM.stWorking.iSize);
+		return;
+	}
+	if (iCache == 1) { SaveCache(); }
 
 	PlaySound ("wav/save.wav");
 }
@@ -7669,59 +7296,65 @@ void UpdateOnTile (void)
 	}
 }
 /*****************************************************************************/
-void GetNrsAndOffsets (int iFd, int *arNr, int *arOffset,
-	int iObjectSize, char *sObjectName)
+void GetNrsAndOffsets (unsigned char *sROM, int iROMSize, int iObject)
 /*****************************************************************************/
 {
-	unsigned char sRead[MAX_BYTES + 2];
-	char sReadW[10 + 2];
-	char sReadDW[10 + 2];
+	unsigned char *sRec;
+	int iStartOffset, iObjectSize;
+	int iNr, iOffset;
+	int iTotal;
 
 	/*** Used for looping. ***/
 	int iLevelLoop;
 
+	iStartOffset = *arTypes[iObject].iOffset;
+	iObjectSize = arTypes[iObject].iWords * 2;
+	CheckRange (iStartOffset, iNrLevels * 6, iROMSize, arTypes[iObject].sName);
+	iTotal = 0;
 	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
 	{
-		read (iFd, sRead, 6);
-		snprintf (sReadW, 10, "%02x%02x", sRead[0], sRead[1]);
-		arNr[iLevelLoop] = strtoul (sReadW, NULL, 16);
-		snprintf (sReadDW, 10, "%02x%02x%02x%02x",
-			sRead[2], sRead[3], sRead[4], sRead[5]);
-		arOffset[iLevelLoop] = strtoul (sReadDW, NULL, 16);
+		sRec = sROM + iStartOffset + ((iLevelLoop - 1) * 6);
+		iNr = GetWord (sRec + 0);
+		iOffset = GetDWord (sRec + 2);
+		iTotal+=iNr;
 		if (iDebug == 1)
 		{
-			if (arNr[iLevelLoop] > 0)
+			if (iNr > 0)
 			{
 				printf ("[ INFO ] Offset %s, level %i: 0x%02X(-0x%02X)\n",
-					sObjectName, iLevelLoop, arOffset[iLevelLoop],
-					arOffset[iLevelLoop] + (arNr[iLevelLoop] * iObjectSize) - 1);
+					arTypes[iObject].sName, iLevelLoop, iOffset,
+					iOffset + (iNr * iObjectSize) - 1);
 			} else {
 				printf ("[ INFO ] Offset %s, level %i: (none)\n",
-					sObjectName, iLevelLoop);
+					arTypes[iObject].sName, iLevelLoop);
 			}
 		}
 	}
+	CheckRange (iStartOffset + (iNrLevels * 6), iTotal * iObjectSize,
+		iROMSize, arTypes[iObject].sName);
 }
 /*****************************************************************************/
-void SetNrsAndOffsets (int iFd, int *arNr, int iStartOffset, int iObjectSize)
+void SetNrsAndOffsets (struct image *stImage, int iObject)
 /*****************************************************************************/
 {
 	int iOffset;
+	int iNr;
 
 	/*** Used for looping. ***/
 	int iLevelLoop;
 
-	iOffset = iStartOffset + (iNrLevels * 6);
+	iOffset = *arTypes[iObject].iOffset + (iNrLevels * 6);
 
 	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
 	{
-		WriteWord (iFd, arNr[iLevelLoop]);
-		if (arNr[iLevelLoop] != 0)
+		iNr = arObjects[iLevelLoop][iObject].iNr;
+		PutWord (stImage, iNr);
+		if (iNr != 0)
 		{
-			WriteDWord (iFd, iOffset);
-			iOffset+=(arNr[iLevelLoop] * iObjectSize);
+			PutDWord (stImage, iOffset);
+			iOffset+=(iNr * arTypes[iObject].iWords * 2);
 		} else {
-			WriteDWord (iFd, 0);
+			PutDWord (stImage, 0);
 		}
 	}
 }
@@ -7778,14 +7411,13 @@ const char* StateAsText (int iS1, int iS2, int iS3)
 	}
 }
 /*****************************************************************************/
-int GetSelectedTileValue (int *arAttr, int *arX, int *arY,
-	int iNrObjects, int iDefault)
+int GetSelectedTileValue (int iObject, int iField, int iDefault)
 /*****************************************************************************/
 {
 	int iReturn;
 
 	iReturn = GetAttribute (((iCurX - 1) * WIDTH) + iSelectedX,
-		((iCurY - 1) * HEIGHT) + iSelectedY, arX, arY, arAttr, iNrObjects);
+		((iCurY - 1) * HEIGHT) + iSelectedY, iObject, iField);
 	if (iReturn != -1)
 	{
 		return (iReturn);
@@ -7794,20 +7426,15 @@ int GetSelectedTileValue (int *arAttr, int *arX, int *arY,
 	}
 }
 /*****************************************************************************/
-int GetAttribute (int iX, int iY, int *arX, int *arY, int *arAttr,
-	int iNrObjects)
+int GetAttribute (int iX, int iY, int iObject, int iField)
 /*****************************************************************************/
 {
-	/*** Used for looping. ***/
-	int iObjectLoop;
+	int iNr;
 
-	for (iObjectLoop = 1; iObjectLoop <= iNrObjects; iObjectLoop++)
+	iNr = FindObject (iCurLevel, iObject, iX, iY);
+	if (iNr != 0)
 	{
-		if ((arX[iObjectLoop] == iX) &&
-			(arY[iObjectLoop] == iY))
-		{
-			return (arAttr[iObjectLoop]);
-		}
+		return (GetField (iCurLevel, iObject, iNr, iField));
 	}
 
 	return (-1);
@@ -7816,16 +7443,7 @@ int GetAttribute (int iX, int iY, int *arX, int *arY, int *arAttr,
 void ModifyStart (int iLevel, int iToFrom)
 /*****************************************************************************/
 {
-	int iFd;
 	int iOffsetLevel;
-	char sRead[1 + 2];
-
-	iFd = open (sPathFile, O_RDWR|O_BINARY, 0600);
-	if (iFd == -1)
-	{
-		printf ("[FAILED] Error opening %s: %s!\n", sPathFile, strerror (errno));
-		exit (EXIT_ERROR);
-	}
 
 	switch (iEXEType)
 	{
@@ -7836,213 +7454,97 @@ void ModifyStart (int iLevel, int iToFrom)
 			exit (EXIT_ERROR); break;
 	}
 
+	stROM.stWorking.iPos = iOffsetLevel;
 	if (iToFrom == 1)
 	{
-		lseek (iFd, iOffsetLevel, SEEK_SET);
-		read (iFd, sRead, 1);
-		iModified = sRead[0] + 1;
-		lseek (iFd, iOffsetLevel, SEEK_SET);
-		WriteByte (iFd, iLevel - 1);
+		CheckRange (iOffsetLevel, 1, stROM.stPristine.iSize, "level");
+		iModified = stROM.stPristine.sData[iOffsetLevel] + 1;
+		PutByte (&stROM.stWorking, iLevel - 1);
 	} else {
-		lseek (iFd, iOffsetLevel, SEEK_SET);
-		WriteByte (iFd, iModified - 1);
+		PutByte (&stROM.stWorking, iModified - 1);
+	}
+	if (WriteChanges() == 0)
+	{
+		memcpy (stROM.stWorking.sData, stROM.stPristine.sData,
+			stROM.stWorking.iSize);
 	}
-
-	close (iFd);
 }
 /*****************************************************************************/
-int Total (char *sType)
+int Total (int iObject)
 /*****************************************************************************/
 {
-	int iTotal;
-
-	/*** Used for looping. ***/
-	int iLevelLoop;
-
-	iTotal = 0;
-
-	if (strcmp (sType, "rooms") == 0)
-	{
-		for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
-			{ iTotal+=(arLevelWidth[iLevelLoop] * arLevelHeight[iLevelLoop]); }
-	}
-
-	if (strcmp (sType, "guards") == 0)
-	{
-		for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
-			{ iTotal+=arNrGuards[iLevelLoop]; }
-	}
-
-	if (strcmp (sType, "doors") == 0)
-	{
-		for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
-			{ iTotal+=arNrDoors[iLevelLoop]; }
-	}
-
-	if (strcmp (sType, "gates") == 0)
-	{
-		for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
-			{ iTotal+=arNrGates[iLevelLoop]; }
-	}
-
-	if (strcmp (sType, "loose") == 0)
-	{
-		for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
-			{ iTotal+=arNrLoose[iLevelLoop]; }
-	}
-
-	if (strcmp (sType, "raise") == 0)
-	{
-		for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
-			{ iTotal+=arNrRaise[iLevelLoop]; }
-	}
-
-	if (strcmp (sType, "drop") == 0)
-	{
-		for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
-			{ iTotal+=arNrDrop[iLevelLoop]; }
-	}
-
-	if (strcmp (sType, "chompers") == 0)
-	{
-		for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
-			{ iTotal+=arNrChompers[iLevelLoop]; }
-	}
-
-	if (strcmp (sType, "spikes") == 0)
-	{
-		for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
-			{ iTotal+=arNrSpikes[iLevelLoop]; }
-	}
-
-	if (strcmp (sType, "potions") == 0)
-	{
-		for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
-			{ iTotal+=arNrPotions[iLevelLoop]; }
-	}
+	/*** Of all levels; iObject is TOTAL_ROOMS or an object value. ***/
 
-	return (iTotal);
+	return (arTotals[iObject]);
 }
 /*****************************************************************************/
-void TotalLine (char *sType, int iAllowed, int iVer)
+void TotalLine (int iBudget, int iVer)
 /*****************************************************************************/
 {
 	SDL_Color clr;
 	SDL_Texture *imgstatus;
+	int iTotal;
+	int iAllowed;
 
-	if (Total (sType) <= iAllowed)
+	iTotal = Total (arBudgets[iBudget].iObject);
+	iAllowed = Allowed (iBudget);
+	if (iTotal <= iAllowed)
 		{ clr = color_wh; imgstatus = imgstatus1; }
 			else { clr = color_red; imgstatus = imgstatus0; }
 	CenterNumber (iAllowed, 250, 129 + (iVer * 24), color_wh, 0);
-	CenterNumber (Total (sType), 353, 129 + (iVer * 24), clr, 0);
-	ShowImage (imgstatus, 477, 132 + (iVer * 24), "imgstatus");
+	CenterNumber (iTotal, 353, 129 + (iVer * 24), clr, 0);
+	ShowImage (imgstatus, 477, 132 + (iVer * 24), PLAIN ("imgstatus"));
 }
 /*****************************************************************************/
-int IsSavingAllowed (void)
+int Allowed (int iBudget)
 /*****************************************************************************/
 {
 	switch (iEXEType)
 	{
-		case 1: /*** US ***/
-			if ((Total ("rooms") <= ALLOWED_US_ROOMS) &&
-				(Total ("guards") <= ALLOWED_US_GUARDS) &&
-				(Total ("doors") <= ALLOWED_US_DOORS) &&
-				(Total ("gates") <= ALLOWED_US_GATES) &&
-				(Total ("loose") <= ALLOWED_US_LOOSE) &&
-				(Total ("raise") <= ALLOWED_US_RAISE) &&
-				(Total ("drop") <= ALLOWED_US_DROP) &&
-				(Total ("chompers") <= ALLOWED_US_CHOMPERS) &&
-				(Total ("spikes") <= ALLOWED_US_SPIKES) &&
-				(Total ("potions") <= ALLOWED_US_POTIONS))
-			{ return (1); } else { return (0); }
-			break;
-		case 2: /*** EU ***/
-			if ((Total ("rooms") <= ALLOWED_EU_ROOMS) &&
-				(Total ("guards") <= ALLOWED_EU_GUARDS) &&
-				(Total ("doors") <= ALLOWED_EU_DOORS) &&
-				(Total ("gates") <= ALLOWED_EU_GATES) &&
-				(Total ("loose") <= ALLOWED_EU_LOOSE) &&
-				(Total ("raise") <= ALLOWED_EU_RAISE) &&
-				(Total ("drop") <= ALLOWED_EU_DROP) &&
-				(Total ("chompers") <= ALLOWED_EU_CHOMPERS) &&
-				(Total ("spikes") <= ALLOWED_EU_SPIKES) &&
-				(Total ("potions") <= ALLOWED_EU_POTIONS))
-			{ return (1); } else { return (0); }
-			break;
+		case 1: return (arBudgets[iBudget].iAllowedUS); break; /*** US ***/
+		case 2: return (arBudgets[iBudget].iAllowedEU); break; /*** EU ***/
 	}
 
-	printf ("[ WARN ] IsSavingAllowed() failed!\n");
 	return (0);
 }
 /*****************************************************************************/
-void SetTypeDefaults (void)
+int IsSavingAllowed (void)
 /*****************************************************************************/
 {
-	switch (iEXEType)
+	/*** Used for looping. ***/
+	int iBudgetLoop;
+
+	if ((iEXEType != 1) && (iEXEType != 2))
 	{
-		case 1: /*** US ***/
-			iNrLevels = NR_LEVELS_US;
-			iOffsetPrince = OFFSET_PRINCE_US;
-			iOffsetLevels = OFFSET_LEVELS_US;
-			iOffsetGrOb = OFFSET_GR_OB_US;
-			iOffsetGuards = OFFSET_GUARDS_US;
-			iOffsetDoors = OFFSET_DOORS_US;
-			iOffsetGates = OFFSET_GATES_US;
-			iOffsetLoose = OFFSET_LOOSE_US;
-			iOffsetRaise = OFFSET_RAISE_US;
-			iOffsetDrop = OFFSET_DROP_US;
-			iOffsetChompers = OFFSET_CHOMPERS_US;
-			iOffsetSpikes = OFFSET_SPIKES_US;
-			iOffsetPotions = OFFSET_POTIONS_US;
-			break;
-		case 2: /*** EU ***/
-			iNrLevels = NR_LEVELS_EU;
-			iOffsetPrince = OFFSET_PRINCE_EU;
-			iOffsetLevels = OFFSET_LEVELS_EU;
-			iOffsetGrOb = OFFSET_GR_OB_EU;
-			iOffsetGuards = OFFSET_GUARDS_EU;
-			iOffsetDoors = OFFSET_DOORS_EU;
-			iOffsetGates = OFFSET_GATES_EU;
-			iOffsetLoose = OFFSET_LOOSE_EU;
-			iOffsetRaise = OFFSET_RAISE_EU;
-			iOffsetDrop = OFFSET_DROP_EU;
-			iOffsetChompers = OFFSET_CHOMPERS_EU;
-			iOffsetSpikes = OFFSET_SPIKES_EU;
-			iOffsetPotions = OFFSET_POTIONS_EU;
-			break;
+		printf ("[ WARN ] IsSavingAllowed() failed!\n");
+		return (0);
 	}
-}
-/*****************************************************************************/
-void WriteByte (int iFd, int iValue)
-/*****************************************************************************/
-{
-	char sToWrite[MAX_TOWRITE + 2];
 
-	snprintf (sToWrite, MAX_TOWRITE, "%c", iValue);
-	write (iFd, sToWrite, 1);
-}
-/*****************************************************************************/
-void WriteWord (int iFd, int iValue)
-/*****************************************************************************/
-{
-	char sToWrite[MAX_TOWRITE + 2];
+	for (iBudgetLoop = 0; iBudgetLoop < NR_BUDGETS; iBudgetLoop++)
+	{
+		if (Total (arBudgets[iBudgetLoop].iObject) > Allowed (iBudgetLoop))
+			{ return (0); }
+	}
 
-	snprintf (sToWrite, MAX_TOWRITE, "%c%c", (iValue >> 8) & 0xFF,
-		(iValue >> 0) & 0xFF);
-	write (iFd, sToWrite, 2);
+	return (1);
 }
 /*****************************************************************************/
-void WriteDWord (int iFd, int iValue)
+void SetTypeDefaults (void)
 /*****************************************************************************/
 {
-	char sToWrite[MAX_TOWRITE + 2];
-
-	snprintf (sToWrite, MAX_TOWRITE, "%c%c%c%c",
-		(iValue >> 24) & 0xFF,
-		(iValue >> 16) & 0xFF,
-		(iValue >> 8) & 0xFF,
-		(iValue >> 0) & 0xFF);
-	write (iFd, sToWrite, 4);
+	iNrLevels = stLayout.iNrLevels;
+	iOffsetPrince = stLayout.iOffsetPrince;
+	iOffsetLevels = stLayout.iOffsetLevels;
+	iOffsetGrOb = stLayout.iOffsetGrOb;
+	iOffsetGuards = stLayout.iOffsetGuards;
+	iOffsetDoors = stLayout.iOffsetDoors;
+	iOffsetGates = stLayout.iOffsetGates;
+	iOffsetLoose = stLayout.iOffsetLoose;
+	iOffsetRaise = stLayout.iOffsetRaise;
+	iOffsetDrop = stLayout.iOffsetDrop;
+	iOffsetChompers = stLayout.iOffsetChompers;
+	iOffsetSpikes = stLayout.iOffsetSpikes;
+	iOffsetPotions = stLayout.iOffsetPotions;
 }
 /*****************************************************************************/
 int LoadYBottom (int iYCoor)
@@ -8069,285 +7571,56 @@ int SaveYTop (int iY)
 	return ((iY - 1) * 64);
 }
 /*****************************************************************************/
-void TempAttributes (int iObject)
+void AddRemoveAttributes (int iObject, int iX, int iY, int iType)
 /*****************************************************************************/
 {
-	/* iObject 0x0C is used for guards.
-	 * Also, arOffset...[] is deliberately being ignored.
+	/* iObject 0x0C is used as the guard 'object'. The records stay sorted
+	 * the way the ROM has them: by X, then by Y. A record is inserted or
+	 * removed in place, by moving the records after it.
 	 */
 
-	/*** Used for looping. ***/
-	int iTempLoop;
-
-	if (iObject == 0x03) /*** raise (buttons) ***/
-	{
-		iNrTemp = arNrRaise[iCurLevel];
-		for (iTempLoop = 1; iTempLoop <= iNrTemp; iTempLoop++)
-		{
-			iTempAttr1[iTempLoop] = arRaiseYP[iCurLevel][iTempLoop];
-			iTempAttr2[iTempLoop] = arRaiseY[iCurLevel][iTempLoop];
-			iTempAttr3[iTempLoop] = arRaiseXP[iCurLevel][iTempLoop];
-			iTempAttr4[iTempLoop] = arRaiseX[iCurLevel][iTempLoop];
-			iTempAttr5[iTempLoop] = arRaiseGate1[iCurLevel][iTempLoop];
-			iTempAttr6[iTempLoop] = arRaiseGate2[iCurLevel][iTempLoop];
-			iTempAttr7[iTempLoop] = arRaiseGate3[iCurLevel][iTempLoop];
-		}
-	}
-
-	if (iObject == 0x04) /*** drop (buttons) ***/
-	{
-		iNrTemp = arNrDrop[iCurLevel];
-		for (iTempLoop = 1; iTempLoop <= iNrTemp; iTempLoop++)
-		{
-			iTempAttr1[iTempLoop] = arDropYP[iCurLevel][iTempLoop];
-			iTempAttr2[iTempLoop] = arDropY[iCurLevel][iTempLoop];
-			iTempAttr3[iTempLoop] = arDropXP[iCurLevel][iTempLoop];
-			iTempAttr4[iTempLoop] = arDropX[iCurLevel][iTempLoop];
-			iTempAttr5[iTempLoop] = arDropGate1[iCurLevel][iTempLoop];
-			iTempAttr6[iTempLoop] = arDropGate2[iCurLevel][iTempLoop];
-			iTempAttr7[iTempLoop] = arDropGate3[iCurLevel][iTempLoop];
-		}
-	}
-
-	if (iObject == 0x05) /*** gates ***/
-	{
-		iNrTemp = arNrGates[iCurLevel];
-		for (iTempLoop = 1; iTempLoop <= iNrTemp; iTempLoop++)
-		{
-			iTempAttr1[iTempLoop] = arGateState1[iCurLevel][iTempLoop];
-			iTempAttr2[iTempLoop] = arGateYP[iCurLevel][iTempLoop];
-			iTempAttr3[iTempLoop] = arGateY[iCurLevel][iTempLoop];
-			iTempAttr4[iTempLoop] = arGateXP[iCurLevel][iTempLoop];
-			iTempAttr5[iTempLoop] = arGateX[iCurLevel][iTempLoop];
-			iTempAttr6[iTempLoop] = arGateState2[iCurLevel][iTempLoop];
-			iTempAttr7[iTempLoop] = arGateState3[iCurLevel][iTempLoop];
-			iTempAttr8[iTempLoop] = arGateUnk[iCurLevel][iTempLoop];
-		}
-	}
-
-	if (iObject == 0x06) /*** loose (floors) ***/
-	{
-		iNrTemp = arNrLoose[iCurLevel];
-		for (iTempLoop = 1; iTempLoop <= iNrTemp; iTempLoop++)
-		{
-			iTempAttr1[iTempLoop] = arLooseYP[iCurLevel][iTempLoop];
-			iTempAttr2[iTempLoop] = arLooseY[iCurLevel][iTempLoop];
-			iTempAttr3[iTempLoop] = arLooseXP[iCurLevel][iTempLoop];
-			iTempAttr4[iTempLoop] = arLooseX[iCurLevel][iTempLoop];
-		}
-	}
-
-	if (iObject == 0x07) /*** spikes ***/
-	{
-		iNrTemp = arNrSpikes[iCurLevel];
-		for (iTempLoop = 1; iTempLoop <= iNrTemp; iTempLoop++)
-		{
-			iTempAttr1[iTempLoop] = arSpikeYP[iCurLevel][iTempLoop];
-			iTempAttr2[iTempLoop] = arSpikeY[iCurLevel][iTempLoop];
-			iTempAttr3[iTempLoop] = arSpikeXP[iCurLevel][iTempLoop];
-			iTempAttr4[iTempLoop] = arSpikeX[iCurLevel][iTempLoop];
-		}
-	}
-
-	if (iObject == 0x08) /*** chompers ***/
-	{
-		iNrTemp = arNrChompers[iCurLevel];
-		for (iTempLoop = 1; iTempLoop <= iNrTemp; iTempLoop++)
-		{
-			iTempAttr1[iTempLoop] = arChomperYP[iCurLevel][iTempLoop];
-			iTempAttr2[iTempLoop] = arChomperY[iCurLevel][iTempLoop];
-			iTempAttr3[iTempLoop] = arChomperXP[iCurLevel][iTempLoop];
-			iTempAttr4[iTempLoop] = arChomperX[iCurLevel][iTempLoop];
-		}
-	}
-
-	if (iObject == 0x09) /*** potions ***/
-	{
-		iNrTemp = arNrPotions[iCurLevel];
-		for (iTempLoop = 1; iTempLoop <= iNrTemp; iTempLoop++)
-		{
-			iTempAttr1[iTempLoop] = arPotionColor[iCurLevel][iTempLoop];
-			iTempAttr2[iTempLoop] = arPotionYP[iCurLevel][iTempLoop];
-			iTempAttr3[iTempLoop] = arPotionY[iCurLevel][iTempLoop];
-			iTempAttr4[iTempLoop] = arPotionXP[iCurLevel][iTempLoop];
-			iTempAttr5[iTempLoop] = arPotionX[iCurLevel][iTempLoop];
-			iTempAttr6[iTempLoop] = arPotionEffect[iCurLevel][iTempLoop];
-		}
-	}
-
-	if (iObject == 0x0A) /*** (level) doors ***/
-	{
-		iNrTemp = arNrDoors[iCurLevel];
-		for (iTempLoop = 1; iTempLoop <= iNrTemp; iTempLoop++)
-		{
-			iTempAttr1[iTempLoop] = arDoorType[iCurLevel][iTempLoop];
-			iTempAttr2[iTempLoop] = arDoorYP[iCurLevel][iTempLoop];
-			iTempAttr3[iTempLoop] = arDoorY[iCurLevel][iTempLoop];
-			iTempAttr4[iTempLoop] = arDoorXP[iCurLevel][iTempLoop];
-			iTempAttr5[iTempLoop] = arDoorX[iCurLevel][iTempLoop];
-		}
-	}
+	int iNr;
+	int iObjectNr;
+	int iRecordX;
 
-	if (iObject == 0x0C) /*** guards ***/
+	if (iEdits > 0)
 	{
-		iNrTemp = arNrGuards[iCurLevel];
-		for (iTempLoop = 1; iTempLoop <= iNrTemp; iTempLoop++)
-		{
-			iTempAttr1[iTempLoop] = arGuardYP[iCurLevel][iTempLoop];
-			iTempAttr2[iTempLoop] = arGuardY[iCurLevel][iTempLoop];
-			iTempAttr3[iTempLoop] = arGuardXP[iCurLevel][iTempLoop];
-			iTempAttr4[iTempLoop] = arGuardX[iCurLevel][iTempLoop];
-			iTempAttr5[iTempLoop] = arGuardDir[iCurLevel][iTempLoop];
-			iTempAttr6[iTempLoop] = arGuardSprite[iCurLevel][iTempLoop];
-			iTempAttr7[iTempLoop] = arGuardType[iCurLevel][iTempLoop];
-			iTempAttr8[iTempLoop] = arGuardSkill[iCurLevel][iTempLoop];
-			iTempAttr9[iTempLoop] = arGuardHP[iCurLevel][iTempLoop];
-		}
+		EditAttributes (iObject, iX, iY, iType);
+		return;
 	}
-}
-/*****************************************************************************/
-void AddRemoveAttributes (int iObject, int iX, int iY, int *arNr,
-	int *arX, int *arY, int iType)
-/*****************************************************************************/
-{
-	/*** iObject 0x0C is used as the guard 'object'. ***/
-
-	int iObjectNr;
-	int iAdded;
-	int iSkip, iAdd;
-	int iNrLoop;
 
-	/*** Used for looping. ***/
-	int iTempLoop;
-
-	TempAttributes (iObject);
+	iNr = arObjects[iCurLevel][iObject].iNr;
 	switch (iType)
 	{
 		case 0: /*** remove ***/
-			arNr[iCurLevel]--; iNrLoop = iNrTemp; /*** No -1. ***/ break;
-		case 1: /*** add ***/
-			arNr[iCurLevel]++; iNrLoop = iNrTemp + 1; break;
-		default:
-			printf ("[FAILED] Incorrect type: %i!\n", iType);
-			exit (EXIT_ERROR); break;
-	}
-	if (arNr[iCurLevel] > 0)
-	{
-		iObjectNr = 1;
-		iAdded = 0;
-		for (iTempLoop = 1; iTempLoop <= iNrLoop; iTempLoop++)
-		{
-			/*** Checks: is this the object to remove? ***/
-			iSkip = 0;
-			if ((iType == 0) && (arX[iTempLoop] == iX) &&
-				(arY[iTempLoop] == iY))
-			{
-				iSkip = 1;
-				if (iObject == 0x05) { RaiseDropUpdate (iObjectNr, -1); }
-			}
-
-			/*** Checks: is this the location to add? ***/
-			iAdd = 0;
-			if ((iType == 1) && (iAdded == 0))
+			while ((iObjectNr = FindObject (iCurLevel, iObject, iX, iY)) != 0)
 			{
-				if (((arX[iTempLoop] == iX) &&
-						(arY[iTempLoop] > iY)) ||
-						(arX[iTempLoop] > iX) ||
-						(iObjectNr == arNr[iCurLevel]))
-				{
-					iAdd = 1;
-					if (iObject == 0x05) { RaiseDropUpdate (iObjectNr - 1, 1); }
-				}
-			}
-
-			if (iAdd == 1)
-			{
-				arY[iObjectNr] = iY;
-				arX[iObjectNr] = iX;
-				/*** Other attributes are added in UseTile(). ***/
-				iObjectNr++;
-				iAdded = 1;
+				JournalRecord (CHANGE_REMOVE, iCurLevel, iObject, iObjectNr);
+				IndexObjects (iCurLevel, iObject, 0);
+				DeleteRecord (iCurLevel, iObject, iObjectNr);
+				IndexObjects (iCurLevel, iObject, 1);
 			}
-			if ((iSkip != 1) && (iObjectNr <= arNr[iCurLevel]))
+			break;
+		case 1: /*** add ***/
+			/*** Before the first record to the right, or below on this X. ***/
+			for (iObjectNr = 1; iObjectNr <= iNr; iObjectNr++)
 			{
-				switch (iObject)
-				{
-					case 0x03: /*** raise (buttons) ***/
-						arRaiseYP[iCurLevel][iObjectNr] = iTempAttr1[iTempLoop];
-						arRaiseY[iCurLevel][iObjectNr] = iTempAttr2[iTempLoop];
-						arRaiseXP[iCurLevel][iObjectNr] = iTempAttr3[iTempLoop];
-						arRaiseX[iCurLevel][iObjectNr] = iTempAttr4[iTempLoop];
-						arRaiseGate1[iCurLevel][iObjectNr] = iTempAttr5[iTempLoop];
-						arRaiseGate2[iCurLevel][iObjectNr] = iTempAttr6[iTempLoop];
-						arRaiseGate3[iCurLevel][iObjectNr] = iTempAttr7[iTempLoop];
-						break;
-					case 0x04: /*** drop (buttons) ***/
-						arDropYP[iCurLevel][iObjectNr] = iTempAttr1[iTempLoop];
-						arDropY[iCurLevel][iObjectNr] = iTempAttr2[iTempLoop];
-						arDropXP[iCurLevel][iObjectNr] = iTempAttr3[iTempLoop];
-						arDropX[iCurLevel][iObjectNr] = iTempAttr4[iTempLoop];
-						arDropGate1[iCurLevel][iObjectNr] = iTempAttr5[iTempLoop];
-						arDropGate2[iCurLevel][iObjectNr] = iTempAttr6[iTempLoop];
-						arDropGate3[iCurLevel][iObjectNr] = iTempAttr7[iTempLoop];
-						break;
-					case 0x05: /*** gates ***/
-						arGateState1[iCurLevel][iObjectNr] = iTempAttr1[iTempLoop];
-						arGateYP[iCurLevel][iObjectNr] = iTempAttr2[iTempLoop];
-						arGateY[iCurLevel][iObjectNr] = iTempAttr3[iTempLoop];
-						arGateXP[iCurLevel][iObjectNr] = iTempAttr4[iTempLoop];
-						arGateX[iCurLevel][iObjectNr] = iTempAttr5[iTempLoop];
-						arGateState2[iCurLevel][iObjectNr] = iTempAttr6[iTempLoop];
-						arGateState3[iCurLevel][iObjectNr] = iTempAttr7[iTempLoop];
-						arGateUnk[iCurLevel][iObjectNr] = iTempAttr8[iTempLoop];
-						break;
-					case 0x06: /*** loose (floors) ***/
-						arLooseYP[iCurLevel][iObjectNr] = iTempAttr1[iTempLoop];
-						arLooseY[iCurLevel][iObjectNr] = iTempAttr2[iTempLoop];
-						arLooseXP[iCurLevel][iObjectNr] = iTempAttr3[iTempLoop];
-						arLooseX[iCurLevel][iObjectNr] = iTempAttr4[iTempLoop];
-						break;
-					case 0x07: /*** spikes ***/
-						arSpikeYP[iCurLevel][iObjectNr] = iTempAttr1[iTempLoop];
-						arSpikeY[iCurLevel][iObjectNr] = iTempAttr2[iTempLoop];
-						arSpikeXP[iCurLevel][iObjectNr] = iTempAttr3[iTempLoop];
-						arSpikeX[iCurLevel][iObjectNr] = iTempAttr4[iTempLoop];
-						break;
-					case 0x08: /*** chompers ***/
-						arChomperYP[iCurLevel][iObjectNr] = iTempAttr1[iTempLoop];
-						arChomperY[iCurLevel][iObjectNr] = iTempAttr2[iTempLoop];
-						arChomperXP[iCurLevel][iObjectNr] = iTempAttr3[iTempLoop];
-						arChomperX[iCurLevel][iObjectNr] = iTempAttr4[iTempLoop];
-						break;
-					case 0x09: /*** potions ***/
-						arPotionColor[iCurLevel][iObjectNr] = iTempAttr1[iTempLoop];
-						arPotionYP[iCurLevel][iObjectNr] = iTempAttr2[iTempLoop];
-						arPotionY[iCurLevel][iObjectNr] = iTempAttr3[iTempLoop];
-						arPotionXP[iCurLevel][iObjectNr] = iTempAttr4[iTempLoop];
-						arPotionX[iCurLevel][iObjectNr] = iTempAttr5[iTempLoop];
-						arPotionEffect[iCurLevel][iObjectNr] = iTempAttr6[iTempLoop];
-						break;
-					case 0x0A: /*** (level) doors ***/
-						arDoorType[iCurLevel][iObjectNr] = iTempAttr1[iTempLoop];
-						arDoorYP[iCurLevel][iObjectNr] = iTempAttr2[iTempLoop];
-						arDoorY[iCurLevel][iObjectNr] = iTempAttr3[iTempLoop];
-						arDoorXP[iCurLevel][iObjectNr] = iTempAttr4[iTempLoop];
-						arDoorX[iCurLevel][iObjectNr] = iTempAttr5[iTempLoop];
-						break;
-					case 0x0C: /*** guards ***/
-						arGuardYP[iCurLevel][iObjectNr] = iTempAttr1[iTempLoop];
-						arGuardY[iCurLevel][iObjectNr] = iTempAttr2[iTempLoop];
-						arGuardXP[iCurLevel][iObjectNr] = iTempAttr3[iTempLoop];
-						arGuardX[iCurLevel][iObjectNr] = iTempAttr4[iTempLoop];
-						arGuardDir[iCurLevel][iObjectNr] = iTempAttr5[iTempLoop];
-						arGuardSprite[iCurLevel][iObjectNr] = iTempAttr6[iTempLoop];
-						arGuardType[iCurLevel][iObjectNr] = iTempAttr7[iTempLoop];
-						arGuardSkill[iCurLevel][iObjectNr] = iTempAttr8[iTempLoop];
-						arGuardHP[iCurLevel][iObjectNr] = iTempAttr9[iTempLoop];
-						break;
-				}
-				iObjectNr++;
+				iRecordX = GetObjectX (iCurLevel, iObject, iObjectNr);
+				if (((iRecordX == iX) &&
+					(GetObjectY (iCurLevel, iObject, iObjectNr) > iY)) ||
+					(iRecordX > iX)) { break; }
 			}
-		}
+			IndexObjects (iCurLevel, iObject, 0);
+			InsertRecord (iCurLevel, iObject, iObjectNr, NULL);
+			SetRecordXY (iObject, ObjectRecord (iCurLevel, iObject, iObjectNr),
+				iX, iY);
+			JournalRecord (CHANGE_INSERT, iCurLevel, iObject, iObjectNr);
+			/*** Other attributes are added in UseTile(). ***/
+			IndexObjects (iCurLevel, iObject, 1);
+			break;
+		default:
+			printf ("[FAILED] Incorrect type: %i!\n", iType);
+			exit (EXIT_ERROR); break;
 	}
 }
 /*****************************************************************************/
@@ -8479,22 +7752,15 @@ void UpdateSkillHP (void)
 
 	iX = ((iCurX - 1) * WIDTH) + iSelectedX;
 	iY = ((iCurY - 1) * HEIGHT) + iSelectedY;
-	iHasGuard = HasObject (iX, iY, arGuardX[iCurLevel],
-		arGuardY[iCurLevel], arNrGuards[iCurLevel]);
+	iHasGuard = HasObject (iX, iY, 0x0C);
 	if (iHasGuard == 1)
 	{
-		iOldSkill = GetSelectedTileValue (arGuardSkill[iCurLevel],
-			arGuardX[iCurLevel], arGuardY[iCurLevel],
-			arNrGuards[iCurLevel], 0);
-		iOldHP = GetSelectedTileValue (arGuardHP[iCurLevel],
-			arGuardX[iCurLevel], arGuardY[iCurLevel],
-			arNrGuards[iCurLevel], 3);
+		iOldSkill = GetSelectedTileValue (0x0C, GUARD_SKILL, 0);
+		iOldHP = GetSelectedTileValue (0x0C, GUARD_HP, 3);
 		if ((iOldSkill != iNewSkill) || (iOldHP != iNewHP))
 		{
-			SetAttribute (iX, iY, arGuardX[iCurLevel], arGuardY[iCurLevel],
-				arGuardSkill[iCurLevel], arNrGuards[iCurLevel], iNewSkill);
-			SetAttribute (iX, iY, arGuardX[iCurLevel], arGuardY[iCurLevel],
-				arGuardHP[iCurLevel], arNrGuards[iCurLevel], iNewHP);
+			SetAttribute (iX, iY, 0x0C, GUARD_SKILL, iNewSkill);
+			SetAttribute (iX, iY, 0x0C, GUARD_HP, iNewHP);
 			iChanged++;
 		}
 	}
@@ -8513,6 +7779,7 @@ void RandomizeLevel (void)
 	/*** Used for looping. ***/
 	int iYLoop, iXLoop;
 
+	BeginEdits();
 	for (iYLoop = (arLevelHeight[iCurLevel] * HEIGHT); iYLoop >= 1;
 		iYLoop--)
 	{
@@ -8526,21 +7793,21 @@ void RandomizeLevel (void)
 
 			if (iXLoop > 1)
 			{
-				iObjectLeft = arLevelObjects[iCurLevel][iXLoop - 1][iYLoop];
+				iObjectLeft = GetTileObject (iCurLevel, iXLoop - 1, iYLoop);
 			} else {
 				iObjectLeft = 0x01; /*** wall ***/
 			}
 
 			if (iYLoop < (arLevelHeight[iCurLevel] * HEIGHT))
 			{
-				iObjectDown = arLevelObjects[iCurLevel][iXLoop][iYLoop + 1];
+				iObjectDown = GetTileObject (iCurLevel, iXLoop, iYLoop + 1);
 			} else {
 				iObjectDown = 0x01; /*** wall ***/
 			}
 
 			if ((iXLoop > 1) && (iYLoop < (arLevelHeight[iCurLevel] * HEIGHT)))
 			{
-				iObjectLeftDown = arLevelObjects[iCurLevel][iXLoop - 1][iYLoop + 1];
+				iObjectLeftDown = GetTileObject (iCurLevel, iXLoop - 1, iYLoop + 1);
 			} else {
 				iObjectLeftDown = 0x01; /*** wall ***/
 			}
@@ -8716,6 +7983,7 @@ void RandomizeLevel (void)
 			SetLocation (iXLoop, iYLoop, iRandomO, iRandomG);
 		}
 	}
+	EndEdits();
 	iChanged++;
 	PlaySound ("wav/ok_close.wav");
 }
@@ -8756,6 +8024,10 @@ int GuardSprite (int iType)
 void SingleSword (int iLevel, int iX, int iY)
 /*****************************************************************************/
 {
+	/*** Removes all swords, except the one at iX, iY of iLevel. ***/
+
+	struct tiles *stTiles;
+
 	/*** Used for looping. ***/
 	int iLevelLoop;
 	int iWidthLoop;
@@ -8763,29 +8035,34 @@ void SingleSword (int iLevel, int iX, int iY)
 
 	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
 	{
-		for (iWidthLoop = 1; iWidthLoop <=
-			(arLevelWidth[iLevelLoop] * WIDTH); iWidthLoop++)
+		stTiles = &arLevelTiles[iLevelLoop];
+		if (stTiles->iSwords == 1)
 		{
-			for (iHeightLoop = 1; iHeightLoop <=
-				(arLevelHeight[iLevelLoop] * HEIGHT); iHeightLoop++)
+			if ((iLevelLoop != iLevel) || (stTiles->iSwordX != iX) ||
+				(stTiles->iSwordY != iY))
+			{
+				RemoveSword (iLevelLoop, stTiles->iSwordX, stTiles->iSwordY);
+			}
+		} else if (stTiles->iSwords > 1) {
+			/*** Only a modified ROM can have this. ***/
+			for (iWidthLoop = 1; iWidthLoop <= stTiles->iWidth; iWidthLoop++)
 			{
-				if ((arLevelObjects[iLevelLoop][iWidthLoop][iHeightLoop] == 0x0B) &&
-					((iLevel != iLevelLoop) || (iWidthLoop != iX) ||
-					(iHeightLoop != iY)))
+				for (iHeightLoop = 1; iHeightLoop <= stTiles->iHeight;
+					iHeightLoop++)
 				{
-					if (iDebug == 1)
+					if ((GetTileObject (iLevelLoop, iWidthLoop, iHeightLoop) ==
+						0x0B) && ((iLevel != iLevelLoop) || (iWidthLoop != iX) ||
+						(iHeightLoop != iY)))
 					{
-						printf ("[  OK  ] Removing a sword from level %i: x=%i, y=%i\n",
-							iLevelLoop, iWidthLoop, iHeightLoop);
+						RemoveSword (iLevelLoop, iWidthLoop, iHeightLoop);
 					}
-					arLevelObjects[iLevelLoop][iWidthLoop][iHeightLoop] = 0x02;
 				}
 			}
 		}
 	}
 }
 /*****************************************************************************/
-void SaveSword (int iFd, int iLevel, int iX, int iY)
+void SaveSword (struct image *stImage, int iLevel, int iX, int iY)
 /*****************************************************************************/
 {
 	int iValue;
@@ -8793,69 +8070,69 @@ void SaveSword (int iFd, int iLevel, int iX, int iY)
 	/*** Level. ***/
 	switch (iEXEType)
 	{
-		case 1: lseek (iFd, 0x26D88, SEEK_SET); break; /*** US ***/
-		case 2: lseek (iFd, 0x57582, SEEK_SET); break; /*** EU ***/
+		case 1: stImage->iPos = 0x26D88; break; /*** US ***/
+		case 2: stImage->iPos = 0x57582; break; /*** EU ***/
 	}
-	WriteWord (iFd, iLevel - 1);
+	PutWord (stImage, iLevel - 1);
 
 	/* Level where the prince starts without his sword (and
 	 * thus can pick it up). Similar switch as above.
 	 */
 	switch (iEXEType)
 	{
-		case 1: lseek (iFd, 0x200B6, SEEK_SET); break; /*** US ***/
-		case 2: lseek (iFd, 0x5040A, SEEK_SET); break; /*** EU ***/
+		case 1: stImage->iPos = 0x200B6; break; /*** US ***/
+		case 2: stImage->iPos = 0x5040A; break; /*** EU ***/
 	}
-	WriteWord (iFd, iLevel - 1);
+	PutWord (stImage, iLevel - 1);
 
 	/*** YP room ***/
 	switch (iEXEType)
 	{
-		case 1: lseek (iFd, 0x26D94, SEEK_SET); break; /*** US ***/
-		case 2: lseek (iFd, 0x5758E, SEEK_SET); break; /*** EU ***/
+		case 1: stImage->iPos = 0x26D94; break; /*** US ***/
+		case 2: stImage->iPos = 0x5758E; break; /*** EU ***/
 	}
 	iValue = (ceil ((float)iY / HEIGHT) - 1) * (64 * HEIGHT);
-	WriteWord (iFd, iValue);
+	PutWord (stImage, iValue);
 
 	/*** XP room ***/
 	switch (iEXEType)
 	{
-		case 1: lseek (iFd, 0x26DA0, SEEK_SET); break; /*** US ***/
-		case 2: lseek (iFd, 0x5759A, SEEK_SET); break; /*** EU ***/
+		case 1: stImage->iPos = 0x26DA0; break; /*** US ***/
+		case 2: stImage->iPos = 0x5759A; break; /*** EU ***/
 	}
 	iValue = (ceil ((float)iX / WIDTH) - 1) * (32 * WIDTH);
-	WriteWord (iFd, iValue);
+	PutWord (stImage, iValue);
 
 	/*** YP tile ***/
 	switch (iEXEType)
 	{
-		case 1: lseek (iFd, 0x26DB6, SEEK_SET); break; /*** US ***/
-		case 2: lseek (iFd, 0x575B0, SEEK_SET); break; /*** EU ***/
+		case 1: stImage->iPos = 0x26DB6; break; /*** US ***/
+		case 2: stImage->iPos = 0x575B0; break; /*** EU ***/
 	}
-	WriteWord (iFd, (iY * 64) - 9);
+	PutWord (stImage, (iY * 64) - 9);
 
 	/*** XP tile ***/
 	switch (iEXEType)
 	{
-		case 1: lseek (iFd, 0x26DBC, SEEK_SET); break; /*** US ***/
-		case 2: lseek (iFd, 0x575B6, SEEK_SET); break; /*** EU ***/
+		case 1: stImage->iPos = 0x26DBC; break; /*** US ***/
+		case 2: stImage->iPos = 0x575B6; break; /*** EU ***/
 	}
-	WriteWord (iFd, (iX * 32) - 7);
+	PutWord (stImage, (iX * 32) - 7);
 
 	/*** Location to change to floor after pickup. ***/
 	switch (iEXEType)
 	{
 		case 1: /*** US ***/
-			lseek (iFd, 0x2230C, SEEK_SET);
+			stImage->iPos = 0x2230C;
 			iValue = 0xFF15E0 + ((iX - 1) * (arLevelHeight[iLevel] *
 				HEIGHT)) + (iY - 1);
-			WriteDWord (iFd, iValue);
+			PutDWord (stImage, iValue);
 			break;
 		case 2: /*** EU ***/
-			lseek (iFd, 0x526EC, SEEK_SET);
+			stImage->iPos = 0x526EC;
 			iValue = 0xFF167A + ((iX - 1) * (arLevelHeight[iLevel] *
 				HEIGHT)) + (iY - 1);
-			WriteDWord (iFd, iValue);
+			PutDWord (stImage, iValue);
 			break;
 	}
 }
@@ -8866,7 +8143,7 @@ void LevelResized (int iOldWidth, int iOldHeight)
 	/* There is no need to modify arLevelOffsetGraphics[] or
 	 * arLevelOffsetObjects[] here, but it IS necessary to
 	 * remove objects and such from rooms that are no longer
-	 * being used.
+	 * being used, and to resize the level's tiles.
 	 */
 
 	/*** Used for looping. ***/
@@ -8885,13 +8162,14 @@ void LevelResized (int iOldWidth, int iOldHeight)
 	if ((iOldWidth > arLevelWidth[iCurLevel]) ||
 		(iOldHeight > arLevelHeight[iCurLevel]))
 	{
+		BeginEdits();
 		if (iOldWidth > arLevelWidth[iCurLevel])
 		{
+			/*** Including the corner rooms, if the height shrinks too. ***/
 			for (iWidthLoop = arLevelWidth[iCurLevel] + 1;
 				iWidthLoop <= iOldWidth; iWidthLoop++)
 			{
-				for (iHeightLoop = 1; iHeightLoop <=
-					arLevelHeight[iCurLevel]; iHeightLoop++)
+				for (iHeightLoop = 1; iHeightLoop <= iOldHeight; iHeightLoop++)
 				{
 					ClearRoom (iWidthLoop, iHeightLoop);
 				}
@@ -8911,56 +8189,3924 @@ void LevelResized (int iOldWidth, int iOldHeight)
 			}
 			iChanged++;
 		}
+		EndEdits();
 		if (iCurX > arLevelWidth[iCurLevel])
 			{ iCurX = arLevelWidth[iCurLevel]; }
 		if (iCurY > arLevelHeight[iCurLevel])
 			{ iCurY = arLevelHeight[iCurLevel]; }
 	}
+
+	/*** Only now, because ClearRoom() uses the old tiles. ***/
+	JournalSize (iOldWidth, iOldHeight);
+	SizeTiles (iCurLevel, arLevelWidth[iCurLevel] * WIDTH,
+		arLevelHeight[iCurLevel] * HEIGHT);
 }
 /*****************************************************************************/
-void RaiseDropUpdate (int iObjectNr, int iDecInc)
+void CheckRange (int iOffset, int iBytes, int iSize, char *sWhat)
 /*****************************************************************************/
 {
-	/* This function is called after a gate was removed or added. It
-	 * updates gate numbers raise and drop buttons point to.
-	 */
+	/*** Prevents reading beyond the end of a (damaged) ROM. ***/
 
-	/*** Used for looping. ***/
-	int iRaiseLoop;
-	int iDropLoop;
+	if ((iOffset < 0) || (iBytes < 0) || (iOffset + iBytes > iSize))
+	{
+		printf ("[FAILED] Offset 0x%02X (%i bytes) for %s is outside the"
+			" ROM!\n", iOffset, iBytes, sWhat);
+		exit (EXIT_ERROR);
+	}
+}
+/*****************************************************************************/
+int GetWord (unsigned char *sData)
+/*****************************************************************************/
+{
+	return ((sData[0] << 8) | sData[1]);
+}
+/*****************************************************************************/
+int GetDWord (unsigned char *sData)
+/*****************************************************************************/
+{
+	return ((int)(((unsigned int)sData[0] << 24) | (sData[1] << 16) |
+		(sData[2] << 8) | sData[3]));
+}
+/*****************************************************************************/
+void ReadImage (struct image *stImage)
+/*****************************************************************************/
+{
+	/*** Reads the ROM through the session's descriptor. ***/
 
-	/*** raise ***/
-	if (arNrRaise[iCurLevel] != 0)
+	struct stat stStat;
+	int iRead, iDone;
+
+	if (fstat (stROM.iFd, &stStat) == -1)
+	{
+		printf ("[FAILED] Could not stat \"%s\": %s!\n",
+			sPathFile, strerror (errno));
+		exit (EXIT_ERROR);
+	}
+	stImage->iSize = stStat.st_size;
+	stImage->sData = (unsigned char *)malloc (stImage->iSize);
+	if (stImage->sData == NULL)
+	{
+		printf ("[FAILED] Could not allocate %i bytes!\n", stImage->iSize);
+		exit (EXIT_ERROR);
+	}
+	lseek (stROM.iFd, 0, SEEK_SET);
+	iDone = 0;
+	while (iDone < stImage->iSize)
 	{
-		for (iRaiseLoop = 1; iRaiseLoop <= arNrRaise[iCurLevel]; iRaiseLoop++)
+		iRead = read (stROM.iFd, stImage->sData + iDone, stImage->iSize - iDone);
+		if (iRead <= 0)
 		{
-			if ((arRaiseGate1[iCurLevel][iRaiseLoop] >= iObjectNr) &&
-				(arRaiseGate1[iCurLevel][iRaiseLoop] < 0xFFFD))
-				{ arRaiseGate1[iCurLevel][iRaiseLoop]+=iDecInc; }
-			if ((arRaiseGate2[iCurLevel][iRaiseLoop] >= iObjectNr) &&
-				(arRaiseGate2[iCurLevel][iRaiseLoop] < 0xFFFD))
-				{ arRaiseGate2[iCurLevel][iRaiseLoop]+=iDecInc; }
-			if ((arRaiseGate3[iCurLevel][iRaiseLoop] >= iObjectNr) &&
-				(arRaiseGate3[iCurLevel][iRaiseLoop] < 0xFFFD))
-				{ arRaiseGate3[iCurLevel][iRaiseLoop]+=iDecInc; }
+			printf ("[FAILED] Could not read \"%s\": %s!\n",
+				sPathFile, strerror (errno));
+			exit (EXIT_ERROR);
 		}
+		iDone+=iRead;
+	}
+	stImage->iPos = 0;
+	stImage->iFailed = 0;
+}
+/*****************************************************************************/
+int WriteImage (void)
+/*****************************************************************************/
+{
+	/* The working image is written to a temporary file next to the ROM,
+	 * which then replaces the ROM; see ReplaceROM(). A crash halfway through
+	 * a save thus leaves the ROM untouched. Returns 1 on success, 0 if the
+	 * ROM was not changed.
+	 */
+
+	struct image *stImage;
+	char sTemp[MAX_PATHFILE + 2];
+	struct stat stStat;
+	int iMode;
+	int iFd;
+	int iWritten, iDone;
+
+	stImage = &stROM.stWorking;
+	snprintf (sTemp, MAX_PATHFILE, "%s%s", sPathFile, TEMP_SUFFIX);
+	if (stat (sPathFile, &stStat) == 0)
+		{ iMode = stStat.st_mode & 0777; } else { iMode = 0600; }
+
+	iFd = open (sTemp, O_WRONLY|O_CREAT|O_TRUNC|O_BINARY, iMode);
+	if (iFd == -1)
+	{
+		printf ("[FAILED] Could not open \"%s\": %s!\n",
+			sTemp, strerror (errno));
+		return (0);
 	}
 
-	/*** drop ***/
-	if (arNrDrop[iCurLevel] != 0)
+	/*** A single write, unless the OS returns a partial one. ***/
+	iDone = 0;
+	while (iDone < stImage->iSize)
 	{
-		for (iDropLoop = 1; iDropLoop <= arNrDrop[iCurLevel]; iDropLoop++)
+		iWritten = write (iFd, stImage->sData + iDone, stImage->iSize - iDone);
+		if (iWritten <= 0)
 		{
-			if ((arDropGate1[iCurLevel][iDropLoop] >= iObjectNr) &&
-				(arDropGate1[iCurLevel][iDropLoop] < 0xFFFD))
-				{ arDropGate1[iCurLevel][iDropLoop]+=iDecInc; }
-			if ((arDropGate2[iCurLevel][iDropLoop] >= iObjectNr) &&
-				(arDropGate2[iCurLevel][iDropLoop] < 0xFFFD))
-				{ arDropGate2[iCurLevel][iDropLoop]+=iDecInc; }
-			if ((arDropGate3[iCurLevel][iDropLoop] >= iObjectNr) &&
-				(arDropGate3[iCurLevel][iDropLoop] < 0xFFFD))
-				{ arDropGate3[iCurLevel][iDropLoop]+=iDecInc; }
+			printf ("[FAILED] Could not write \"%s\": %s!\n",
+				sTemp, strerror (errno));
+			close (iFd);
+			unlink (sTemp);
+			return (0);
 		}
+		iDone+=iWritten;
+	}
+
+	return (ReplaceROM (iFd, sTemp));
+}
+/*****************************************************************************/
+void PutByte (struct image *stImage, int iValue)
+/*****************************************************************************/
+{
+	/*** Not an exit, so that a failed save keeps the changes. ***/
+	if ((stImage->iPos < 0) || (stImage->iPos >= stImage->iSize))
+	{
+		stImage->iFailed = 1;
+		return;
 	}
+	stImage->sData[stImage->iPos] = iValue & 0xFF;
+	stImage->iPos++;
+}
+/*****************************************************************************/
+void PutWord (struct image *stImage, int iValue)
+/*****************************************************************************/
+{
+	PutByte (stImage, iValue >> 8);
+	PutByte (stImage, iValue >> 0);
 }
 /*****************************************************************************/
+void PutDWord (struct image *stImage, int iValue)
+/*****************************************************************************/
+{
+	PutWord (stImage, iValue >> 16);
+	PutWord (stImage, iValue >> 0);
+}
+/*****************************************************************************/
+void CopyImage (struct image *stFrom, struct image *stTo)
+/*****************************************************************************/
+{
+	stTo->iSize = stFrom->iSize;
+	stTo->sData = (unsigned char *)malloc (stTo->iSize);
+	if (stTo->sData == NULL)
+	{
+		printf ("[FAILED] Could not allocate %i bytes!\n", stTo->iSize);
+		exit (EXIT_ERROR);
+	}
+	memcpy (stTo->sData, stFrom->sData, stTo->iSize);
+	stTo->iPos = 0;
+	stTo->iFailed = 0;
+}
+/*****************************************************************************/
+int WriteChanges (void)
+/*****************************************************************************/
+{
+	/* Saves only the byte ranges of the working image that differ from the
+	 * pristine image, which matters for ROMs on network storage. The ROM is
+	 * cloned to a temporary file, see DuplicateFile(), the ranges are
+	 * written into the clone, and the clone replaces the ROM; patching the
+	 * ROM in place would not survive a crash. If the ROM cannot be cloned,
+	 * the whole image is written instead. Returns 1 on success (also if
+	 * nothing changed), 0 if the ROM was not changed.
+	 */
+
+	unsigned char *sNew;
+	char sTemp[MAX_PATHFILE + 2];
+	struct stat stStat;
+	int iSize;
+	int iStart, iEnd;
+	int iRanges, iBytes;
+	int iFd;
+	int iWritten, iDone;
+
+	SetChecksum();
+
+	sNew = stROM.stWorking.sData;
+	iSize = stROM.stWorking.iSize;
+
+	iRanges = 0;
+	iBytes = 0;
+	for (iStart = NextRange (0, &iEnd); iStart < iSize;
+		iStart = NextRange (iEnd, &iEnd))
+	{
+		iRanges++;
+		iBytes+=(iEnd - iStart);
+	}
+	if (iDebug == 1)
+	{
+		printf ("[ INFO ] Saving %i changed range(s), %i byte(s).\n",
+			iRanges, iBytes);
+	}
+	if (iRanges == 0) { return (1); }
+
+	/*** The clone must be the pristine image, as far as we can tell. ***/
+	if ((stROM.iFd == -1) || (fstat (stROM.iFd, &stStat) == -1) ||
+		(stStat.st_size != iSize)) { return (WriteImage()); }
+	snprintf (sTemp, MAX_PATHFILE, "%s%s", sPathFile, TEMP_SUFFIX);
+	if (DuplicateFile (sPathFile, sTemp) == 0) { return (WriteImage()); }
+
+	iFd = open (sTemp, O_WRONLY|O_BINARY);
+	if (iFd == -1)
+	{
+		printf ("[FAILED] Could not open \"%s\": %s!\n",
+			sTemp, strerror (errno));
+		unlink (sTemp);
+		return (0);
+	}
+#if !(defined WIN32 || _WIN32 || WIN64 || _WIN64)
+	fchmod (iFd, stStat.st_mode & 0777);
+#endif
+
+	for (iStart = NextRange (0, &iEnd); iStart < iSize;
+		iStart = NextRange (iEnd, &iEnd))
+	{
+		iDone = iStart;
+		if (lseek (iFd, iStart, SEEK_SET) == -1) { iDone = -1; }
+		while ((iDone != -1) && (iDone < iEnd))
+		{
+			iWritten = write (iFd, sNew + iDone, iEnd - iDone);
+			if (iWritten <= 0) { iDone = -1; } else { iDone+=iWritten; }
+		}
+		if (iDone == -1)
+		{
+			printf ("[FAILED] Could not write \"%s\": %s!\n",
+				sTemp, strerror (errno));
+			close (iFd);
+			unlink (sTemp);
+			return (0);
+		}
+	}
+
+	return (ReplaceROM (iFd, sTemp));
+}
+/*****************************************************************************/
+void OpenROM (void)
+/*****************************************************************************/
+{
+	/* Opens the ROM session. The ROM is read once, through stROM.iFd. All
+	 * reads then use stPristine, and saves serialize into stWorking.
+	 */
+
+	stROM.iFd = open (sPathFile, O_RDWR|O_BINARY);
+	if (stROM.iFd == -1)
+	{
+		printf ("[FAILED] Could not open \"%s\": %s!\n",
+			sPathFile, strerror (errno));
+		exit (EXIT_ERROR);
+	}
+	ReadImage (&stROM.stPristine);
+	CopyImage (&stROM.stPristine, &stROM.stWorking);
+	stROM.iSaved = 0;
+}
+/*****************************************************************************/
+unsigned long CRC32 (unsigned char *sData, int iSize)
+/*****************************************************************************/
+{
+	/* The usual CRC-32, processing four bytes per step with four tables
+	 * ("slicing-by-4") instead of one byte per step.
+	 */
+
+	static unsigned long arTable[4][256];
+	static int iTableSet = 0;
+	unsigned long iCRC;
+	int iBit;
+
+	/*** Used for looping. ***/
+	int iByteLoop;
+	int iTableLoop;
+
+	if (iTableSet == 0)
+	{
+		for (iByteLoop = 0; iByteLoop <= 255; iByteLoop++)
+		{
+			iCRC = iByteLoop;
+			for (iBit = 1; iBit <= 8; iBit++)
+			{
+				if ((iCRC & 1) == 1)
+					{ iCRC = (iCRC >> 1) ^ 0xEDB88320UL; } else { iCRC >>= 1; }
+			}
+			arTable[0][iByteLoop] = iCRC;
+		}
+		for (iTableLoop = 1; iTableLoop <= 3; iTableLoop++)
+		{
+			for (iByteLoop = 0; iByteLoop <= 255; iByteLoop++)
+			{
+				iCRC = arTable[iTableLoop - 1][iByteLoop];
+				arTable[iTableLoop][iByteLoop] =
+					(iCRC >> 8) ^ arTable[0][iCRC & 0xFF];
+			}
+		}
+		iTableSet = 1;
+	}
+
+	iCRC = 0xFFFFFFFFUL;
+	iByteLoop = 0;
+	while (iByteLoop + 4 <= iSize)
+	{
+		iCRC ^= (unsigned long)sData[iByteLoop] |
+			((unsigned long)sData[iByteLoop + 1] << 8) |
+			((unsigned long)sData[iByteLoop + 2] << 16) |
+			((unsigned long)sData[iByteLoop + 3] << 24);
+		iCRC = arTable[3][iCRC & 0xFF] ^
+			arTable[2][(iCRC >> 8) & 0xFF] ^
+			arTable[1][(iCRC >> 16) & 0xFF] ^
+			arTable[0][(iCRC >> 24) & 0xFF];
+		iByteLoop+=4;
+	}
+	for (; iByteLoop < iSize; iByteLoop++)
+	{
+		iCRC = arTable[0][(iCRC ^ sData[iByteLoop]) & 0xFF] ^ (iCRC >> 8);
+	}
+
+	return (iCRC ^ 0xFFFFFFFFUL);
+}
+/*****************************************************************************/
+int ListBackups (char (**arBackups)[MAX_PATHFILE + 2])
+/*****************************************************************************/
+{
+	/* Fills (*arBackups)[1..] with all backups, oldest first. The caller
+	 * frees *arBackups, even if there are no backups.
+	 */
+
+	DIR *dDir;
+	struct dirent *stDirent;
+	int iNrBackups, iAlloc;
+	int iLen;
+
+	iNrBackups = 0;
+	iAlloc = BACKUPS + 2;
+	*arBackups = malloc (iAlloc * sizeof (**arBackups));
+	if (*arBackups == NULL)
+	{
+		printf ("[FAILED] Could not allocate the list of backups!\n");
+		exit (EXIT_ERROR);
+	}
+	dDir = opendir (ROM_DIR);
+	if (dDir == NULL) { return (0); }
+	while ((stDirent = readdir (dDir)) != NULL)
+	{
+		iLen = strlen (stDirent->d_name);
+		if ((strncmp (stDirent->d_name, BACKUP_PREFIX,
+			strlen (BACKUP_PREFIX)) == 0) &&
+			(iLen > (int)strlen (BACKUP_SUFFIX)) &&
+			(strcmp (stDirent->d_name + iLen - strlen (BACKUP_SUFFIX),
+			BACKUP_SUFFIX) == 0))
+		{
+			if (iNrBackups + 2 == iAlloc)
+			{
+				iAlloc*=2;
+				*arBackups = realloc (*arBackups, iAlloc * sizeof (**arBackups));
+				if (*arBackups == NULL)
+				{
+					printf ("[FAILED] Could not allocate the list of backups!\n");
+					exit (EXIT_ERROR);
+				}
+			}
+			iNrBackups++;
+			snprintf ((*arBackups)[iNrBackups], MAX_PATHFILE, "%s%s%s",
+				ROM_DIR, SLASH, stDirent->d_name);
+		}
+	}
+	closedir (dDir);
+
+	/*** The timestamps in the names sort chronologically. ***/
+	qsort ((*arBackups)[1], iNrBackups, sizeof (**arBackups), CompareNames);
+
+	return (iNrBackups);
+}
+/*****************************************************************************/
+int CompareNames (const void *vName1, const void *vName2)
+/*****************************************************************************/
+{
+	return (strcmp ((const char *)vName1, (const char *)vName2));
+}
+/*****************************************************************************/
+int DuplicateFile (char *sFrom, char *sTo)
+/*****************************************************************************/
+{
+	/* Returns 1 on success. Tries a reflink (copy-on-write clone) first, then
+	 * an in-kernel copy, and falls back to copying through a large buffer.
+	 */
+
+	int iFdFrom, iFdTo;
+	int iRead, iWritten;
+	unsigned char *sBuffer;
+	int iCopied;
+#if defined __linux__
+	struct stat stStat;
+	ssize_t iDone;
+	off_t iLeft;
+#endif
+
+	iFdFrom = open (sFrom, O_RDONLY|O_BINARY);
+	if (iFdFrom == -1)
+	{
+		printf ("[ WARN ] Could not open %s: %s!\n", sFrom, strerror (errno));
+		return (0);
+	}
+	iFdTo = open (sTo, O_WRONLY|O_CREAT|O_TRUNC|O_BINARY, 0600);
+	if (iFdTo == -1)
+	{
+		printf ("[ WARN ] Could not open %s: %s!\n", sTo, strerror (errno));
+		close (iFdFrom);
+		return (0);
+	}
+
+	iCopied = 0;
+#if defined __linux__
+#ifdef FICLONE
+	if (ioctl (iFdTo, FICLONE, iFdFrom) == 0) { iCopied = 1; }
+#endif
+#if defined __GLIBC__ && ((__GLIBC__ > 2) || \
+	((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 27)))
+	if ((iCopied == 0) && (fstat (iFdFrom, &stStat) == 0))
+	{
+		iLeft = stStat.st_size;
+		while (iLeft > 0)
+		{
+			iDone = copy_file_range (iFdFrom, NULL, iFdTo, NULL, iLeft, 0);
+			if (iDone <= 0) { break; }
+			iLeft-=iDone;
+		}
+		if (iLeft == 0)
+		{
+			iCopied = 1;
+		} else {
+			/*** Start over, below. ***/
+			lseek (iFdFrom, 0, SEEK_SET);
+			lseek (iFdTo, 0, SEEK_SET);
+			ftruncate (iFdTo, 0);
+		}
+	}
+#endif
+#endif
+
+	if (iCopied == 0)
+	{
+		sBuffer = (unsigned char *)malloc (COPY_BUFFER);
+		if (sBuffer == NULL)
+		{
+			printf ("[FAILED] Could not allocate %i bytes!\n", COPY_BUFFER);
+			exit (EXIT_ERROR);
+		}
+		iCopied = 1;
+		while ((iRead = read (iFdFrom, sBuffer, COPY_BUFFER)) > 0)
+		{
+			iWritten = write (iFdTo, sBuffer, iRead);
+			if (iWritten != iRead) { iCopied = 0; break; }
+		}
+		if (iRead < 0) { iCopied = 0; }
+		free (sBuffer);
+	}
+
+	close (iFdFrom);
+	close (iFdTo);
+
+	if (iCopied == 0)
+	{
+		printf ("[ WARN ] Could not copy %s to %s!\n", sFrom, sTo);
+		unlink (sTo);
+	}
+
+	return (iCopied);
+}
+/*****************************************************************************/
+int GetLevelSlice (unsigned char *sROM, int iROMSize, int iStartOffset,
+	int iLevel, int *iNr, int iObjectSize)
+/*****************************************************************************/
+{
+	/* Stores the number of objects of level iLevel in iNr, and returns the
+	 * offset of its first object. The objects of all levels directly follow
+	 * the table of numbers and offsets, in level order.
+	 */
+
+	int iOffset;
+
+	/*** Used for looping. ***/
+	int iLevelLoop;
+
+	CheckRange (iStartOffset, iNrLevels * 6, iROMSize, "table");
+	iOffset = iStartOffset + (iNrLevels * 6);
+	for (iLevelLoop = 1; iLevelLoop < iLevel; iLevelLoop++)
+	{
+		iOffset+=(GetWord (sROM + iStartOffset + ((iLevelLoop - 1) * 6))
+			* iObjectSize);
+	}
+	*iNr = GetWord (sROM + iStartOffset + ((iLevel - 1) * 6));
+	CheckRange (iOffset, *iNr * iObjectSize, iROMSize, "table");
+
+	return (iOffset);
+}
+/*****************************************************************************/
+void DiscardChanges (void)
+/*****************************************************************************/
+{
+	/* Restores the current level, and any other level changed since the last
+	 * save, from the pristine ROM image.
+	 */
+
+	int iJournalOld;
+
+	/*** Used for looping. ***/
+	int iLevelLoop;
+
+	if (iChanged == 0) { return; }
+
+	ClearChanges();
+	iJournalOld = iJournal;
+	iJournal = 0;
+	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
+	{
+		if ((iLevelLoop == iCurLevel) || (arLevelChanged[iLevelLoop] == 1))
+		{
+			LoadLevel (iLevelLoop);
+			arLevelChanged[iLevelLoop] = 0;
+			PrIfDe ("[  OK  ] Discarded the changes to a level.\n");
+		}
+	}
+	iJournal = iJournalOld;
+	iChanged = 0;
+}
+/*****************************************************************************/
+int LoadCache (void)
+/*****************************************************************************/
+{
+	/* Restores the parsed levels and EXE settings from the cache file, if
+	 * it was made from a ROM with the same CRC and size. Returns 1 on
+	 * success, 0 if the ROM must be parsed.
+	 */
+
+	char sCache[MAX_PATHFILE + 2];
+	struct stat stStat;
+	struct image stCache;
+	int iValid;
+
+	snprintf (sCache, MAX_PATHFILE, "%s%s", sPathFile, CACHE_SUFFIX);
+	if ((stat (sCache, &stStat) == -1) || (stStat.st_size < CACHE_HEADER))
+	{
+		PrIfDe ("[ INFO ] No cache file.\n");
+		return (0);
+	}
+
+	stCache.sData = ReadBuffer (sCache, &stCache.iSize);
+	if (stCache.sData == NULL) { return (0); }
+	iValid = 1;
+	if ((memcmp (stCache.sData, CACHE_MAGIC, 8) != 0) ||
+		((unsigned long)(unsigned int)GetDWord (stCache.sData + 8) !=
+		CRC32 (stROM.stPristine.sData, stROM.stPristine.iSize)) ||
+		(GetDWord (stCache.sData + 12) != stROM.stPristine.iSize) ||
+		((unsigned long)(unsigned int)GetDWord (stCache.sData + 16) !=
+		CRC32 (stCache.sData + CACHE_HEADER, stCache.iSize - CACHE_HEADER)))
+	{
+		iValid = 0;
+	}
+	if (iValid == 1)
+	{
+		SetTypeDefaults();
+		stCache.iPos = CACHE_HEADER;
+		iValid = CacheModel (&stCache, 0);
+	}
+	free (stCache.sData);
+
+	if (iValid == 0)
+	{
+		PrIfDe ("[ INFO ] The cache file is outdated.\n");
+	} else {
+		PrIfDe ("[  OK  ] Loaded the levels from the cache file.\n");
+	}
+
+	return (iValid);
+}
+/*****************************************************************************/
+void SaveCache (void)
+/*****************************************************************************/
+{
+	/* A cache file that cannot be written is not an error; the ROM is then
+	 * simply parsed again on the next start.
+	 */
+
+	char sCache[MAX_PATHFILE + 2];
+	char sTemp[MAX_PATHFILE + 2];
+	struct image stCache;
+	int iFd;
+
+	snprintf (sCache, MAX_PATHFILE, "%s%s", sPathFile, CACHE_SUFFIX);
+
+	/*** Determine the size, then store. ***/
+	stCache.sData = NULL;
+	stCache.iPos = CACHE_HEADER;
+	CacheModel (&stCache, 1);
+	stCache.iSize = stCache.iPos;
+	stCache.sData = (unsigned char *)malloc (stCache.iSize);
+	if (stCache.sData == NULL)
+	{
+		printf ("[FAILED] Could not allocate %i bytes!\n", stCache.iSize);
+		exit (EXIT_ERROR);
+	}
+	stCache.iPos = CACHE_HEADER;
+	CacheModel (&stCache, 1);
+
+	memcpy (stCache.sData, CACHE_MAGIC, 8);
+	stCache.iPos = 8;
+	PutDWord (&stCache,
+		CRC32 (stROM.stPristine.sData, stROM.stPristine.iSize));
+	PutDWord (&stCache, stROM.stPristine.iSize);
+	PutDWord (&stCache, CRC32 (stCache.sData + CACHE_HEADER,
+		stCache.iSize - CACHE_HEADER));
+
+	/*** Through a temporary file, so a torn write leaves the old cache. ***/
+	snprintf (sTemp, MAX_PATHFILE, "%s%s", sCache, TEMP_SUFFIX);
+	iFd = open (sTemp, O_WRONLY|O_CREAT|O_TRUNC|O_BINARY, 0600);
+	if ((iFd == -1) ||
+		(write (iFd, stCache.sData, stCache.iSize) != stCache.iSize))
+	{
+		printf ("[ WARN ] Could not write \"%s\": %s!\n",
+			sTemp, strerror (errno));
+		if (iFd != -1) { close (iFd); unlink (sTemp); }
+		free (stCache.sData);
+		return;
+	}
+	close (iFd);
+#if defined WIN32 || _WIN32 || WIN64 || _WIN64
+	if (MoveFileEx (sTemp, sCache, MOVEFILE_REPLACE_EXISTING) == 0)
+#else
+	if (rename (sTemp, sCache) == -1)
+#endif
+	{
+		printf ("[ WARN ] Could not replace \"%s\"!\n", sCache);
+		unlink (sTemp);
+	}
+	free (stCache.sData);
+}
+/*****************************************************************************/
+int CacheModel (struct image *stCache, int iSave)
+/*****************************************************************************/
+{
+	/* Walks the parsed levels and EXE settings in a fixed order, and stores
+	 * them in (iSave 1) or restores them from (iSave 0) stCache. When
+	 * storing without sData, only iPos advances. Returns 0 if the restored
+	 * data is not usable.
+	 */
+
+	int *arLevelValues[] = {
+		arPrinceYP, arPrinceY, arPrinceXP, arPrinceX, arPrinceDir,
+		arLevelHeightP, arLevelHeight, arLevelWidthP, arLevelWidth,
+		arLevelNrTiles, arLevelOffsetObjects, arLevelOffsetGraphics,
+		arLevelStartingY, arLevelStartingX, arLevelType };
+	int iNr;
+
+	/*** Used for looping. ***/
+	int iValueLoop;
+	int iLevelLoop;
+	int iTypeLoop;
+
+	/*** EXE settings. ***/
+	CacheInts (stCache, &iEXEStartingMin, 1, iSave);
+	CacheInts (stCache, &iEXEStartingSec, 1, iSave);
+	CacheInts (stCache, &iEXEStartingHP, 1, iSave);
+	CacheInts (stCache, &iEXEStartingLevel, 1, iSave);
+
+	/*** Level headers and prince. ***/
+	for (iValueLoop = 0; iValueLoop < (int)(sizeof (arLevelValues) /
+		sizeof (arLevelValues[0])); iValueLoop++)
+	{
+		CacheInts (stCache, arLevelValues[iValueLoop], MAX_LEVELS + 2, iSave);
+	}
+
+	/*** Everything below is bounded by these values. ***/
+	if (iSave == 0)
+	{
+		if (stCache->iPos > stCache->iSize) { return (0); }
+		for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
+		{
+			if ((arLevelWidth[iLevelLoop] < 0) ||
+				(arLevelWidth[iLevelLoop] > MAX_ROOMS) ||
+				(arLevelHeight[iLevelLoop] < 0) ||
+				(arLevelHeight[iLevelLoop] > MAX_ROOMS))
+			{
+				return (0);
+			}
+		}
+	}
+
+	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
+	{
+		/*** Tiles. ***/
+		if (iSave == 0)
+		{
+			SizeTiles (iLevelLoop, arLevelWidth[iLevelLoop] * WIDTH,
+				arLevelHeight[iLevelLoop] * HEIGHT);
+		}
+		iNr = arLevelTiles[iLevelLoop].iWidth * arLevelTiles[iLevelLoop].iHeight;
+		CacheBytes (stCache, arLevelTiles[iLevelLoop].sObjects, iNr, iSave);
+		CacheBytes (stCache, arLevelTiles[iLevelLoop].sGraphics, iNr, iSave);
+		if (iSave == 0) { CountSwords (iLevelLoop); }
+
+		/*** Objects with attributes, and guards. ***/
+		for (iTypeLoop = 0x03; iTypeLoop <= NR_TYPES; iTypeLoop++)
+		{
+			if (arTypes[iTypeLoop].iWords != 0)
+			{
+				iNr = arObjects[iLevelLoop][iTypeLoop].iNr;
+				CacheInts (stCache, &iNr, 1, iSave);
+				if (iSave == 0)
+				{
+					if ((stCache->iPos > stCache->iSize) || (iNr < 0) ||
+						(iNr > arTypes[iTypeLoop].iMax)) { return (0); }
+					IndexObjects (iLevelLoop, iTypeLoop, 0);
+					SizeObjects (iLevelLoop, iTypeLoop, iNr);
+				}
+				CacheWords (stCache, ObjectRecord (iLevelLoop, iTypeLoop, 1),
+					iNr * RecordWords (iTypeLoop), iSave);
+				if (iSave == 0) { IndexObjects (iLevelLoop, iTypeLoop, 1); }
+			}
+		}
+	}
+
+	/*** The cache must end exactly here. ***/
+	if ((iSave == 0) && (stCache->iPos != stCache->iSize)) { return (0); }
+
+	return (1);
+}
+/*****************************************************************************/
+void CacheInts (struct image *stCache, int *arValues, int iNr, int iSave)
+/*****************************************************************************/
+{
+	/*** Reading past the end leaves iPos past iSize; see CacheModel(). ***/
+
+	/*** Used for looping. ***/
+	int iValueLoop;
+
+	if ((iSave == 1) && (stCache->sData == NULL))
+	{
+		stCache->iPos+=(iNr * 4);
+		return;
+	}
+	if (iSave == 1)
+	{
+		for (iValueLoop = 0; iValueLoop < iNr; iValueLoop++)
+			{ PutDWord (stCache, arValues[iValueLoop]); }
+	} else {
+		if (stCache->iPos + (iNr * 4) > stCache->iSize)
+		{
+			stCache->iPos = stCache->iSize + 1;
+			return;
+		}
+		for (iValueLoop = 0; iValueLoop < iNr; iValueLoop++)
+		{
+			arValues[iValueLoop] = GetDWord (stCache->sData + stCache->iPos);
+			stCache->iPos+=4;
+		}
+	}
+}
+/*****************************************************************************/
+void CacheBytes (struct image *stCache, unsigned char *sValues, int iNr,
+	int iSave)
+/*****************************************************************************/
+{
+	if ((iSave == 1) && (stCache->sData == NULL))
+	{
+		stCache->iPos+=iNr;
+		return;
+	}
+	if (iSave == 1)
+	{
+		CheckRange (stCache->iPos, iNr, stCache->iSize, "cache");
+		memcpy (stCache->sData + stCache->iPos, sValues, iNr);
+	} else {
+		if (stCache->iPos + iNr > stCache->iSize)
+		{
+			stCache->iPos = stCache->iSize + 1;
+			return;
+		}
+		memcpy (sValues, stCache->sData + stCache->iPos, iNr);
+	}
+	stCache->iPos+=iNr;
+}
+/*****************************************************************************/
+void SetChecksum (void)
+/*****************************************************************************/
+{
+	/* Stores the cartridge header checksum, the sum of all big-endian words
+	 * from CHECKSUM_START to the end of the ROM, in the working image. The
+	 * sum is taken from memory, and the loop is simple enough for compilers
+	 * to vectorize.
+	 */
+
+	unsigned char *sData;
+	int iSize;
+	unsigned int iSumHigh, iSumLow;
+	int iChecksum;
+
+	/*** Used for looping. ***/
+	int iByteLoop;
+
+	sData = stROM.stWorking.sData;
+	iSize = stROM.stWorking.iSize & ~1;
+	if (iSize <= CHECKSUM_START) { return; }
+
+	iSumHigh = 0;
+	iSumLow = 0;
+	for (iByteLoop = CHECKSUM_START; iByteLoop < iSize; iByteLoop+=2)
+	{
+		iSumHigh+=sData[iByteLoop];
+		iSumLow+=sData[iByteLoop + 1];
+	}
+	iChecksum = ((iSumHigh << 8) + iSumLow) & 0xFFFF;
+
+	if (GetWord (sData + OFFSET_CHECKSUM) != iChecksum)
+	{
+		if (iDebug == 1)
+		{
+			printf ("[ INFO ] Header checksum: 0x%04X -> 0x%04X\n",
+				GetWord (sData + OFFSET_CHECKSUM), iChecksum);
+		}
+		stROM.stWorking.iPos = OFFSET_CHECKSUM;
+		PutWord (&stROM.stWorking, iChecksum);
+	}
+}
+/*****************************************************************************/
+void DefaultLayout (struct layout *stL, int iType)
+/*****************************************************************************/
+{
+	stL->iCRC = 0;
+	stL->iSize = 0;
+	stL->iEXEType = iType;
+	switch (iType)
+	{
+		case 1: /*** US ***/
+			stL->iNrLevels = NR_LEVELS_US;
+			stL->iOffsetPrince = OFFSET_PRINCE_US;
+			stL->iOffsetLevels = OFFSET_LEVELS_US;
+			stL->iOffsetGrOb = OFFSET_GR_OB_US;
+			stL->iOffsetGuards = OFFSET_GUARDS_US;
+			stL->iOffsetDoors = OFFSET_DOORS_US;
+			stL->iOffsetGates = OFFSET_GATES_US;
+			stL->iOffsetLoose = OFFSET_LOOSE_US;
+			stL->iOffsetRaise = OFFSET_RAISE_US;
+			stL->iOffsetDrop = OFFSET_DROP_US;
+			stL->iOffsetChompers = OFFSET_CHOMPERS_US;
+			stL->iOffsetSpikes = OFFSET_SPIKES_US;
+			stL->iOffsetPotions = OFFSET_POTIONS_US;
+			snprintf (stL->sName, MAX_TEXT, "%s", "US");
+			break;
+		case 2: /*** EU ***/
+			stL->iNrLevels = NR_LEVELS_EU;
+			stL->iOffsetPrince = OFFSET_PRINCE_EU;
+			stL->iOffsetLevels = OFFSET_LEVELS_EU;
+			stL->iOffsetGrOb = OFFSET_GR_OB_EU;
+			stL->iOffsetGuards = OFFSET_GUARDS_EU;
+			stL->iOffsetDoors = OFFSET_DOORS_EU;
+			stL->iOffsetGates = OFFSET_GATES_EU;
+			stL->iOffsetLoose = OFFSET_LOOSE_EU;
+			stL->iOffsetRaise = OFFSET_RAISE_EU;
+			stL->iOffsetDrop = OFFSET_DROP_EU;
+			stL->iOffsetChompers = OFFSET_CHOMPERS_EU;
+			stL->iOffsetSpikes = OFFSET_SPIKES_EU;
+			stL->iOffsetPotions = OFFSET_POTIONS_EU;
+			snprintf (stL->sName, MAX_TEXT, "%s", "EU");
+			break;
+	}
+}
+/*****************************************************************************/
+void LoadLayouts (void)
+/*****************************************************************************/
+{
+	/* Fills arLayouts with the built-in revisions, plus those in
+	 * ROM_DIR/LAYOUTS_FILE and in the LAYOUT_SUFFIX file of the ROM, and
+	 * sorts them for DetectLayout().
+	 */
+
+	char sFile[MAX_PATHFILE + 2];
+
+	iNrLayouts = 0;
+
+	/*** The EU ROM that comes with lemdop. ***/
+	iNrLayouts++;
+	DefaultLayout (&arLayouts[iNrLayouts], 2);
+	arLayouts[iNrLayouts].iCRC = 0x61DE6FE0UL;
+	arLayouts[iNrLayouts].iSize = 0x100000;
+	snprintf (arLayouts[iNrLayouts].sName, MAX_TEXT, "%s",
+		"EU (as included with lemdop)");
+
+	snprintf (sFile, MAX_PATHFILE, "%s%s%s", ROM_DIR, SLASH, LAYOUTS_FILE);
+	ReadLayouts (sFile);
+	snprintf (sFile, MAX_PATHFILE, "%s%s", sPathFile, LAYOUT_SUFFIX);
+	ReadLayouts (sFile);
+
+	qsort (&arLayouts[1], iNrLayouts, sizeof (struct layout), CompareLayouts);
+	if (iDebug == 1)
+		{ printf ("[ INFO ] Known ROM layouts: %i\n", iNrLayouts); }
+}
+/*****************************************************************************/
+int CompareLayouts (const void *vLayout1, const void *vLayout2)
+/*****************************************************************************/
+{
+	const struct layout *stL1, *stL2;
+
+	stL1 = (const struct layout *)vLayout1;
+	stL2 = (const struct layout *)vLayout2;
+	if (stL1->iCRC != stL2->iCRC)
+		{ return ((stL1->iCRC < stL2->iCRC) ? -1 : 1); }
+	if (stL1->iSize != stL2->iSize)
+		{ return ((stL1->iSize < stL2->iSize) ? -1 : 1); }
+	return (0);
+}
+/*****************************************************************************/
+int DetectLayout (void)
+/*****************************************************************************/
+{
+	/* Looks up the CRC32 and size of the ROM in arLayouts. Returns 1 and sets
+	 * stLayout and iEXEType if found, and if the layout fits the ROM.
+	 */
+
+	struct layout stKey;
+	struct layout *stFound;
+
+	stKey.iCRC = CRC32 (stROM.stPristine.sData, stROM.stPristine.iSize);
+	stKey.iSize = stROM.stPristine.iSize;
+	if (iDebug == 1)
+	{
+		printf ("[ INFO ] ROM CRC32: %08lX, size: %i\n",
+			stKey.iCRC, stKey.iSize);
+	}
+
+	stFound = (struct layout *)bsearch (&stKey, &arLayouts[1], iNrLayouts,
+		sizeof (struct layout), CompareLayouts);
+	if (stFound == NULL) { return (0); }
+	if (LayoutFits (stFound) == 0)
+	{
+		printf ("[ WARN ] Layout \"%s\" does not fit the ROM!\n",
+			stFound->sName);
+		return (0);
+	}
+
+	stLayout = *stFound;
+	iEXEType = stLayout.iEXEType;
+	if (iDebug == 1)
+		{ printf ("[  OK  ] Known ROM: %s\n", stLayout.sName); }
+
+	return (1);
+}
+/*****************************************************************************/
+int LayoutFits (struct layout *stL)
+/*****************************************************************************/
+{
+	/* Returns 1 if all tables of the layout are inside the ROM, and if the
+	 * level sizes and numbers of objects fit the editor's arrays. This keeps
+	 * relocated hacks from crashing LoadLevels().
+	 */
+
+	unsigned char *sROM;
+	int iSize;
+	unsigned char *sRec;
+	int iWidth, iHeight, iTiles;
+	int arStart[9 + 2], arRecord[9 + 2], arMax[9 + 2];
+	int iNr, iTotal;
+
+	/*** Used for looping. ***/
+	int iLevelLoop;
+	int iTableLoop;
+
+	sROM = stROM.stPristine.sData;
+	iSize = stROM.stPristine.iSize;
+
+	if ((stL->iNrLevels < 1) || (stL->iNrLevels > MAX_LEVELS)) { return (0); }
+	if ((stL->iOffsetPrince < 0) ||
+		(stL->iOffsetPrince + (stL->iNrLevels * 6) > iSize)) { return (0); }
+	if ((stL->iOffsetLevels < 0) ||
+		(stL->iOffsetLevels + (stL->iNrLevels * 20) > iSize)) { return (0); }
+
+	/*** Level headers. ***/
+	for (iLevelLoop = 1; iLevelLoop <= stL->iNrLevels; iLevelLoop++)
+	{
+		sRec = sROM + stL->iOffsetLevels + ((iLevelLoop - 1) * 20);
+		iHeight = GetWord (sRec + 0) / 192;
+		iWidth = GetWord (sRec + 2) / 320;
+		if ((iHeight > MAX_ROOMS) || (iWidth > MAX_ROOMS)) { return (0); }
+		iTiles = iWidth * WIDTH * iHeight * HEIGHT;
+		if ((GetDWord (sRec + 6) < 0) || (GetDWord (sRec + 6) > iSize - iTiles) ||
+			(GetDWord (sRec + 10) < 0) || (GetDWord (sRec + 10) > iSize - iTiles))
+			{ return (0); }
+	}
+
+	/*** Object tables. ***/
+	arStart[1] = stL->iOffsetGuards; arRecord[1] = 24; arMax[1] = MAX_GUARDS;
+	arStart[2] = stL->iOffsetDoors; arRecord[2] = 10; arMax[2] = MAX_DOORS;
+	arStart[3] = stL->iOffsetGates; arRecord[3] = 12; arMax[3] = MAX_GATES;
+	arStart[4] = stL->iOffsetLoose; arRecord[4] = 10; arMax[4] = MAX_LOOSE;
+	arStart[5] = stL->iOffsetRaise; arRecord[5] = 14; arMax[5] = MAX_RAISE;
+	arStart[6] = stL->iOffsetDrop; arRecord[6] = 14; arMax[6] = MAX_DROP;
+	arStart[7] = stL->iOffsetChompers; arRecord[7] = 10; arMax[7] = MAX_CHOMPER;
+	arStart[8] = stL->iOffsetSpikes; arRecord[8] = 8; arMax[8] = MAX_SPIKE;
+	arStart[9] = stL->iOffsetPotions; arRecord[9] = 10; arMax[9] = MAX_POTION;
+	for (iTableLoop = 1; iTableLoop <= 9; iTableLoop++)
+	{
+		if ((arStart[iTableLoop] < 0) ||
+			(arStart[iTableLoop] + (stL->iNrLevels * 6) > iSize)) { return (0); }
+		iTotal = 0;
+		for (iLevelLoop = 1; iLevelLoop <= stL->iNrLevels; iLevelLoop++)
+		{
+			iNr = GetWord (sROM + arStart[iTableLoop] + ((iLevelLoop - 1) * 6));
+			if (iNr > arMax[iTableLoop]) { return (0); }
+			iTotal+=iNr;
+		}
+		if (arStart[iTableLoop] + (stL->iNrLevels * 6) +
+			(iTotal * arRecord[iTableLoop]) > iSize) { return (0); }
+	}
+
+	return (1);
+}
+/*****************************************************************************/
+void SizeTiles (int iLevel, int iWidth, int iHeight)
+/*****************************************************************************/
+{
+	/* (Re)allocates the tiles of a level for iWidth x iHeight tiles. Tiles
+	 * that were already there keep their place; new tiles are 0x00.
+	 */
+
+	struct tiles stOld;
+	struct tiles *stTiles;
+	int iRooms;
+	int iCopyWidth, iCopyHeight;
+
+	/*** Used for looping. ***/
+	int iXLoop, iYLoop;
+	int iTypeLoop;
+
+	stTiles = &arLevelTiles[iLevel];
+	if ((stTiles->sObjects != NULL) && (stTiles->iWidth == iWidth) &&
+		(stTiles->iHeight == iHeight)) { return; }
+
+	/*** The rooms move, so snapshots of the level must keep them all. ***/
+	if (stTiles->sObjects != NULL) { KeepRooms (iLevel); }
+
+	stOld = *stTiles;
+	stTiles->iWidth = iWidth;
+	stTiles->iHeight = iHeight;
+	arTotals[TOTAL_ROOMS]+=(((iWidth / WIDTH) * (iHeight / HEIGHT)) -
+		((stOld.iWidth / WIDTH) * (stOld.iHeight / HEIGHT)));
+	stTiles->iRoomsX = (iWidth + WIDTH - 1) / WIDTH;
+	iRooms = stTiles->iRoomsX * ((iHeight + HEIGHT - 1) / HEIGHT);
+
+	/*** Plus 1, to never allocate 0 bytes. ***/
+	stTiles->sObjects = (unsigned char *)calloc ((iRooms * TILES) + 1, 1);
+	stTiles->sGraphics = (unsigned char *)calloc ((iRooms * TILES) + 1, 1);
+	stTiles->arRecords = (unsigned short *)calloc ((iRooms * TILES *
+		(NR_TYPES + 1)) + 1, sizeof (unsigned short));
+	if ((stTiles->sObjects == NULL) || (stTiles->sGraphics == NULL) ||
+		(stTiles->arRecords == NULL))
+	{
+		printf ("[FAILED] Could not allocate %i tiles!\n", iRooms * TILES);
+		exit (EXIT_ERROR);
+	}
+
+	if (stOld.sObjects != NULL)
+	{
+		iCopyWidth = (stOld.iWidth < iWidth) ? stOld.iWidth : iWidth;
+		iCopyHeight = (stOld.iHeight < iHeight) ? stOld.iHeight : iHeight;
+		for (iXLoop = 1; iXLoop <= iCopyWidth; iXLoop++)
+		{
+			for (iYLoop = 1; iYLoop <= iCopyHeight; iYLoop++)
+			{
+				stTiles->sObjects[TileIndex (stTiles, iXLoop, iYLoop)] =
+					stOld.sObjects[TileIndex (&stOld, iXLoop, iYLoop)];
+				stTiles->sGraphics[TileIndex (stTiles, iXLoop, iYLoop)] =
+					stOld.sGraphics[TileIndex (&stOld, iXLoop, iYLoop)];
+			}
+		}
+		free (stOld.sObjects);
+		free (stOld.sGraphics);
+		free (stOld.arRecords);
+	}
+
+	/*** The records did not move, but their tiles did. ***/
+	for (iTypeLoop = 0x03; iTypeLoop <= NR_TYPES; iTypeLoop++)
+	{
+		if (arTypes[iTypeLoop].iWords != 0)
+			{ IndexObjects (iLevel, iTypeLoop, 1); }
+	}
+	CountSwords (iLevel);
+}
+/*****************************************************************************/
+int GetTileObject (int iLevel, int iX, int iY)
+/*****************************************************************************/
+{
+	/*** Tiles outside the level are 0x00. ***/
+
+	struct tiles *stTiles;
+
+	stTiles = &arLevelTiles[iLevel];
+	if ((iX < 1) || (iX > stTiles->iWidth) ||
+		(iY < 1) || (iY > stTiles->iHeight)) { return (0x00); }
+
+	return (stTiles->sObjects[TileIndex (stTiles, iX, iY)]);
+}
+/*****************************************************************************/
+int GetTileGraphics (int iLevel, int iX, int iY)
+/*****************************************************************************/
+{
+	/*** Tiles outside the level are 0x00. ***/
+
+	struct tiles *stTiles;
+
+	stTiles = &arLevelTiles[iLevel];
+	if ((iX < 1) || (iX > stTiles->iWidth) ||
+		(iY < 1) || (iY > stTiles->iHeight)) { return (0x00); }
+
+	return (stTiles->sGraphics[TileIndex (stTiles, iX, iY)]);
+}
+/*****************************************************************************/
+void SetTileObject (int iLevel, int iX, int iY, int iValue)
+/*****************************************************************************/
+{
+	struct tiles *stTiles;
+	int iIndex;
+	int iOld;
+
+	stTiles = &arLevelTiles[iLevel];
+	if ((iX < 1) || (iX > stTiles->iWidth) ||
+		(iY < 1) || (iY > stTiles->iHeight)) { return; }
+
+	iIndex = TileIndex (stTiles, iX, iY);
+	iOld = stTiles->sObjects[iIndex];
+	JournalTile (CHANGE_OBJECT, iLevel, iX, iY, iOld, iValue);
+	KeepRoom (iLevel, iIndex / TILES);
+	stTiles->sObjects[iIndex] = iValue;
+
+	/*** Swords. ***/
+	if ((iOld == 0x0B) && (iValue != 0x0B))
+	{
+		stTiles->iSwords--;
+		if ((stTiles->iSwords != 0) &&
+			(iX == stTiles->iSwordX) && (iY == stTiles->iSwordY))
+			{ CountSwords (iLevel); }
+	} else if ((iOld != 0x0B) && (iValue == 0x0B)) {
+		stTiles->iSwords++;
+		if ((stTiles->iSwords == 1) || (iX > stTiles->iSwordX) ||
+			((iX == stTiles->iSwordX) && (iY > stTiles->iSwordY)))
+		{
+			stTiles->iSwordX = iX;
+			stTiles->iSwordY = iY;
+		}
+	}
+}
+/*****************************************************************************/
+void SetTileGraphics (int iLevel, int iX, int iY, int iValue)
+/*****************************************************************************/
+{
+	struct tiles *stTiles;
+
+	stTiles = &arLevelTiles[iLevel];
+	if ((iX < 1) || (iX > stTiles->iWidth) ||
+		(iY < 1) || (iY > stTiles->iHeight)) { return; }
+
+	JournalTile (CHANGE_GRAPHICS, iLevel, iX, iY,
+		stTiles->sGraphics[TileIndex (stTiles, iX, iY)], iValue);
+	KeepRoom (iLevel, TileIndex (stTiles, iX, iY) / TILES);
+	stTiles->sGraphics[TileIndex (stTiles, iX, iY)] = iValue;
+}
+/*****************************************************************************/
+void SizeObjects (int iLevel, int iObject, int iNr)
+/*****************************************************************************/
+{
+	/* Sets the number of records of an object value in a level. Records
+	 * that were already there keep their place; new records only have their
+	 * fixed words set, see FixedWords().
+	 */
+
+	struct objects *stObjects;
+	int iWords;
+	int iAlloc;
+	unsigned short *arWords;
+
+	/*** Used for looping. ***/
+	int iRecordLoop;
+
+	stObjects = &arObjects[iLevel][iObject];
+	iWords = RecordWords (iObject);
+	if ((stObjects->arWords == NULL) || (iNr > stObjects->iAlloc))
+	{
+		/*** Grow by doubling, to keep adding objects cheap. ***/
+		iAlloc = (stObjects->iAlloc > 0) ? stObjects->iAlloc : 8;
+		while (iAlloc < iNr) { iAlloc*=2; }
+		arWords = (unsigned short *)realloc (stObjects->arWords,
+			iAlloc * iWords * sizeof (unsigned short));
+		if (arWords == NULL)
+		{
+			printf ("[FAILED] Could not allocate %i %s!\n", iAlloc,
+				arTypes[iObject].sName);
+			exit (EXIT_ERROR);
+		}
+		stObjects->arWords = arWords;
+		stObjects->iAlloc = iAlloc;
+	}
+
+	for (iRecordLoop = stObjects->iNr + 1; iRecordLoop <= iNr; iRecordLoop++)
+		{ FixedWords (iObject, ObjectRecord (iLevel, iObject, iRecordLoop)); }
+	arTotals[iObject]+=(iNr - stObjects->iNr);
+	stObjects->iNr = iNr;
+}
+/*****************************************************************************/
+unsigned short *ObjectRecord (int iLevel, int iObject, int iNr)
+/*****************************************************************************/
+{
+	return (arObjects[iLevel][iObject].arWords +
+		((iNr - 1) * RecordWords (iObject)));
+}
+/*****************************************************************************/
+void FixedWords (int iObject, unsigned short *arRecord)
+/*****************************************************************************/
+{
+	/*** Clears a record, except for the words that are always the same. ***/
+
+	/*** Used for looping. ***/
+	int iWordLoop;
+
+	for (iWordLoop = 0; iWordLoop < RecordWords (iObject); iWordLoop++)
+	{
+		if ((arTypes[iObject].iFixed & (1 << iWordLoop)) != 0)
+		{
+			arRecord[iWordLoop] = arTypes[iObject].arFixed[iWordLoop];
+		} else {
+			arRecord[iWordLoop] = 0;
+		}
+	}
+}
+/*****************************************************************************/
+int RecordX (unsigned short *arRecord)
+/*****************************************************************************/
+{
+	return ((arRecord[FIELD_X] / 32) + 1);
+}
+/*****************************************************************************/
+int RecordY (int iObject, unsigned short *arRecord)
+/*****************************************************************************/
+{
+	if (arTypes[iObject].iTop == 1)
+	{
+		return (LoadYTop (arRecord[FIELD_Y]));
+	} else {
+		return (LoadYBottom (arRecord[FIELD_Y]));
+	}
+}
+/*****************************************************************************/
+void SetRecordXY (int iObject, unsigned short *arRecord, int iX, int iY)
+/*****************************************************************************/
+{
+	arRecord[FIELD_X] = (iX - 1) * 32;
+	if (arTypes[iObject].iTop == 1)
+	{
+		arRecord[FIELD_Y] = SaveYTop (iY);
+	} else {
+		arRecord[FIELD_Y] = SaveYBottom (iY);
+	}
+}
+/*****************************************************************************/
+int GetObjectX (int iLevel, int iObject, int iNr)
+/*****************************************************************************/
+{
+	return (RecordX (ObjectRecord (iLevel, iObject, iNr)));
+}
+/*****************************************************************************/
+int GetObjectY (int iLevel, int iObject, int iNr)
+/*****************************************************************************/
+{
+	return (RecordY (iObject, ObjectRecord (iLevel, iObject, iNr)));
+}
+/*****************************************************************************/
+int GetField (int iLevel, int iObject, int iNr, int iField)
+/*****************************************************************************/
+{
+	unsigned short *arRecord;
+
+	arRecord = ObjectRecord (iLevel, iObject, iNr);
+	if ((iObject == 0x0C) && (iField == GUARD_SPRITE))
+	{
+		return ((arRecord[iField] << 16) | arRecord[iField + 1]);
+	}
+	if (((iObject == 0x03) || (iObject == 0x04)) &&
+		(iField >= BUTTON_GATE1) && (iField <= BUTTON_GATE3) &&
+		(arRecord[iField] < 0xFFFD))
+	{
+		return (GateNumber (iLevel, arRecord + BUTTON_HANDLES +
+			((iField - BUTTON_GATE1) * 2)));
+	}
+
+	return (arRecord[iField]);
+}
+/*****************************************************************************/
+void SetField (int iLevel, int iObject, int iNr, int iField, int iValue)
+/*****************************************************************************/
+{
+	unsigned short arHandle[2];
+	int iHandle;
+
+	if ((iObject == 0x0C) && (iField == GUARD_SPRITE))
+	{
+		SetWord (iLevel, iObject, iNr, iField, (iValue >> 16) & 0xFFFF);
+		SetWord (iLevel, iObject, iNr, iField + 1, iValue & 0xFFFF);
+	} else {
+		SetWord (iLevel, iObject, iNr, iField, iValue & 0xFFFF);
+	}
+	if (((iObject == 0x03) || (iObject == 0x04)) &&
+		(iField >= BUTTON_GATE1) && (iField <= BUTTON_GATE3) &&
+		((iValue & 0xFFFF) < 0xFFFD))
+	{
+		GateHandle (iLevel, arHandle, iValue & 0xFFFF);
+		iHandle = BUTTON_HANDLES + ((iField - BUTTON_GATE1) * 2);
+		SetWord (iLevel, iObject, iNr, iHandle, arHandle[0]);
+		SetWord (iLevel, iObject, iNr, iHandle + 1, arHandle[1]);
+	}
+}
+/*****************************************************************************/
+int FindObject (int iLevel, int iObject, int iX, int iY)
+/*****************************************************************************/
+{
+	/*** Returns the number of the record at iX, iY, or 0. ***/
+
+	struct tiles *stTiles;
+
+	/*** Used for looping. ***/
+	int iObjectLoop;
+
+	stTiles = &arLevelTiles[iLevel];
+	if ((stTiles->arRecords != NULL) &&
+		(iX >= 1) && (iX <= stTiles->iWidth) &&
+		(iY >= 1) && (iY <= stTiles->iHeight))
+	{
+		return (*TileRecord (stTiles, iX, iY, iObject) & ~SHARED);
+	}
+
+	/*** Records outside the tiles are not indexed. ***/
+	for (iObjectLoop = 1; iObjectLoop <=
+		arObjects[iLevel][iObject].iNr; iObjectLoop++)
+	{
+		if ((ObjectRecord (iLevel, iObject, iObjectLoop)[FIELD_X] != DELETED_X) &&
+			(GetObjectX (iLevel, iObject, iObjectLoop) == iX) &&
+			(GetObjectY (iLevel, iObject, iObjectLoop) == iY))
+		{
+			return (iObjectLoop);
+		}
+	}
+
+	return (0);
+}
+/*****************************************************************************/
+void LoadObjects (unsigned char *sROM, int iROMSize, int iLevel, int iObject)
+/*****************************************************************************/
+{
+	struct type *stType;
+	unsigned short *arRecord;
+	unsigned char *sRec;
+	int iOffset;
+	int iNr;
+	int iSprite;
+	int iX, iY;
+
+	/*** Used for looping. ***/
+	int iRecordLoop;
+	int iWordLoop;
+
+	stType = &arTypes[iObject];
+	iOffset = GetLevelSlice (sROM, iROMSize, *stType->iOffset, iLevel,
+		&iNr, stType->iWords * 2);
+	IndexObjects (iLevel, iObject, 0);
+	SizeObjects (iLevel, iObject, 0);
+	SizeObjects (iLevel, iObject, iNr);
+	for (iRecordLoop = 1; iRecordLoop <= iNr; iRecordLoop++)
+	{
+		sRec = sROM + iOffset;
+		iOffset+=(stType->iWords * 2);
+
+		arRecord = ObjectRecord (iLevel, iObject, iRecordLoop);
+		for (iWordLoop = 0; iWordLoop < stType->iWords; iWordLoop++)
+		{
+			if ((stType->iFixed & (1 << iWordLoop)) != 0)
+			{
+				ObjectWarn (GetWord (sRec + (iWordLoop * 2)),
+					stType->arFixed[iWordLoop]);
+			} else {
+				arRecord[iWordLoop] = GetWord (sRec + (iWordLoop * 2));
+			}
+		}
+
+		/*** Store X and Y the way SaveLevels() has always written them. ***/
+		iX = RecordX (arRecord);
+		iY = RecordY (iObject, arRecord);
+		SetRecordXY (iObject, arRecord, iX, iY);
+
+		if (iObject == 0x0C)
+		{
+			iSprite = GetField (iLevel, 0x0C, iRecordLoop, GUARD_SPRITE);
+			switch (arRecord[GUARD_TYPE])
+			{
+				case 0: /*** guard ***/
+					if ((iSprite != 0x23838) && (iSprite != 0x53C8C))
+						{ printf ("[ WARN ] Unexpected sprite!\n"); }
+					break;
+				case 1: /*** skeleton ***/
+					if ((iSprite != 0x23954) && (iSprite != 0x53DA2))
+						{ printf ("[ WARN ] Unexpected sprite!\n"); }
+					break;
+				case 2: /*** fat ***/
+					if ((iSprite != 0x23DD8) && (iSprite != 0x54226))
+						{ printf ("[ WARN ] Unexpected sprite!\n"); }
+					break;
+				case 3: /*** shadow ***/
+					if ((iSprite != 0x24000) && (iSprite != 0x54448))
+						{ printf ("[ WARN ] Unexpected sprite!\n"); }
+					break;
+				case 4: /*** Jaffar ***/
+					if ((iSprite != 0x241B2) && (iSprite != 0x545FA))
+						{ printf ("[ WARN ] Unexpected sprite!\n"); }
+					break;
+			}
+		}
+
+		if (iDebug == 1)
+		{
+			printf ("[ INFO ] Level %i, %s %i: y=%i, x=%i, words:",
+				iLevel, stType->sName, iRecordLoop, iY, iX);
+			for (iWordLoop = 0; iWordLoop < stType->iWords; iWordLoop++)
+				{ printf (" %04X", arRecord[iWordLoop]); }
+			printf ("\n");
+		}
+	}
+	IndexObjects (iLevel, iObject, 1);
+}
+/*****************************************************************************/
+void SaveObjects (struct image *stImage, int iObject)
+/*****************************************************************************/
+{
+	/* Writes the table of an object value; all levels. Buttons get the
+	 * numbers their gates have now, see GateNumber().
+	 */
+
+	unsigned short *arRecord;
+
+	/*** Used for looping. ***/
+	int iLevelLoop;
+	int iRecordLoop;
+	int iWordLoop;
+
+	stImage->iPos = *arTypes[iObject].iOffset;
+	SetNrsAndOffsets (stImage, iObject);
+	for (iLevelLoop = 1; iLevelLoop <= iNrLevels; iLevelLoop++)
+	{
+		for (iRecordLoop = 1; iRecordLoop <=
+			arObjects[iLevelLoop][iObject].iNr; iRecordLoop++)
+		{
+			arRecord = ObjectRecord (iLevelLoop, iObject, iRecordLoop);
+			for (iWordLoop = 0; iWordLoop < arTypes[iObject].iWords; iWordLoop++)
+			{
+				if (((iObject == 0x03) || (iObject == 0x04)) &&
+					(iWordLoop >= BUTTON_GATE1) && (iWordLoop <= BUTTON_GATE3))
+				{
+					PutWord (stImage, GetField (iLevelLoop, iObject, iRecordLoop,
+						iWordLoop));
+				} else {
+					PutWord (stImage, arRecord[iWordLoop]);
+				}
+			}
+		}
+	}
+}
+/*****************************************************************************/
+void CacheWords (struct image *stCache, unsigned short *arValues, int iNr,
+	int iSave)
+/*****************************************************************************/
+{
+	/*** Used for looping. ***/
+	int iValueLoop;
+
+	if ((iSave == 1) && (stCache->sData == NULL))
+	{
+		stCache->iPos+=(iNr * 2);
+		return;
+	}
+	if (iSave == 1)
+	{
+		for (iValueLoop = 0; iValueLoop < iNr; iValueLoop++)
+			{ PutWord (stCache, arValues[iValueLoop]); }
+	} else {
+		if (stCache->iPos + (iNr * 2) > stCache->iSize)
+		{
+			stCache->iPos = stCache->iSize + 1;
+			return;
+		}
+		for (iValueLoop = 0; iValueLoop < iNr; iValueLoop++)
+		{
+			arValues[iValueLoop] = GetWord (stCache->sData + stCache->iPos);
+			stCache->iPos+=2;
+		}
+	}
+}
+/*****************************************************************************/
+int TileIndex (struct tiles *stTiles, int iX, int iY)
+/*****************************************************************************/
+{
+	/*** See struct tiles. iX and iY must be inside the level. ***/
+
+	int iRoom;
+
+	iRoom = (((iY - 1) / HEIGHT) * stTiles->iRoomsX) + ((iX - 1) / WIDTH);
+
+	return ((iRoom * TILES) + (((iY - 1) % HEIGHT) * WIDTH) +
+		((iX - 1) % WIDTH));
+}
+/*****************************************************************************/
+unsigned char *RoomObjects (int iLevel, int iRoomX, int iRoomY)
+/*****************************************************************************/
+{
+	/*** The TILES objects of a room, row by row. ***/
+
+	return (arLevelTiles[iLevel].sObjects + TileIndex (&arLevelTiles[iLevel],
+		((iRoomX - 1) * WIDTH) + 1, ((iRoomY - 1) * HEIGHT) + 1));
+}
+/*****************************************************************************/
+unsigned char *RoomGraphics (int iLevel, int iRoomX, int iRoomY)
+/*****************************************************************************/
+{
+	/*** The TILES graphics of a room, row by row. ***/
+
+	return (arLevelTiles[iLevel].sGraphics + TileIndex (&arLevelTiles[iLevel],
+		((iRoomX - 1) * WIDTH) + 1, ((iRoomY - 1) * HEIGHT) + 1));
+}
+/*****************************************************************************/
+unsigned short *TileRecord (struct tiles *stTiles, int iX, int iY,
+	int iObject)
+/*****************************************************************************/
+{
+	/*** See struct tiles. iX and iY must be inside the level. ***/
+
+	return (stTiles->arRecords + (TileIndex (stTiles, iX, iY) *
+		(NR_TYPES + 1)) + iObject);
+}
+/*****************************************************************************/
+void IndexObjects (int iLevel, int iObject, int iAdd)
+/*****************************************************************************/
+{
+	/* Adds (iAdd 1) the records of an object value in a level to the index
+	 * of its tiles, or removes (iAdd 0) them. Remove them before the records
+	 * change, and add them again after. When records share a tile, the
+	 * first one is indexed, as the old scan in FindObject() returned it.
+	 */
+
+	struct tiles *stTiles;
+	unsigned short *arRecord;
+	unsigned short *arEntry;
+	int iX, iY;
+
+	/*** Used for looping. ***/
+	int iRecordLoop;
+
+	stTiles = &arLevelTiles[iLevel];
+	if (stTiles->arRecords == NULL) { return; }
+	for (iRecordLoop = arObjects[iLevel][iObject].iNr; iRecordLoop >= 1;
+		iRecordLoop--)
+	{
+		arRecord = ObjectRecord (iLevel, iObject, iRecordLoop);
+		iX = RecordX (arRecord);
+		iY = RecordY (iObject, arRecord);
+		if ((arRecord[FIELD_X] != DELETED_X) &&
+			(iX >= 1) && (iX <= stTiles->iWidth) &&
+			(iY >= 1) && (iY <= stTiles->iHeight))
+		{
+			arEntry = TileRecord (stTiles, iX, iY, iObject);
+			if (iAdd == 0)
+			{
+				*arEntry = 0;
+			} else if (*arEntry != 0) {
+				*arEntry = iRecordLoop | SHARED;
+			} else {
+				*arEntry = iRecordLoop;
+			}
+		}
+	}
+}
+/*****************************************************************************/
+void IndexTile (int iLevel, int iObject, int iX, int iY)
+/*****************************************************************************/
+{
+	/*** Indexes the records at one tile again; see IndexObjects(). ***/
+
+	struct tiles *stTiles;
+	unsigned short *arRecord;
+	unsigned short *arEntry;
+
+	/*** Used for looping. ***/
+	int iRecordLoop;
+
+	stTiles = &arLevelTiles[iLevel];
+	arEntry = TileRecord (stTiles, iX, iY, iObject);
+	*arEntry = 0;
+	for (iRecordLoop = 1; iRecordLoop <= arObjects[iLevel][iObject].iNr;
+		iRecordLoop++)
+	{
+		arRecord = ObjectRecord (iLevel, iObject, iRecordLoop);
+		if ((arRecord[FIELD_X] != DELETED_X) && (RecordX (arRecord) == iX) &&
+			(RecordY (iObject, arRecord) == iY))
+		{
+			if (*arEntry != 0)
+			{
+				*arEntry|=SHARED;
+				break;
+			}
+			*arEntry = iRecordLoop;
+		}
+	}
+}
+/*****************************************************************************/
+void BeginEdits (void)
+/*****************************************************************************/
+{
+	/* Starts a batch of edits to the tiles of iCurLevel, such as filling a
+	 * room or the level. Until the matching EndEdits(), AddRemoveAttributes()
+	 * does not keep the records in order: removed records are marked with
+	 * DELETED_X and new ones are appended. Lookups through FindObject()
+	 * keep working. Batches may be nested.
+	 */
+
+	/*** Used for looping. ***/
+	int iTypeLoop;
+
+	if (iEdits == 0)
+	{
+		for (iTypeLoop = 0x03; iTypeLoop <= NR_TYPES; iTypeLoop++)
+			{ arEditsNr[iTypeLoop] = -1; }
+	}
+	iEdits++;
+}
+/*****************************************************************************/
+void EndEdits (void)
+/*****************************************************************************/
+{
+	/*** Puts each changed table in order, once; see MergeEdits(). ***/
+
+	/*** Used for looping. ***/
+	int iTypeLoop;
+
+	iEdits--;
+	if (iEdits > 0) { return; }
+
+	for (iTypeLoop = 0x03; iTypeLoop <= NR_TYPES; iTypeLoop++)
+	{
+		if (arEditsNr[iTypeLoop] != -1)
+			{ MergeEdits (iCurLevel, iTypeLoop, arEditsNr[iTypeLoop]); }
+	}
+}
+/*****************************************************************************/
+void EditAttributes (int iObject, int iX, int iY, int iType)
+/*****************************************************************************/
+{
+	/*** AddRemoveAttributes() during a batch; see BeginEdits(). ***/
+
+	struct tiles *stTiles;
+	unsigned short *arEntry;
+	int iInside;
+	int iNr;
+	int iObjectNr;
+
+	stTiles = &arLevelTiles[iCurLevel];
+	iInside = 0;
+	if ((stTiles->arRecords != NULL) &&
+		(iX >= 1) && (iX <= stTiles->iWidth) &&
+		(iY >= 1) && (iY <= stTiles->iHeight)) { iInside = 1; }
+	iNr = arObjects[iCurLevel][iObject].iNr;
+	if (arEditsNr[iObject] == -1) { arEditsNr[iObject] = iNr; }
+
+	switch (iType)
+	{
+		case 0: /*** remove ***/
+			while ((iObjectNr = FindObject (iCurLevel, iObject, iX, iY)) != 0)
+			{
+				SetWord (iCurLevel, iObject, iObjectNr, FIELD_X, DELETED_X);
+				if (iInside == 1)
+				{
+					arEntry = TileRecord (stTiles, iX, iY, iObject);
+					if ((*arEntry & SHARED) != 0)
+					{
+						IndexTile (iCurLevel, iObject, iX, iY);
+					} else {
+						*arEntry = 0;
+					}
+				}
+			}
+			break;
+		case 1: /*** add ***/
+			SizeObjects (iCurLevel, iObject, iNr + 1);
+			SetRecordXY (iObject, ObjectRecord (iCurLevel, iObject, iNr + 1),
+				iX, iY);
+			JournalRecord (CHANGE_INSERT, iCurLevel, iObject, iNr + 1);
+			if (iInside == 1)
+			{
+				/*** Records already at this tile come first. ***/
+				arEntry = TileRecord (stTiles, iX, iY, iObject);
+				if (*arEntry != 0)
+				{
+					*arEntry|=SHARED;
+				} else {
+					*arEntry = iNr + 1;
+				}
+			}
+			break;
+		default:
+			printf ("[FAILED] Incorrect type: %i!\n", iType);
+			exit (EXIT_ERROR); break;
+	}
+}
+/*****************************************************************************/
+void MergeEdits (int iLevel, int iObject, int iStart)
+/*****************************************************************************/
+{
+	/* Ends a batch for one object value. Of its records, the first iStart
+	 * were there before the batch. The new records are sorted, and merged
+	 * into the old ones the way AddRemoveAttributes() would have inserted
+	 * them; the records marked with DELETED_X are dropped.
+	 */
+
+	struct objects *stObjects;
+	struct change *stChange;
+	long long *arNew;
+	unsigned short *arWords;
+	unsigned short *arRecord;
+	int iWords;
+	int iNr;
+	int iNrNew;
+	int iNrLeft;
+	int iNrDropped;
+	int iOld, iNew;
+	int iFrom;
+	int iX, iY, iNewX, iNewY;
+
+	/*** Used for looping. ***/
+	int iRecordLoop;
+
+	stObjects = &arObjects[iLevel][iObject];
+	iWords = RecordWords (iObject);
+	iNr = stObjects->iNr;
+	if (iNr == 0) { return; }
+	stChange = NewChange (CHANGE_MERGE, iLevel);
+	if (stChange != NULL)
+	{
+		stChange->iObject = iObject;
+		stChange->iNr = iStart;
+		stChange->iOld = iNr;
+		stChange->arMap = (int *)malloc ((iNr + 1) * sizeof (int));
+		stChange->arWords = (unsigned short *)malloc
+			((iNr * iWords * sizeof (unsigned short)) + 1);
+		if ((stChange->arMap == NULL) || (stChange->arWords == NULL))
+		{
+			printf ("[FAILED] Could not allocate %i changes!\n", iNr);
+			exit (EXIT_ERROR);
+		}
+		CountBytes (stChange, (iNr + 1) * sizeof (int));
+	}
+	arNew = (long long *)malloc (((iNr - iStart) * sizeof (long long)) + 1);
+	arWords = (unsigned short *)malloc
+		((iNr * iWords * sizeof (unsigned short)) + 1);
+	if ((arNew == NULL) || (arWords == NULL))
+	{
+		printf ("[FAILED] Could not allocate %i %s!\n", iNr,
+			arTypes[iObject].sName);
+		exit (EXIT_ERROR);
+	}
+
+	/*** The new records, by X, then Y. They are all inside the level. ***/
+	iNrNew = 0;
+	for (iRecordLoop = iStart + 1; iRecordLoop <= iNr; iRecordLoop++)
+	{
+		arRecord = ObjectRecord (iLevel, iObject, iRecordLoop);
+		if (arRecord[FIELD_X] != DELETED_X)
+		{
+			arNew[iNrNew] = ((long long)RecordX (arRecord) << 32) |
+				((long long)RecordY (iObject, arRecord) << 16) | iRecordLoop;
+			iNrNew++;
+		}
+	}
+	qsort (arNew, iNrNew, sizeof (long long), CompareEdits);
+
+	/*** A new record goes before the first old one with a larger X or Y. ***/
+	IndexObjects (iLevel, iObject, 0);
+	iNrLeft = 0;
+	iNrDropped = 0;
+	iOld = 1;
+	iNew = 0;
+	while ((iOld <= iStart) || (iNew < iNrNew))
+	{
+		iFrom = 0;
+		if (iOld <= iStart)
+		{
+			arRecord = ObjectRecord (iLevel, iObject, iOld);
+			if ((iNew == iNrNew) || (arRecord[FIELD_X] == DELETED_X))
+			{
+				iFrom = iOld;
+			} else {
+				iX = RecordX (arRecord);
+				iY = RecordY (iObject, arRecord);
+				iNewX = (int)(arNew[iNew] >> 32);
+				iNewY = (int)((arNew[iNew] >> 16) & 0xFFFF);
+				if ((iX < iNewX) || ((iX == iNewX) && (iY <= iNewY)))
+					{ iFrom = iOld; }
+			}
+		}
+		if (iFrom != 0)
+		{
+			iOld++;
+		} else {
+			iFrom = (int)(arNew[iNew] & 0xFFFF);
+			iNew++;
+		}
+
+		arRecord = ObjectRecord (iLevel, iObject, iFrom);
+		if (arRecord[FIELD_X] != DELETED_X)
+		{
+			memcpy (arWords + (iNrLeft * iWords), arRecord,
+				iWords * sizeof (unsigned short));
+			iNrLeft++;
+			if (stChange != NULL) { stChange->arMap[iFrom] = iNrLeft; }
+		} else if (stChange != NULL) {
+			/*** For Undo(), the dropped records in order. ***/
+			stChange->arMap[iFrom] = 0;
+			memcpy (stChange->arWords + (iNrDropped * iWords), arRecord,
+				iWords * sizeof (unsigned short));
+			iNrDropped++;
+		}
+	}
+	if (stChange != NULL)
+	{
+		stChange->iNew = iNrLeft;
+
+		/*** Only the dropped records are kept. ***/
+		arRecord = (unsigned short *)realloc (stChange->arWords,
+			(iNrDropped * iWords * sizeof (unsigned short)) + 1);
+		if (arRecord != NULL) { stChange->arWords = arRecord; }
+		CountBytes (stChange, iNrDropped * iWords * sizeof (unsigned short));
+	}
+	memcpy (stObjects->arWords, arWords,
+		iNrLeft * iWords * sizeof (unsigned short));
+	SizeObjects (iLevel, iObject, iNrLeft);
+	IndexObjects (iLevel, iObject, 1);
+
+	free (arNew);
+	free (arWords);
+}
+/*****************************************************************************/
+int CompareEdits (const void *vEdit1, const void *vEdit2)
+/*****************************************************************************/
+{
+	long long llEdit1, llEdit2;
+
+	llEdit1 = *(const long long *)vEdit1;
+	llEdit2 = *(const long long *)vEdit2;
+	if (llEdit1 == llEdit2) { return (0); }
+
+	return ((llEdit1 < llEdit2) ? -1 : 1);
+}
+/*****************************************************************************/
+void CountSwords (int iLevel)
+/*****************************************************************************/
+{
+	/*** See struct tiles. ***/
+
+	struct tiles *stTiles;
+
+	/*** Used for looping. ***/
+	int iWidthLoop;
+	int iHeightLoop;
+
+	stTiles = &arLevelTiles[iLevel];
+	stTiles->iSwords = 0;
+	stTiles->iSwordX = 0;
+	stTiles->iSwordY = 0;
+	for (iWidthLoop = 1; iWidthLoop <= stTiles->iWidth; iWidthLoop++)
+	{
+		for (iHeightLoop = 1; iHeightLoop <= stTiles->iHeight; iHeightLoop++)
+		{
+			if (GetTileObject (iLevel, iWidthLoop, iHeightLoop) == 0x0B)
+			{
+				stTiles->iSwords++;
+				stTiles->iSwordX = iWidthLoop;
+				stTiles->iSwordY = iHeightLoop;
+			}
+		}
+	}
+}
+/*****************************************************************************/
+void RemoveSword (int iLevel, int iX, int iY)
+/*****************************************************************************/
+{
+	if (iDebug == 1)
+	{
+		printf ("[  OK  ] Removing a sword from level %i: x=%i, y=%i\n",
+			iLevel, iX, iY);
+	}
+	SetTileObject (iLevel, iX, iY, 0x02);
+	if (iLevel != iCurLevel) { arLevelChanged[iLevel] = 1; }
+}
+/*****************************************************************************/
+int RecordWords (int iObject)
+/*****************************************************************************/
+{
+	/*** The size of a record in memory; see struct objects. ***/
+
+	return (arTypes[iObject].iWords + arTypes[iObject].iExtra);
+}
+/*****************************************************************************/
+void GateHandles (int iLevel)
+/*****************************************************************************/
+{
+	/*** Gives the gate numbers of the loaded buttons their handles. ***/
+
+	/*** Used for looping. ***/
+	int iObject;
+	int iButtonLoop;
+	int iFieldLoop;
+
+	for (iObject = 0x03; iObject <= 0x04; iObject++)
+	{
+		for (iButtonLoop = 1; iButtonLoop <=
+			arObjects[iLevel][iObject].iNr; iButtonLoop++)
+		{
+			for (iFieldLoop = BUTTON_GATE1; iFieldLoop <= BUTTON_GATE3;
+				iFieldLoop++)
+			{
+				SetField (iLevel, iObject, iButtonLoop, iFieldLoop,
+					ObjectRecord (iLevel, iObject, iButtonLoop)[iFieldLoop]);
+			}
+		}
+	}
+}
+/*****************************************************************************/
+void GateHandle (int iLevel, unsigned short *arHandle, int iGate)
+/*****************************************************************************/
+{
+	/* Buttons do not keep the numbers of their gates, since those change
+	 * whenever a gate is added or removed before them. Instead, a handle
+	 * is the X and Y of the gate's tile. A number past the last gate is
+	 * stored as X 0, followed by how far past. GateNumber() turns a handle
+	 * back into a number; only SaveLevels() and the screens need those.
+	 */
+
+	unsigned short *arRecord;
+	int iNr;
+	int iGateNr;
+
+	iNr = arObjects[iLevel][0x05].iNr;
+	iGateNr = iGate + 1;
+
+	/*** During a batch, a removed gate is followed by the next one. ***/
+	while ((iGateNr <= iNr) &&
+		(ObjectRecord (iLevel, 0x05, iGateNr)[FIELD_X] == DELETED_X))
+		{ iGateNr++; }
+
+	if (iGateNr <= iNr)
+	{
+		arRecord = ObjectRecord (iLevel, 0x05, iGateNr);
+		arHandle[0] = RecordX (arRecord);
+		arHandle[1] = RecordY (0x05, arRecord);
+	} else {
+		arHandle[0] = 0;
+		arHandle[1] = (iGate > iNr) ? iGate - iNr : 0;
+	}
+}
+/*****************************************************************************/
+int GateNumber (int iLevel, unsigned short *arHandle)
+/*****************************************************************************/
+{
+	/* Returns the number of the gate of a handle, see GateHandle(). If
+	 * that gate was removed, this is the number of the first gate on a
+	 * later tile, or the number past the last gate.
+	 */
+
+	unsigned short *arRecord;
+	int iNr;
+	int iGate;
+	int iX, iY;
+
+	/*** Used for looping. ***/
+	int iGateLoop;
+
+	if (arHandle[0] != 0)
+	{
+		/*** During a batch of gate edits, the records are not in order. ***/
+		if ((iEdits == 0) || (iLevel != iCurLevel) || (arEditsNr[0x05] == -1))
+		{
+			iGate = FindObject (iLevel, 0x05, arHandle[0], arHandle[1]);
+			if (iGate != 0) { return (iGate - 1); }
+		}
+	}
+
+	/*** Records marked with DELETED_X do not count. ***/
+	iNr = 0;
+	for (iGateLoop = 1; iGateLoop <= arObjects[iLevel][0x05].iNr; iGateLoop++)
+	{
+		arRecord = ObjectRecord (iLevel, 0x05, iGateLoop);
+		if (arRecord[FIELD_X] == DELETED_X) { continue; }
+		iX = RecordX (arRecord);
+		iY = RecordY (0x05, arRecord);
+		if ((arHandle[0] != 0) && ((iX > arHandle[0]) ||
+			((iX == arHandle[0]) && (iY >= arHandle[1])))) { return (iNr); }
+		iNr++;
+	}
+	if (arHandle[0] == 0) { iNr+=arHandle[1]; }
+
+	return (iNr);
+}
+/*****************************************************************************/
+void SetWord (int iLevel, int iObject, int iNr, int iWord, int iValue)
+/*****************************************************************************/
+{
+	/*** Changes one word of a record; see SetField(). ***/
+
+	unsigned short *arRecord;
+	struct change *stChange;
+
+	arRecord = ObjectRecord (iLevel, iObject, iNr);
+	if (arRecord[iWord] == iValue) { return; }
+
+	stChange = NewChange (CHANGE_WORD, iLevel);
+	if (stChange != NULL)
+	{
+		stChange->iObject = iObject;
+		stChange->iNr = iNr;
+		stChange->iX = iWord;
+		stChange->iOld = arRecord[iWord];
+		stChange->iNew = iValue;
+	}
+	arRecord[iWord] = iValue;
+}
+/*****************************************************************************/
+void SetLevelValue (int *iValue, int iNew)
+/*****************************************************************************/
+{
+	/*** For values of iCurLevel such as arLevelType[], to allow Undo(). ***/
+
+	struct change *stChange;
+
+	if (*iValue == iNew) { return; }
+
+	stChange = NewChange (CHANGE_INT, iCurLevel);
+	if (stChange != NULL)
+	{
+		stChange->iValue = iValue;
+		stChange->iOld = *iValue;
+		stChange->iNew = iNew;
+	}
+	*iValue = iNew;
+}
+/*****************************************************************************/
+struct change *NewChange (int iType, int iLevel)
+/*****************************************************************************/
+{
+	/* Returns a cleared change at the end of the journal, or NULL if this
+	 * change is not kept. Changes that could be redone are dropped. If the
+	 * ring is full, or the changes hold more than UNDO_BYTES, the oldest
+	 * groups are dropped; if the current group does not fit at all, the
+	 * journal is cleared, since nothing before it could be undone anymore.
+	 */
+
+	struct change *stChange;
+	int iOldest;
+
+	if ((iJournal == 0) || (iUndoSize == 0)) { return (NULL); }
+	if (arChanges == NULL)
+	{
+		arChanges = (struct change *)calloc (iUndoSize, sizeof (struct change));
+		if (arChanges == NULL)
+		{
+			printf ("[FAILED] Could not allocate %i changes!\n", iUndoSize);
+			exit (EXIT_ERROR);
+		}
+	}
+
+	while (iChangesNr > iChangesDone)
+	{
+		FreeChange (GetChange (iChangesNr - 1));
+		iChangesNr--;
+	}
+
+	if (iGroupOpen == 0)
+	{
+		iGroup++;
+		iGroupOpen = 1;
+		iGroupLost = 0;
+	}
+	if (iGroupLost == 1) { return (NULL); }
+
+	while ((iChangesNr == iUndoSize) ||
+		((iChangesNr > 0) && (iChangesBytes > UNDO_BYTES)))
+	{
+		iOldest = GetChange (0)->iGroup;
+		if (iOldest == iGroup)
+		{
+			ClearChanges();
+			iGroupLost = 1;
+			PrIfDe ("[ WARN ] This change is too large to undo.\n");
+			return (NULL);
+		}
+		while ((iChangesNr > 0) && (GetChange (0)->iGroup == iOldest))
+		{
+			FreeChange (GetChange (0));
+			iChangesFirst = (iChangesFirst + 1) % iUndoSize;
+			iChangesNr--;
+			iChangesDone--;
+		}
+	}
+
+	stChange = GetChange (iChangesNr);
+	memset (stChange, 0, sizeof (struct change));
+	stChange->iGroup = iGroup;
+	stChange->iType = iType;
+	stChange->iLevel = iLevel;
+	iChangesNr++;
+	iChangesDone++;
+
+	return (stChange);
+}
+/*****************************************************************************/
+struct change *GetChange (int iChange)
+/*****************************************************************************/
+{
+	/*** Change iChange of the journal, from 0 (the oldest). ***/
+
+	return (&arChanges[(iChangesFirst + iChange) % iUndoSize]);
+}
+/*****************************************************************************/
+void FreeChange (struct change *stChange)
+/*****************************************************************************/
+{
+	if (stChange->arWords != NULL) { free (stChange->arWords); }
+	if (stChange->arMap != NULL) { free (stChange->arMap); }
+	if (stChange->arTiles != NULL) { free (stChange->arTiles); }
+	stChange->arWords = NULL;
+	stChange->arMap = NULL;
+	stChange->arTiles = NULL;
+	iChangesBytes -= stChange->iBytes;
+	stChange->iBytes = 0;
+}
+/*****************************************************************************/
+void ClearChanges (void)
+/*****************************************************************************/
+{
+	/*** Forgets all changes; for when the level is reloaded or left. ***/
+
+	/*** Used for looping. ***/
+	int iChangeLoop;
+
+	for (iChangeLoop = 0; iChangeLoop < iChangesNr; iChangeLoop++)
+		{ FreeChange (GetChange (iChangeLoop)); }
+	iChangesFirst = 0;
+	iChangesNr = 0;
+	iChangesDone = 0;
+}
+/*****************************************************************************/
+void CloseChanges (void)
+/*****************************************************************************/
+{
+	/*** The next change starts a new group; called for each event. ***/
+
+	iGroupOpen = 0;
+}
+/*****************************************************************************/
+void JournalTile (int iType, int iLevel, int iX, int iY, int iOld,
+	int iNew)
+/*****************************************************************************/
+{
+	/* Call before the object or graphics of a tile change. The tiles of a
+	 * group go into one CHANGE_TILES run, of up to TILE_RUN tiles, as long
+	 * as no other change comes between them.
+	 */
+
+	struct change *stChange;
+	struct tilechange *arTiles;
+	int iAlloc;
+
+	if (iOld == (iNew & 0xFF)) { return; }
+
+	stChange = NULL;
+	if ((iJournal == 1) && (iChangesNr > 0) && (iChangesNr == iChangesDone)
+		&& (iGroupOpen == 1) && (iGroupLost == 0))
+	{
+		stChange = GetChange (iChangesNr - 1);
+		if ((stChange->iType != CHANGE_TILES) ||
+			(stChange->iGroup != iGroup) || (stChange->iLevel != iLevel) ||
+			(stChange->iTiles == TILE_RUN)) { stChange = NULL; }
+	}
+	if (stChange == NULL)
+	{
+		stChange = NewChange (CHANGE_TILES, iLevel);
+		if (stChange == NULL) { return; }
+	}
+
+	if (stChange->iTiles == stChange->iTilesAlloc)
+	{
+		iAlloc = (stChange->iTilesAlloc == 0) ? 16 : stChange->iTilesAlloc * 2;
+		arTiles = (struct tilechange *)realloc (stChange->arTiles,
+			iAlloc * sizeof (struct tilechange));
+		if (arTiles == NULL)
+		{
+			printf ("[FAILED] Could not allocate %i changes!\n", iAlloc);
+			exit (EXIT_ERROR);
+		}
+		CountBytes (stChange, (iAlloc - stChange->iTilesAlloc) *
+			sizeof (struct tilechange));
+		stChange->arTiles = arTiles;
+		stChange->iTilesAlloc = iAlloc;
+	}
+	arTiles = &stChange->arTiles[stChange->iTiles];
+	arTiles->iX = iX;
+	arTiles->iY = iY;
+	arTiles->iType = iType;
+	arTiles->iOld = iOld;
+	arTiles->iNew = iNew & 0xFF;
+	stChange->iTiles++;
+}
+/*****************************************************************************/
+void JournalRecord (int iType, int iLevel, int iObject, int iNr)
+/*****************************************************************************/
+{
+	/* Call after record iNr was added (CHANGE_INSERT), or before it is
+	 * removed (CHANGE_REMOVE).
+	 */
+
+	struct change *stChange;
+	int iWords;
+
+	stChange = NewChange (iType, iLevel);
+	if (stChange == NULL) { return; }
+
+	iWords = RecordWords (iObject);
+	stChange->iObject = iObject;
+	stChange->iNr = iNr;
+	stChange->arWords = (unsigned short *)malloc
+		(iWords * sizeof (unsigned short));
+	if (stChange->arWords == NULL)
+	{
+		printf ("[FAILED] Could not allocate a change!\n");
+		exit (EXIT_ERROR);
+	}
+	memcpy (stChange->arWords, ObjectRecord (iLevel, iObject, iNr),
+		iWords * sizeof (unsigned short));
+	CountBytes (stChange, iWords * sizeof (unsigned short));
+}
+/*****************************************************************************/
+void JournalSize (int iOldWidth, int iOldHeight)
+/*****************************************************************************/
+{
+	/*** Call before SizeTiles() follows a resize of iCurLevel. ***/
+
+	struct change *stChange;
+
+	stChange = NewChange (CHANGE_SIZE, iCurLevel);
+	if (stChange != NULL)
+	{
+		stChange->iOld = (iOldWidth * 256) + iOldHeight;
+		stChange->iNew = (arLevelWidth[iCurLevel] * 256) +
+			arLevelHeight[iCurLevel];
+	}
+}
+/*****************************************************************************/
+void InsertRecord (int iLevel, int iObject, int iNr, unsigned short *arWords)
+/*****************************************************************************/
+{
+	/* Inserts a record before record iNr, moving the records after it. The
+	 * new record gets arWords, or only its fixed words if that is NULL. The
+	 * index is not updated; see IndexObjects().
+	 */
+
+	int iWords;
+	int iNrOld;
+
+	iWords = RecordWords (iObject);
+	iNrOld = arObjects[iLevel][iObject].iNr;
+	SizeObjects (iLevel, iObject, iNrOld + 1);
+	memmove (ObjectRecord (iLevel, iObject, iNr + 1),
+		ObjectRecord (iLevel, iObject, iNr),
+		(iNrOld + 1 - iNr) * iWords * sizeof (unsigned short));
+	if (arWords != NULL)
+	{
+		memcpy (ObjectRecord (iLevel, iObject, iNr), arWords,
+			iWords * sizeof (unsigned short));
+	} else {
+		FixedWords (iObject, ObjectRecord (iLevel, iObject, iNr));
+	}
+}
+/*****************************************************************************/
+void DeleteRecord (int iLevel, int iObject, int iNr)
+/*****************************************************************************/
+{
+	/*** Removes record iNr; see InsertRecord(). ***/
+
+	int iNrOld;
+
+	iNrOld = arObjects[iLevel][iObject].iNr;
+	memmove (ObjectRecord (iLevel, iObject, iNr),
+		ObjectRecord (iLevel, iObject, iNr + 1),
+		(iNrOld - iNr) * RecordWords (iObject) * sizeof (unsigned short));
+	SizeObjects (iLevel, iObject, iNrOld - 1);
+}
+/*****************************************************************************/
+void ApplyChange (struct change *stChange, int iRedo)
+/*****************************************************************************/
+{
+	/* Undoes (iRedo 0) or redoes (iRedo 1) one change. The changes of a
+	 * group must be undone newest first, and redone oldest first.
+	 */
+
+	unsigned short *arWords;
+	struct tilechange *stTile;
+	int iLevel;
+	int iObject;
+	int iValue;
+	int iWords;
+	int iNrDropped;
+
+	/*** Used for looping. ***/
+	int iRecordLoop;
+	int iTypeLoop;
+	int iTileLoop;
+
+	iLevel = stChange->iLevel;
+	iObject = stChange->iObject;
+	iValue = (iRedo == 1) ? stChange->iNew : stChange->iOld;
+	switch (stChange->iType)
+	{
+		case CHANGE_TILES:
+			for (iTileLoop = 0; iTileLoop < stChange->iTiles; iTileLoop++)
+			{
+				stTile = &stChange->arTiles[(iRedo == 1) ? iTileLoop :
+					stChange->iTiles - 1 - iTileLoop];
+				iValue = (iRedo == 1) ? stTile->iNew : stTile->iOld;
+				if (stTile->iType == CHANGE_OBJECT)
+				{
+					SetTileObject (iLevel, stTile->iX, stTile->iY, iValue);
+				} else {
+					SetTileGraphics (iLevel, stTile->iX, stTile->iY, iValue);
+				}
+			}
+			break;
+		case CHANGE_WORD:
+			Reindex (iLevel, iObject);
+			ObjectRecord (iLevel, iObject, stChange->iNr)[stChange->iX] = iValue;
+			break;
+		case CHANGE_INSERT:
+		case CHANGE_REMOVE:
+			Reindex (iLevel, iObject);
+			if ((stChange->iType == CHANGE_INSERT) == (iRedo == 1))
+			{
+				InsertRecord (iLevel, iObject, stChange->iNr, stChange->arWords);
+			} else {
+				DeleteRecord (iLevel, iObject, stChange->iNr);
+			}
+			break;
+		case CHANGE_MERGE:
+			if (iRedo == 1)
+			{
+				MergeEdits (iLevel, iObject, stChange->iNr);
+				if (arReindex[iLevel][iObject] == 1)
+					{ IndexObjects (iLevel, iObject, 0); }
+				break;
+			}
+
+			/*** Put back the records of before the merge, in their order. ***/
+			Reindex (iLevel, iObject);
+			iWords = RecordWords (iObject);
+			arWords = (unsigned short *)malloc
+				((stChange->iOld * iWords * sizeof (unsigned short)) + 1);
+			if (arWords == NULL)
+			{
+				printf ("[FAILED] Could not allocate %i %s!\n", stChange->iOld,
+					arTypes[iObject].sName);
+				exit (EXIT_ERROR);
+			}
+			iNrDropped = 0;
+			for (iRecordLoop = 1; iRecordLoop <= stChange->iOld; iRecordLoop++)
+			{
+				if (stChange->arMap[iRecordLoop] != 0)
+				{
+					memcpy (arWords + ((iRecordLoop - 1) * iWords),
+						ObjectRecord (iLevel, iObject, stChange->arMap[iRecordLoop]),
+						iWords * sizeof (unsigned short));
+				} else {
+					memcpy (arWords + ((iRecordLoop - 1) * iWords),
+						stChange->arWords + (iNrDropped * iWords),
+						iWords * sizeof (unsigned short));
+					iNrDropped++;
+				}
+			}
+			SizeObjects (iLevel, iObject, stChange->iOld);
+			memcpy (ObjectRecord (iLevel, iObject, 1), arWords,
+				stChange->iOld * iWords * sizeof (unsigned short));
+			free (arWords);
+			break;
+		case CHANGE_SIZE:
+			arLevelWidth[iLevel] = iValue / 256;
+			arLevelHeight[iLevel] = iValue % 256;
+			arLevelNrTiles[iLevel] = arLevelWidth[iLevel] *
+				arLevelHeight[iLevel] * TILES;
+			SizeTiles (iLevel, arLevelWidth[iLevel] * WIDTH,
+				arLevelHeight[iLevel] * HEIGHT);
+
+			/*** SizeTiles() indexed all records. ***/
+			for (iTypeLoop = 0x03; iTypeLoop <= NR_TYPES; iTypeLoop++)
+			{
+				if (arReindex[iLevel][iTypeLoop] == 1)
+					{ IndexObjects (iLevel, iTypeLoop, 0); }
+			}
+			break;
+		case CHANGE_INT:
+			*stChange->iValue = iValue; break;
+	}
+}
+/*****************************************************************************/
+void Reindex (int iLevel, int iObject)
+/*****************************************************************************/
+{
+	/* Takes the records of an object value out of the index, the first time
+	 * ApplyChange() changes them. Undo() and Redo() add them again at the
+	 * end, once all changes of the group are applied.
+	 */
+
+	if (arReindex[iLevel][iObject] == 1) { return; }
+
+	IndexObjects (iLevel, iObject, 0);
+	arReindex[iLevel][iObject] = 1;
+}
+/*****************************************************************************/
+int Undo (void)
+/*****************************************************************************/
+{
+	/* Undoes the last group of changes. Returns 1 if there was one. This
+	 * takes time in proportion to the changes; nothing is reloaded.
+	 */
+
+	int iJournalOld;
+	int iUndoGroup;
+
+	if (iChangesDone == 0) { return (0); }
+
+	iJournalOld = iJournal;
+	iJournal = 0;
+	iUndoGroup = GetChange (iChangesDone - 1)->iGroup;
+	while ((iChangesDone > 0) &&
+		(GetChange (iChangesDone - 1)->iGroup == iUndoGroup))
+	{
+		iChangesDone--;
+		ApplyChange (GetChange (iChangesDone), 0);
+	}
+	ReindexMarked();
+	iJournal = iJournalOld;
+	CloseChanges();
+
+	return (1);
+}
+/*****************************************************************************/
+int Redo (void)
+/*****************************************************************************/
+{
+	/*** Redoes the last group of changes that was undone; see Undo(). ***/
+
+	int iJournalOld;
+	int iRedoGroup;
+
+	if (iChangesDone == iChangesNr) { return (0); }
+
+	iJournalOld = iJournal;
+	iJournal = 0;
+	iRedoGroup = GetChange (iChangesDone)->iGroup;
+	while ((iChangesDone < iChangesNr) &&
+		(GetChange (iChangesDone)->iGroup == iRedoGroup))
+	{
+		ApplyChange (GetChange (iChangesDone), 1);
+		iChangesDone++;
+	}
+	ReindexMarked();
+	iJournal = iJournalOld;
+	CloseChanges();
+
+	return (1);
+}
+/*****************************************************************************/
+void UndoRedo (int iRedo)
+/*****************************************************************************/
+{
+	/*** Ctrl+z and Ctrl+y. ***/
+
+	int iDone;
+
+	if (iRedo == 1) { iDone = Redo(); } else { iDone = Undo(); }
+	if (iDone == 1)
+	{
+		if (iCurX > arLevelWidth[iCurLevel])
+			{ iCurX = arLevelWidth[iCurLevel]; }
+		if (iCurY > arLevelHeight[iCurLevel])
+			{ iCurY = arLevelHeight[iCurLevel]; }
+		PlaySound ("wav/ok_close.wav");
+		iChanged++;
+	}
+}
+/*****************************************************************************/
+void ReindexMarked (void)
+/*****************************************************************************/
+{
+	/*** Re-adds the indexes that Reindex() cleared. ***/
+
+	/*** Used for looping. ***/
+	int iLevelLoop;
+	int iTypeLoop;
+
+	for (iLevelLoop = 1; iLevelLoop <= MAX_LEVELS; iLevelLoop++)
+	{
+		for (iTypeLoop = 0x03; iTypeLoop <= NR_TYPES; iTypeLoop++)
+		{
+			if (arReindex[iLevelLoop][iTypeLoop] == 1)
+			{
+				IndexObjects (iLevelLoop, iTypeLoop, 1);
+				arReindex[iLevelLoop][iTypeLoop] = 0;
+			}
+		}
+	}
+}
+/*****************************************************************************/
+void FreeSnapshot (int iSnapshot)
+/*****************************************************************************/
+{
+	struct snapshot *stSnapshot;
+
+	/*** Used for looping. ***/
+	int iRoomLoop;
+	int iTypeLoop;
+
+	stSnapshot = &arSnapshots[iSnapshot];
+	for (iRoomLoop = 0; iRoomLoop < stSnapshot->iRooms; iRoomLoop++)
+	{
+		if (stSnapshot->arRooms[iRoomLoop] != NULL)
+		{
+			stSnapshot->arRooms[iRoomLoop]->iRefs--;
+			if (stSnapshot->arRooms[iRoomLoop]->iRefs == 0)
+				{ free (stSnapshot->arRooms[iRoomLoop]); }
+		}
+	}
+	if (stSnapshot->arRooms != NULL) { free (stSnapshot->arRooms); }
+	for (iTypeLoop = 0x03; iTypeLoop <= NR_TYPES; iTypeLoop++)
+	{
+		if (stSnapshot->arWords[iTypeLoop] != NULL)
+			{ free (stSnapshot->arWords[iTypeLoop]); }
+	}
+	memset (stSnapshot, 0, sizeof (struct snapshot));
+}
+/*****************************************************************************/
+int TakeSnapshot (int iSnapshot)
+/*****************************************************************************/
+{
+	/* Makes snapshot iSnapshot of iCurLevel. No tiles are copied here; see
+	 * struct snapshot. Returns 1.
+	 */
+
+	struct snapshot *stSnapshot;
+	struct tiles *stTiles;
+	int iWords;
+
+	/*** Used for looping. ***/
+	int iValueLoop;
+	int iTypeLoop;
+
+	CloseChanges();
+	FreeSnapshot (iSnapshot);
+	stSnapshot = &arSnapshots[iSnapshot];
+	stTiles = &arLevelTiles[iCurLevel];
+	stSnapshot->iLevel = iCurLevel;
+	stSnapshot->iWidth = arLevelWidth[iCurLevel];
+	stSnapshot->iHeight = arLevelHeight[iCurLevel];
+	for (iValueLoop = 0; iValueLoop < SNAPSHOT_VALUES; iValueLoop++)
+	{
+		stSnapshot->arValues[iValueLoop] =
+			arSnapshotValues[iValueLoop][iCurLevel];
+	}
+	stSnapshot->iRooms = stTiles->iRoomsX *
+		((stTiles->iHeight + HEIGHT - 1) / HEIGHT);
+	stSnapshot->arRooms = (struct room **)calloc (stSnapshot->iRooms + 1,
+		sizeof (struct room *));
+	if (stSnapshot->arRooms == NULL)
+	{
+		printf ("[FAILED] Could not allocate snapshot %i!\n", iSnapshot);
+		exit (EXIT_ERROR);
+	}
+	for (iTypeLoop = 0x03; iTypeLoop <= NR_TYPES; iTypeLoop++)
+	{
+		stSnapshot->arNr[iTypeLoop] = arObjects[iCurLevel][iTypeLoop].iNr;
+		iWords = stSnapshot->arNr[iTypeLoop] * RecordWords (iTypeLoop);
+		stSnapshot->arWords[iTypeLoop] = (unsigned short *)malloc
+			((iWords * sizeof (unsigned short)) + 1);
+		if (stSnapshot->arWords[iTypeLoop] == NULL)
+		{
+			printf ("[FAILED] Could not allocate snapshot %i!\n", iSnapshot);
+			exit (EXIT_ERROR);
+		}
+		if (iWords != 0)
+		{
+			memcpy (stSnapshot->arWords[iTypeLoop],
+				ObjectRecord (iCurLevel, iTypeLoop, 1),
+				iWords * sizeof (unsigned short));
+		}
+	}
+
+	return (1);
+}
+/*****************************************************************************/
+int GoToSnapshot (int iSnapshot)
+/*****************************************************************************/
+{
+	/* Makes iCurLevel what it was in snapshot iSnapshot, as one group of
+	 * changes, so that this can be undone. Only the rooms that the
+	 * snapshot kept, and the records that differ, are compared and
+	 * written. The state before becomes snapshot 0. Returns 1 if anything
+	 * changed.
+	 */
+
+	struct snapshot *stSnapshot;
+	struct tiles *stTiles;
+	struct room *stRoom;
+	unsigned char *sObjects, *sGraphics;
+	int iOldWidth, iOldHeight;
+	int iRoomX, iRoomY;
+	int iX, iY;
+	int iDoneOld;
+	int iChanges;
+
+	/*** Used for looping. ***/
+	int iValueLoop;
+	int iRoomLoop;
+	int iTileLoop;
+	int iTypeLoop;
+
+	stSnapshot = &arSnapshots[iSnapshot];
+	if (stSnapshot->iLevel != iCurLevel) { return (0); }
+
+	TakeSnapshot (MAX_SNAPSHOTS + 1);
+	iDoneOld = iChangesDone;
+	iChanges = 0;
+
+	/*** The size; LevelResized() also clears the rooms that go. ***/
+	iOldWidth = arLevelWidth[iCurLevel];
+	iOldHeight = arLevelHeight[iCurLevel];
+	if ((stSnapshot->iWidth != iOldWidth) ||
+		(stSnapshot->iHeight != iOldHeight))
+	{
+		arLevelWidth[iCurLevel] = stSnapshot->iWidth;
+		arLevelHeight[iCurLevel] = stSnapshot->iHeight;
+		LevelResized (iOldWidth, iOldHeight);
+		iChanges++;
+	}
+
+	for (iValueLoop = 0; iValueLoop < SNAPSHOT_VALUES; iValueLoop++)
+	{
+		if (arSnapshotValues[iValueLoop][iCurLevel] !=
+			stSnapshot->arValues[iValueLoop])
+		{
+			SetLevelValue (&arSnapshotValues[iValueLoop][iCurLevel],
+				stSnapshot->arValues[iValueLoop]);
+			iChanges++;
+		}
+	}
+
+	/*** The rooms; the layout is the same, now that the size is. ***/
+	stTiles = &arLevelTiles[iCurLevel];
+	for (iRoomLoop = 0; iRoomLoop < stSnapshot->iRooms; iRoomLoop++)
+	{
+		stRoom = stSnapshot->arRooms[iRoomLoop];
+		if (stRoom == NULL) { continue; }
+		sObjects = stTiles->sObjects + (iRoomLoop * TILES);
+		sGraphics = stTiles->sGraphics + (iRoomLoop * TILES);
+		if ((memcmp (sObjects, stRoom->sObjects, TILES) == 0) &&
+			(memcmp (sGraphics, stRoom->sGraphics, TILES) == 0)) { continue; }
+
+		iRoomX = (iRoomLoop % stTiles->iRoomsX) + 1;
+		iRoomY = (iRoomLoop / stTiles->iRoomsX) + 1;
+		for (iTileLoop = 0; iTileLoop < TILES; iTileLoop++)
+		{
+			iX = ((iRoomX - 1) * WIDTH) + (iTileLoop % WIDTH) + 1;
+			iY = ((iRoomY - 1) * HEIGHT) + (iTileLoop / WIDTH) + 1;
+			if (sObjects[iTileLoop] != stRoom->sObjects[iTileLoop])
+			{
+				SetTileObject (iCurLevel, iX, iY, stRoom->sObjects[iTileLoop]);
+			}
+			if (sGraphics[iTileLoop] != stRoom->sGraphics[iTileLoop])
+			{
+				SetTileGraphics (iCurLevel, iX, iY,
+					stRoom->sGraphics[iTileLoop]);
+			}
+		}
+		iChanges++;
+	}
+
+	for (iTypeLoop = 0x03; iTypeLoop <= NR_TYPES; iTypeLoop++)
+		{ iChanges+=RestoreRecords (stSnapshot, iTypeLoop); }
+	CloseChanges();
+	if (iDebug == 1)
+	{
+		printf ("[ INFO ] Snapshot %i: %i change(s) journaled.\n", iSnapshot,
+			iChangesDone - iDoneOld);
+	}
+
+	/*** Only now, since stSnapshot may be snapshot 0. ***/
+	FreeSnapshot (0);
+	arSnapshots[0] = arSnapshots[MAX_SNAPSHOTS + 1];
+	memset (&arSnapshots[MAX_SNAPSHOTS + 1], 0, sizeof (struct snapshot));
+
+	return ((iChanges != 0) ? 1 : 0);
+}
+/*****************************************************************************/
+void Snapshot (int iSnapshot, int iGoTo)
+/*****************************************************************************/
+{
+	/*** Ctrl+1-9 and Alt+0-9. ***/
+
+	if (iGoTo == 0)
+	{
+		if (iSnapshot == 0) { return; }
+		TakeSnapshot (iSnapshot);
+		if (iDebug == 1)
+			{ printf ("[ INFO ] Took snapshot %i.\n", iSnapshot); }
+		PlaySound ("wav/extras.wav");
+	} else if (GoToSnapshot (iSnapshot) == 1) {
+		if (iCurX > arLevelWidth[iCurLevel])
+			{ iCurX = arLevelWidth[iCurLevel]; }
+		if (iCurY > arLevelHeight[iCurLevel])
+			{ iCurY = arLevelHeight[iCurLevel]; }
+		PlaySound ("wav/ok_close.wav");
+		iChanged++;
+	}
+}
+/*****************************************************************************/
+void BeginScene (void)
+/*****************************************************************************/
+{
+	/* Starts recording the draws of ShowScreen(), instead of drawing them.
+	 * Without render targets, everything is drawn directly, as before.
+	 */
+
+	if (iNoScene == 1) { return; }
+	if ((imgscene == NULL) || (iSceneW != (WINDOW_WIDTH) * iScale) ||
+		(iSceneH != (WINDOW_HEIGHT) * iScale))
+	{
+		if (imgscene != NULL) { SDL_DestroyTexture (imgscene); }
+		iSceneW = (WINDOW_WIDTH) * iScale;
+		iSceneH = (WINDOW_HEIGHT) * iScale;
+		imgscene = NULL;
+		if (SDL_RenderTargetSupported (ascreen) == SDL_TRUE)
+		{
+			imgscene = SDL_CreateTexture (ascreen, SDL_PIXELFORMAT_RGBA8888,
+				SDL_TEXTUREACCESS_TARGET, iSceneW, iSceneH);
+		}
+		if (imgscene == NULL)
+		{
+			PrIfDe ("[ WARN ] No render target; redrawing everything.\n");
+			iNoScene = 1;
+			return;
+		}
+		iSceneValid = 0;
+	}
+
+	iDraws = 1 - iDraws;
+	arDrawsNr[iDraws] = 0;
+	iRecording = 1;
+}
+/*****************************************************************************/
+void EndScene (void)
+/*****************************************************************************/
+{
+	/* Redraws the regions of imgscene where the recorded draws differ from
+	 * those of the previous scene, and copies it to the screen. A draw is
+	 * unchanged if an identical draw was recorded last time; it is first
+	 * looked for at the same place in the list, shifted by the insertions
+	 * and removals so far.
+	 */
+
+	struct draw *arNew, *arOld;
+	int iNewNr, iOldNr;
+	int iShift;
+	int iOld;
+	int iCost;
+	SDL_Rect all;
+
+	/*** Used for looping. ***/
+	int iDrawLoop;
+	int iOldLoop;
+	int iDirtyLoop;
+
+	if (iRecording == 0) { return; }
+	iRecording = 0;
+	arNew = arDraws[iDraws];
+	iNewNr = arDrawsNr[iDraws];
+	arOld = arDraws[1 - iDraws];
+	iOldNr = arDrawsNr[1 - iDraws];
+
+	iDirtyNr = 0;
+	if (iSceneValid == 0)
+	{
+		all.x = 0; all.y = 0; all.w = iSceneW; all.h = iSceneH;
+		AddDirty (&all);
+	} else {
+		for (iOldLoop = 0; iOldLoop < iOldNr; iOldLoop++)
+			{ arOld[iOldLoop].iMatched = 0; }
+		iShift = 0;
+		for (iDrawLoop = 0; iDrawLoop < iNewNr; iDrawLoop++)
+		{
+			iOld = iDrawLoop + iShift;
+			if ((iOld < 0) || (iOld >= iOldNr) ||
+				(arOld[iOld].iMatched == 1) ||
+				(SameDraw (&arNew[iDrawLoop], &arOld[iOld]) == 0))
+			{
+				iOld = -1;
+				for (iOldLoop = 0; iOldLoop < iOldNr; iOldLoop++)
+				{
+					if ((arOld[iOldLoop].iMatched == 0) &&
+						(SameDraw (&arNew[iDrawLoop], &arOld[iOldLoop]) == 1))
+						{ iOld = iOldLoop; break; }
+				}
+			}
+			if (iOld == -1)
+			{
+				AddDirty (&arNew[iDrawLoop].dst);
+			} else {
+				arOld[iOld].iMatched = 1;
+				iShift = iOld - iDrawLoop;
+			}
+		}
+		for (iOldLoop = 0; iOldLoop < iOldNr; iOldLoop++)
+		{
+			if (arOld[iOldLoop].iMatched == 0)
+				{ AddDirty (&arOld[iOldLoop].dst); }
+		}
+	}
+
+	/*** If the regions need more draws than the scene, redraw it all. ***/
+	iCost = 0;
+	for (iDirtyLoop = 0; iDirtyLoop < iDirtyNr; iDirtyLoop++)
+	{
+		for (iDrawLoop = 0; iDrawLoop < iNewNr; iDrawLoop++)
+		{
+			if (SDL_HasIntersection (&arNew[iDrawLoop].dst,
+				&arDirty[iDirtyLoop]) == SDL_TRUE) { iCost++; }
+		}
+	}
+	if (iCost > iNewNr)
+	{
+		all.x = 0; all.y = 0; all.w = iSceneW; all.h = iSceneH;
+		iDirtyNr = 0;
+		AddDirty (&all);
+	}
+
+	if (iDirtyNr != 0)
+	{
+		SDL_SetRenderTarget (ascreen, imgscene);
+		for (iDirtyLoop = 0; iDirtyLoop < iDirtyNr; iDirtyLoop++)
+		{
+			SDL_RenderSetClipRect (ascreen, &arDirty[iDirtyLoop]);
+			for (iDrawLoop = 0; iDrawLoop < iNewNr; iDrawLoop++)
+			{
+				if (SDL_HasIntersection (&arNew[iDrawLoop].dst,
+					&arDirty[iDirtyLoop]) == SDL_TRUE)
+					{ PerformDraw (&arNew[iDrawLoop]); }
+			}
+			FlushBatch();
+		}
+		SDL_RenderSetClipRect (ascreen, NULL);
+		SDL_SetRenderTarget (ascreen, NULL);
+	}
+	iSceneValid = 1;
+
+	if (SDL_RenderCopy (ascreen, imgscene, NULL, NULL) != 0)
+		{ printf ("[ WARN ] SDL_RenderCopy (scene): %s!\n", SDL_GetError()); }
+}
+/*****************************************************************************/
+void AddDraw (struct draw *stDraw)
+/*****************************************************************************/
+{
+	struct draw *arNew;
+
+	if (arDrawsNr[iDraws] == arDrawsAlloc[iDraws])
+	{
+		arNew = (struct draw *)realloc (arDraws[iDraws],
+			(arDrawsAlloc[iDraws] + 256) * sizeof (struct draw));
+		if (arNew == NULL)
+		{
+			printf ("[FAILED] Could not allocate %i draws!\n",
+				arDrawsAlloc[iDraws] + 256);
+			exit (EXIT_ERROR);
+		}
+		arDraws[iDraws] = arNew;
+		arDrawsAlloc[iDraws] += 256;
+	}
+	arDraws[iDraws][arDrawsNr[iDraws]] = *stDraw;
+	arDrawsNr[iDraws]++;
+}
+/*****************************************************************************/
+int SameDraw (struct draw *stDraw1, struct draw *stDraw2)
+/*****************************************************************************/
+{
+	if ((stDraw1->iKind != stDraw2->iKind) ||
+		(memcmp (&stDraw1->dst, &stDraw2->dst, sizeof (SDL_Rect)) != 0))
+		{ return (0); }
+	if (stDraw1->iKind == DRAW_IMAGE)
+	{
+		if ((stDraw1->img != stDraw2->img) ||
+			(stDraw1->iSrc != stDraw2->iSrc) ||
+			(memcmp (&stDraw1->src, &stDraw2->src, sizeof (SDL_Rect)) != 0))
+			{ return (0); }
+	} else {
+		if ((stDraw1->font != stDraw2->font) ||
+			(stDraw1->iBlended != stDraw2->iBlended) ||
+			(memcmp (&stDraw1->fore, &stDraw2->fore, sizeof (SDL_Color)) != 0) ||
+			(memcmp (&stDraw1->back, &stDraw2->back, sizeof (SDL_Color)) != 0) ||
+			(strcmp (stDraw1->sText, stDraw2->sText) != 0))
+			{ return (0); }
+	}
+
+	return (1);
+}
+/*****************************************************************************/
+void AddDirty (SDL_Rect *rect)
+/*****************************************************************************/
+{
+	/*** Overlapping regions are merged; when full, the first one grows. ***/
+
+	/*** Used for looping. ***/
+	int iDirtyLoop;
+
+	if ((rect->w <= 0) || (rect->h <= 0)) { return; }
+	for (iDirtyLoop = 0; iDirtyLoop < iDirtyNr; iDirtyLoop++)
+	{
+		if (SDL_HasIntersection (rect, &arDirty[iDirtyLoop]) == SDL_TRUE)
+		{
+			SDL_UnionRect (rect, &arDirty[iDirtyLoop], &arDirty[iDirtyLoop]);
+			return;
+		}
+	}
+	if (iDirtyNr == MAX_DIRTY)
+	{
+		SDL_UnionRect (rect, &arDirty[0], &arDirty[0]);
+	} else {
+		arDirty[iDirtyNr] = *rect;
+		iDirtyNr++;
+	}
+}
+/*****************************************************************************/
+void PerformDraw (struct draw *stDraw)
+/*****************************************************************************/
+{
+	SDL_Rect dest;
+	struct sprite *stSprite;
+	SDL_Texture *messaget;
+
+	if (stDraw->iKind == DRAW_IMAGE)
+	{
+		stSprite = FindSprite (stDraw->img);
+		if (stSprite != NULL)
+		{
+			Batch (stSprite, (stDraw->iSrc == 1) ? &stDraw->src : NULL,
+				&stDraw->dst);
+			return;
+		}
+		FlushBatch();
+		if (SDL_RenderCopy (ascreen, stDraw->img,
+			(stDraw->iSrc == 1) ? &stDraw->src : NULL, &stDraw->dst) != 0)
+		{
+			printf ("[ WARN ] SDL_RenderCopy (scene): %s!\n", SDL_GetError());
+		}
+		return;
+	}
+
+	FlushBatch();
+	dest = stDraw->dst;
+	messaget = TextTexture (stDraw, &dest.w, &dest.h);
+	if (messaget == NULL) { return; }
+	if (SDL_RenderCopy (ascreen, messaget, NULL, &dest) != 0)
+		{ printf ("[ WARN ] SDL_RenderCopy (message): %s!\n", SDL_GetError()); }
+}
+/*****************************************************************************/
+void ShowText (TTF_Font *font, char *sText, SDL_Color fore,
+	SDL_Color back, int iBlended, int iX, int iY)
+/*****************************************************************************/
+{
+	/*** Text at (unscaled) iX, iY; recorded if there is a scene. ***/
+
+	struct draw stDraw;
+
+	memset (&stDraw, 0, sizeof (struct draw));
+	stDraw.iKind = DRAW_TEXT;
+	stDraw.font = font;
+	stDraw.iBlended = iBlended;
+	stDraw.fore = fore;
+	stDraw.back = back;
+	snprintf (stDraw.sText, MAX_TEXT, "%s", sText);
+	stDraw.dst.x = iX * iScale;
+	stDraw.dst.y = iY * iScale;
+	if (iRecording == 1)
+	{
+		/*** The size of the wrapped render, which PerformDraw() covers. ***/
+		if (TextTexture (&stDraw, &stDraw.dst.w, &stDraw.dst.h) == NULL)
+			{ TTF_SizeText (font, stDraw.sText, &stDraw.dst.w, &stDraw.dst.h); }
+		AddDraw (&stDraw);
+	} else {
+		PerformDraw (&stDraw);
+	}
+}
+/*****************************************************************************/
+void LoadSprite (char *sImage, SDL_Texture **imgImage)
+/*****************************************************************************/
+{
+	/* Loads a preloaded image into *imgImage and packs it into an atlas.
+	 * Images that are loaded more than once, such as sel_graphics.png,
+	 * share a texture. Every use is kept, for ReloadSprites().
+	 */
+
+	struct loaded *arNew;
+	int iFirst;
+
+	/*** Used for looping. ***/
+	int iLoadedLoop;
+
+	iFirst = iLoadedNr;
+	for (iLoadedLoop = 0; iLoadedLoop < iLoadedNr; iLoadedLoop++)
+	{
+		if (strcmp (arLoaded[iLoadedLoop].sImage, sImage) == 0)
+			{ iFirst = arLoaded[iLoadedLoop].iFirst; break; }
+	}
+
+	if (iLoadedNr == iLoadedAlloc)
+	{
+		arNew = (struct loaded *)realloc (arLoaded,
+			(iLoadedAlloc + 256) * sizeof (struct loaded));
+		if (arNew == NULL)
+		{
+			printf ("[FAILED] Could not allocate %i images!\n",
+				iLoadedAlloc + 256);
+			exit (EXIT_ERROR);
+		}
+		arLoaded = arNew;
+		iLoadedAlloc += 256;
+	}
+	snprintf (arLoaded[iLoadedNr].sImage, MAX_IMG, "%s", sImage);
+	if (iFirst == iLoadedNr)
+	{
+		arLoaded[iLoadedNr].img = CreateSprite (sImage);
+		if (arLoaded[iLoadedNr].img == NULL)
+		{
+			printf ("[FAILED] Could not load %s: %s!\n", sImage, SDL_GetError());
+			exit (EXIT_ERROR);
+		}
+	} else {
+		arLoaded[iLoadedNr].img = arLoaded[iFirst].img;
+	}
+	arLoaded[iLoadedNr].imgHolder = imgImage;
+	arLoaded[iLoadedNr].iFirst = iFirst;
+	iLoadedNr++;
+
+	*imgImage = arLoaded[iFirst].img;
+}
+/*****************************************************************************/
+SDL_Texture *CreateSprite (char *sImage)
+/*****************************************************************************/
+{
+	/*** Returns a texture of sImage, added to the atlases, or NULL. ***/
+
+	SDL_Surface *surface;
+	SDL_Texture *img;
+
+	surface = IMG_Load (sImage);
+	if (surface == NULL) { return (NULL); }
+	img = SDL_CreateTextureFromSurface (ascreen, surface);
+	if (img != NULL) { AddSprite (img, surface); }
+	SDL_FreeSurface (surface);
+
+	return (img);
+}
+/*****************************************************************************/
+void AddSprite (SDL_Texture *img, SDL_Surface *surface)
+/*****************************************************************************/
+{
+	/* Copies surface into the atlas being filled, on shelves from the top
+	 * down, with a pixel between the images. Large images, and images that
+	 * do not fit in MAX_ATLASES, are only drawn on their own.
+	 */
+
+	SDL_RendererInfo info;
+	SDL_Surface *converted;
+	SDL_Rect rect;
+	int iSlot;
+
+	if ((surface->w > ATLAS_SPRITE) || (surface->h > ATLAS_SPRITE)) { return; }
+	if (iSprites >= MAX_SPRITES / 2) { return; }
+
+	if (iAtlasSize == 0)
+	{
+		iAtlasSize = ATLAS_SIZE;
+		if (SDL_GetRendererInfo (ascreen, &info) == 0)
+		{
+			if ((info.max_texture_width != 0) &&
+				(info.max_texture_width < iAtlasSize))
+				{ iAtlasSize = info.max_texture_width; }
+			if ((info.max_texture_height != 0) &&
+				(info.max_texture_height < iAtlasSize))
+				{ iAtlasSize = info.max_texture_height; }
+		}
+	}
+
+	if (iAtlasX + surface->w > iAtlasSize)
+	{
+		iAtlasX = 0;
+		iAtlasY += iShelfH + 1;
+		iShelfH = 0;
+	}
+	if ((atlas != NULL) && (iAtlasY + surface->h > iAtlasSize))
+		{ FinishAtlas(); }
+	if (atlas == NULL)
+	{
+		if (iAtlases == MAX_ATLASES) { return; }
+		atlas = SDL_CreateRGBSurfaceWithFormat (0, iAtlasSize, iAtlasSize,
+			32, SDL_PIXELFORMAT_RGBA32);
+		if (atlas == NULL)
+		{
+			printf ("[ WARN ] Could not create an atlas: %s!\n", SDL_GetError());
+			return;
+		}
+		iAtlases++;
+		iAtlasX = 0;
+		iAtlasY = 0;
+		iShelfH = 0;
+	}
+
+	converted = SDL_ConvertSurfaceFormat (surface, SDL_PIXELFORMAT_RGBA32, 0);
+	if (converted == NULL) { return; }
+	SDL_SetSurfaceBlendMode (converted, SDL_BLENDMODE_NONE);
+	rect.x = iAtlasX;
+	rect.y = iAtlasY;
+	rect.w = surface->w;
+	rect.h = surface->h;
+	SDL_BlitSurface (converted, NULL, atlas, &rect);
+	SDL_FreeSurface (converted);
+
+	iSlot = ((size_t)img / 8) % MAX_SPRITES;
+	while (arSprites[iSlot].img != NULL) { iSlot = (iSlot + 1) % MAX_SPRITES; }
+	arSprites[iSlot].img = img;
+	arSprites[iSlot].iAtlas = iAtlases - 1;
+	arSprites[iSlot].rect = rect;
+	iSprites++;
+
+	iAtlasX += surface->w + 1;
+	if (surface->h > iShelfH) { iShelfH = surface->h; }
+}
+/*****************************************************************************/
+struct sprite *FindSprite (SDL_Texture *img)
+/*****************************************************************************/
+{
+	/*** Returns where img is in an atlas, or NULL. ***/
+
+	int iSlot;
+
+	iSlot = ((size_t)img / 8) % MAX_SPRITES;
+	while (arSprites[iSlot].img != NULL)
+	{
+		if (arSprites[iSlot].img == img)
+		{
+			if (arAtlases[arSprites[iSlot].iAtlas] == NULL) { return (NULL); }
+			return (&arSprites[iSlot]);
+		}
+		iSlot = (iSlot + 1) % MAX_SPRITES;
+	}
+
+	return (NULL);
+}
+/*****************************************************************************/
+void FinishAtlas (void)
+/*****************************************************************************/
+{
+	if (atlas == NULL) { return; }
+
+	arAtlases[iAtlases - 1] = SDL_CreateTextureFromSurface (ascreen, atlas);
+	if (arAtlases[iAtlases - 1] == NULL)
+	{
+		printf ("[ WARN ] Could not create an atlas: %s!\n", SDL_GetError());
+	} else {
+		SDL_SetTextureBlendMode (arAtlases[iAtlases - 1], SDL_BLENDMODE_BLEND);
+	}
+	SDL_FreeSurface (atlas);
+	atlas = NULL;
+}
+/*****************************************************************************/
+void EndPreLoad (void)
+/*****************************************************************************/
+{
+	int iImages;
+
+	/*** Used for looping. ***/
+	int iLoadedLoop;
+
+	FinishAtlas();
+	if (iDebug == 1)
+	{
+		iImages = 0;
+		for (iLoadedLoop = 0; iLoadedLoop < iLoadedNr; iLoadedLoop++)
+			{ if (arLoaded[iLoadedLoop].iFirst == iLoadedLoop) { iImages++; } }
+		printf ("[ INFO ] Loaded %i images, %i in %i atlases.\n",
+			iImages, iSprites, iAtlases);
+	}
+}
+/*****************************************************************************/
+void Batch (struct sprite *stSprite, SDL_Rect *src, SDL_Rect *dst)
+/*****************************************************************************/
+{
+	/*** Adds a quad, from the atlas of stSprite, to the batch. ***/
+
+	if ((iBatchNr != 0) &&
+		((iBatchAtlas != stSprite->iAtlas) || (iBatchNr == MAX_BATCH)))
+		{ FlushBatch(); }
+
+	iBatchAtlas = stSprite->iAtlas;
+	arBatchSrc[iBatchNr] = stSprite->rect;
+	if (src != NULL)
+	{
+		arBatchSrc[iBatchNr].x += src->x;
+		arBatchSrc[iBatchNr].y += src->y;
+		arBatchSrc[iBatchNr].w = src->w;
+		arBatchSrc[iBatchNr].h = src->h;
+	}
+	arBatchDst[iBatchNr] = *dst;
+	iBatchNr++;
+}
+/*****************************************************************************/
+void FlushBatch (void)
+/*****************************************************************************/
+{
+	/* Draws the batch. With SDL 2.0.18 or later, in one call; otherwise,
+	 * one copy per quad, which SDL still batches, since the texture stays
+	 * the same.
+	 */
+
+#if SDL_VERSION_ATLEAST(2,0,18)
+	static SDL_Vertex arVertices[(MAX_BATCH + 2) * 4];
+	static int arIndices[(MAX_BATCH + 2) * 6];
+	SDL_Vertex *stVertex;
+	float fSize;
+	int iCorner;
+#endif
+
+	/*** Used for looping. ***/
+	int iQuadLoop;
+
+	if (iBatchNr == 0) { return; }
+
+#if SDL_VERSION_ATLEAST(2,0,18)
+	fSize = (float)iAtlasSize;
+	for (iQuadLoop = 0; iQuadLoop < iBatchNr; iQuadLoop++)
+	{
+		for (iCorner = 0; iCorner < 4; iCorner++)
+		{
+			stVertex = &arVertices[(iQuadLoop * 4) + iCorner];
+			stVertex->position.x = arBatchDst[iQuadLoop].x;
+			stVertex->position.y = arBatchDst[iQuadLoop].y;
+			stVertex->tex_coord.x = arBatchSrc[iQuadLoop].x;
+			stVertex->tex_coord.y = arBatchSrc[iQuadLoop].y;
+			if ((iCorner == 1) || (iCorner == 3))
+			{
+				stVertex->position.x += arBatchDst[iQuadLoop].w;
+				stVertex->tex_coord.x += arBatchSrc[iQuadLoop].w;
+			}
+			if ((iCorner == 2) || (iCorner == 3))
+			{
+				stVertex->position.y += arBatchDst[iQuadLoop].h;
+				stVertex->tex_coord.y += arBatchSrc[iQuadLoop].h;
+			}
+			stVertex->tex_coord.x /= fSize;
+			stVertex->tex_coord.y /= fSize;
+			stVertex->color = color_wh;
+		}
+		arIndices[(iQuadLoop * 6) + 0] = (iQuadLoop * 4) + 0;
+		arIndices[(iQuadLoop * 6) + 1] = (iQuadLoop * 4) + 1;
+		arIndices[(iQuadLoop * 6) + 2] = (iQuadLoop * 4) + 2;
+		arIndices[(iQuadLoop * 6) + 3] = (iQuadLoop * 4) + 2;
+		arIndices[(iQuadLoop * 6) + 4] = (iQuadLoop * 4) + 1;
+		arIndices[(iQuadLoop * 6) + 5] = (iQuadLoop * 4) + 3;
+	}
+	if (SDL_RenderGeometry (ascreen, arAtlases[iBatchAtlas], arVertices,
+		iBatchNr * 4, arIndices, iBatchNr * 6) != 0)
+	{
+		printf ("[ WARN ] SDL_RenderGeometry: %s!\n", SDL_GetError());
+	}
+#else
+	for (iQuadLoop = 0; iQuadLoop < iBatchNr; iQuadLoop++)
+	{
+		if (SDL_RenderCopy (ascreen, arAtlases[iBatchAtlas],
+			&arBatchSrc[iQuadLoop], &arBatchDst[iQuadLoop]) != 0)
+		{
+			printf ("[ WARN ] SDL_RenderCopy (atlas): %s!\n", SDL_GetError());
+		}
+	}
+#endif
+
+	iBatchNr = 0;
+}
+/*****************************************************************************/
+SDL_Texture *TextTexture (struct draw *stDraw, int *iW, int *iH)
+/*****************************************************************************/
+{
+	/* Returns the texture of a text draw, and renders it only if it is not
+	 * cached. The texture belongs to the cache; do not destroy it.
+	 */
+
+	Uint32 iHash;
+	int iFree;
+	struct text *stText;
+	SDL_Texture *tex;
+	int iChar;
+
+	/*** Used for looping. ***/
+	int iTextLoop;
+
+	/*** FNV-1a, to skip most strcmp() calls. ***/
+	iHash = 2166136261u;
+	for (iChar = 0; stDraw->sText[iChar] != '\0'; iChar++)
+	{
+		iHash ^= (unsigned char)stDraw->sText[iChar];
+		iHash *= 16777619u;
+	}
+
+	iTextsUsed++;
+	iFree = 0;
+	for (iTextLoop = 0; iTextLoop < MAX_TEXTS; iTextLoop++)
+	{
+		stText = &arTexts[iTextLoop];
+		if (stText->tex == NULL) { iFree = iTextLoop; continue; }
+		if ((stText->iHash == iHash) &&
+			(stText->font == stDraw->font) &&
+			(stText->iBlended == stDraw->iBlended) &&
+			(memcmp (&stText->fore, &stDraw->fore, sizeof (SDL_Color)) == 0) &&
+			(memcmp (&stText->back, &stDraw->back, sizeof (SDL_Color)) == 0) &&
+			(strcmp (stText->sText, stDraw->sText) == 0))
+		{
+			stText->iUsed = iTextsUsed;
+			*iW = stText->iW;
+			*iH = stText->iH;
+			return (stText->tex);
+		}
+		if ((arTexts[iFree].tex != NULL) &&
+			(stText->iUsed < arTexts[iFree].iUsed)) { iFree = iTextLoop; }
+	}
+
+	if (stDraw->iBlended == 1)
+	{
+		/* The 100000 is a workaround for 0 being broken. SDL devs have fixed
+		 * that see e.g. https://hg.libsdl.org/SDL_ttf/rev/72b8861dbc01 but
+		 * Ubuntu et al. still ship older sdl2-ttf versions.
+		 */
+		message = TTF_RenderText_Blended_Wrapped (stDraw->font, stDraw->sText,
+			stDraw->fore, 100000);
+	} else {
+		message = TTF_RenderText_Shaded (stDraw->font, stDraw->sText,
+			stDraw->fore, stDraw->back);
+	}
+	if (message == NULL)
+	{
+		printf ("[ WARN ] Could not render text: %s!\n", TTF_GetError());
+		return (NULL);
+	}
+	tex = SDL_CreateTextureFromSurface (ascreen, message);
+	if (tex == NULL)
+	{
+		printf ("[ WARN ] Could not create texture: %s!\n", SDL_GetError());
+		SDL_FreeSurface (message);
+		return (NULL);
+	}
+
+	stText = &arTexts[iFree];
+	if (stText->tex != NULL) { SDL_DestroyTexture (stText->tex); }
+	stText->tex = tex;
+	stText->iW = message->w;
+	stText->iH = message->h;
+	stText->iUsed = iTextsUsed;
+	stText->iHash = iHash;
+	stText->font = stDraw->font;
+	stText->iBlended = stDraw->iBlended;
+	stText->fore = stDraw->fore;
+	stText->back = stDraw->back;
+	snprintf (stText->sText, MAX_TEXT, "%s", stDraw->sText);
+	SDL_FreeSurface (message);
+
+	*iW = stText->iW;
+	*iH = stText->iH;
+	return (tex);
+}
+/*****************************************************************************/
+void DropTexts (void)
+/*****************************************************************************/
+{
+	/*** Used for looping. ***/
+	int iTextLoop;
+
+	for (iTextLoop = 0; iTextLoop < MAX_TEXTS; iTextLoop++)
+	{
+		if (arTexts[iTextLoop].tex != NULL)
+		{
+			SDL_DestroyTexture (arTexts[iTextLoop].tex);
+			arTexts[iTextLoop].tex = NULL;
+		}
+	}
+}
+/*****************************************************************************/
+void ReadLayouts (char *sFile)
+/*****************************************************************************/
+{
+	/* Adds the layouts in sFile to arLayouts, if the file exists. Each line
+	 * is:
+	 * CRC32 size region(U/E) levels prince levels gr_ob guards doors gates
+	 * loose raise drop chompers spikes potions name
+	 * with the CRC32 and offsets in hexadecimal. Lines starting with '#'
+	 * are ignored.
+	 */
+
+	FILE *fLayouts;
+	char sLine[MAX_TEXT * 4 + 2];
+	struct layout *stL;
+	char cRegion;
+	int iName;
+
+	fLayouts = fopen (sFile, "r");
+	if (fLayouts != NULL)
+	{
+		while (fgets (sLine, MAX_TEXT * 4, fLayouts) != NULL)
+		{
+			if ((sLine[0] == '#') || (sLine[0] == '\n') || (sLine[0] == '\r'))
+				{ continue; }
+			if (iNrLayouts == MAX_LAYOUTS)
+			{
+				printf ("[ WARN ] More than %i layouts in \"%s\"!\n",
+					MAX_LAYOUTS, sFile);
+				break;
+			}
+			stL = &arLayouts[iNrLayouts + 1];
+			iName = 0;
+			if ((sscanf (sLine, "%lx %i %c %i %x %x %x %x %x %x %x %x %x %x"
+				" %x %x %n", &stL->iCRC, &stL->iSize, &cRegion,
+				&stL->iNrLevels, (unsigned int *)&stL->iOffsetPrince,
+				(unsigned int *)&stL->iOffsetLevels,
+				(unsigned int *)&stL->iOffsetGrOb,
+				(unsigned int *)&stL->iOffsetGuards,
+				(unsigned int *)&stL->iOffsetDoors,
+				(unsigned int *)&stL->iOffsetGates,
+				(unsigned int *)&stL->iOffsetLoose,
+				(unsigned int *)&stL->iOffsetRaise,
+				(unsigned int *)&stL->iOffsetDrop,
+				(unsigned int *)&stL->iOffsetChompers,
+				(unsigned int *)&stL->iOffsetSpikes,
+				(unsigned int *)&stL->iOffsetPotions, &iName) != 16) ||
+				((toupper (cRegion) != 'U') && (toupper (cRegion) != 'E')))
+			{
+				printf ("[ WARN ] Skipping a line of \"%s\": %s", sFile, sLine);
+				continue;
+			}
+			if (toupper (cRegion) == 'U')
+				{ stL->iEXEType = 1; } else { stL->iEXEType = 2; }
+			snprintf (stL->sName, MAX_TEXT, "%s", sLine + iName);
+			stL->sName[strcspn (stL->sName, "\r\n")] = '\0';
+			iNrLayouts++;
+		}
+		fclose (fLayouts);
+	}
+}
+/*****************************************************************************/
+int SameLayout (struct layout *stL1, struct layout *stL2)
+/*****************************************************************************/
+{
+	/*** Compares where the level data is; not the CRC32, size or name. ***/
+
+	if ((stL1->iEXEType != stL2->iEXEType) ||
+		(stL1->iNrLevels != stL2->iNrLevels) ||
+		(stL1->iOffsetPrince != stL2->iOffsetPrince) ||
+		(stL1->iOffsetLevels != stL2->iOffsetLevels) ||
+		(stL1->iOffsetGrOb != stL2->iOffsetGrOb) ||
+		(stL1->iOffsetGuards != stL2->iOffsetGuards) ||
+		(stL1->iOffsetDoors != stL2->iOffsetDoors) ||
+		(stL1->iOffsetGates != stL2->iOffsetGates) ||
+		(stL1->iOffsetLoose != stL2->iOffsetLoose) ||
+		(stL1->iOffsetRaise != stL2->iOffsetRaise) ||
+		(stL1->iOffsetDrop != stL2->iOffsetDrop) ||
+		(stL1->iOffsetChompers != stL2->iOffsetChompers) ||
+		(stL1->iOffsetSpikes != stL2->iOffsetSpikes) ||
+		(stL1->iOffsetPotions != stL2->iOffsetPotions))
+		{ return (0); }
+
+	return (1);
+}
+/*****************************************************************************/
+void SaveLayout (void)
+/*****************************************************************************/
+{
+	/* Saving changes the CRC32 of a ROM. If the ROM was recognized by its
+	 * CRC32, and the layout of its region would not find its levels, the
+	 * layout is stored with the new CRC32 in a file next to the ROM. Call
+	 * this after the pristine image was updated.
+	 */
+
+	struct layout stDefault;
+	char sFile[MAX_PATHFILE + 2];
+	char sTemp[MAX_PATHFILE + 2];
+	FILE *fLayout;
+
+	if (stLayout.iCRC == 0) { return; }
+	DefaultLayout (&stDefault, stLayout.iEXEType);
+	if (SameLayout (&stLayout, &stDefault) == 1) { return; }
+
+	stLayout.iCRC = CRC32 (stROM.stPristine.sData, stROM.stPristine.iSize);
+	stLayout.iSize = stROM.stPristine.iSize;
+
+	snprintf (sFile, MAX_PATHFILE, "%s%s", sPathFile, LAYOUT_SUFFIX);
+	snprintf (sTemp, MAX_PATHFILE, "%s%s", sFile, TEMP_SUFFIX);
+	fLayout = fopen (sTemp, "w");
+	if (fLayout == NULL)
+	{
+		printf ("[ WARN ] Could not write \"%s\": %s!\n",
+			sTemp, strerror (errno));
+		return;
+	}
+	fprintf (fLayout, "# Written by %s when the ROM was saved.\n",
+		EDITOR_NAME);
+	fprintf (fLayout, "%08lX %i %c %i %X %X %X %X %X %X %X %X %X %X %X %X"
+		" %s\n", stLayout.iCRC, stLayout.iSize,
+		(stLayout.iEXEType == 1) ? 'U' : 'E', stLayout.iNrLevels,
+		stLayout.iOffsetPrince, stLayout.iOffsetLevels, stLayout.iOffsetGrOb,
+		stLayout.iOffsetGuards, stLayout.iOffsetDoors, stLayout.iOffsetGates,
+		stLayout.iOffsetLoose, stLayout.iOffsetRaise, stLayout.iOffsetDrop,
+		stLayout.iOffsetChompers, stLayout.iOffsetSpikes,
+		stLayout.iOffsetPotions, stLayout.sName);
+	if (fclose (fLayout) != 0)
+	{
+		printf ("[ WARN ] Could not write \"%s\"!\n", sTemp);
+		unlink (sTemp);
+		return;
+	}
+#if defined WIN32 || _WIN32 || WIN64 || _WIN64
+	if (MoveFileEx (sTemp, sFile, MOVEFILE_REPLACE_EXISTING) == 0)
+#else
+	if (rename (sTemp, sFile) == -1)
+#endif
+	{
+		printf ("[ WARN ] Could not replace \"%s\"!\n", sFile);
+		unlink (sTemp);
+	}
+}
+/*****************************************************************************/
+void CountBytes (struct change *stChange, int iBytes)
+/*****************************************************************************/
+{
+	/*** Adds iBytes to what stChange holds; see NewChange(). ***/
+
+	stChange->iBytes += iBytes;
+	iChangesBytes += iBytes;
+}
+/*****************************************************************************/
+unsigned char *ReadBuffer (char *sFile, int *iSize)
+/*****************************************************************************/
+{
+	/* Returns the entire file in a buffer to free(), or NULL, with a
+	 * warning, if it is empty or cannot be read. This never exits; it is
+	 * for files the editor can do without, such as backups and the cache.
+	 */
+
+	int iFd;
+	struct stat stStat;
+	unsigned char *sData;
+	int iRead, iDone;
+
+	iFd = open (sFile, O_RDONLY|O_BINARY);
+	if (iFd == -1)
+	{
+		printf ("[ WARN ] Could not open \"%s\": %s!\n",
+			sFile, strerror (errno));
+		return (NULL);
+	}
+	if ((fstat (iFd, &stStat) == -1) || (stStat.st_size <= 0))
+	{
+		printf ("[ WARN ] Could not determine the size of \"%s\"!\n", sFile);
+		close (iFd);
+		return (NULL);
+	}
+	*iSize = stStat.st_size;
+	sData = (unsigned char *)malloc (*iSize);
+	if (sData == NULL)
+	{
+		printf ("[ WARN ] Could not allocate %i bytes!\n", *iSize);
+		close (iFd);
+		return (NULL);
+	}
+	iDone = 0;
+	while (iDone < *iSize)
+	{
+		iRead = read (iFd, sData + iDone, *iSize - iDone);
+		if (iRead <= 0)
+		{
+			printf ("[ WARN ] Could not read \"%s\": %s!\n",
+				sFile, strerror (errno));
+			free (sData);
+			close (iFd);
+			return (NULL);
+		}
+		iDone+=iRead;
+	}
+	close (iFd);
+
+	return (sData);
+}
+/*****************************************************************************/
+int ReplaceROM (int iFd, char *sTemp)
+/*****************************************************************************/
+{
+	/* Flushes and closes iFd, a complete new ROM in sTemp, and renames it
+	 * over the ROM. On success, the pristine image becomes the working one.
+	 * Returns 1 on success, 0 if the ROM was not changed.
+	 */
+
+	struct image *stImage;
+	int iRenamed;
+
+	stImage = &stROM.stWorking;
+#if defined WIN32 || _WIN32 || WIN64 || _WIN64
+	if (_commit (iFd) == -1)
+#else
+	if (fsync (iFd) == -1)
+#endif
+	{
+		printf ("[FAILED] Could not flush \"%s\": %s!\n",
+			sTemp, strerror (errno));
+		close (iFd);
+		unlink (sTemp);
+		return (0);
+	}
+	close (iFd);
+
+	/*** The session's descriptor would keep referring to the old file. ***/
+	close (stROM.iFd);
+
+	iRenamed = 1;
+#if defined WIN32 || _WIN32 || WIN64 || _WIN64
+	if (MoveFileEx (sTemp, sPathFile,
+		MOVEFILE_REPLACE_EXISTING|MOVEFILE_WRITE_THROUGH) == 0)
+	{
+		printf ("[FAILED] Could not replace \"%s\"!\n", sPathFile);
+		unlink (sTemp);
+		iRenamed = 0;
+	}
+#else
+	if (rename (sTemp, sPathFile) == -1)
+	{
+		printf ("[FAILED] Could not replace \"%s\": %s!\n",
+			sPathFile, strerror (errno));
+		unlink (sTemp);
+		iRenamed = 0;
+	} else {
+		/*** Also make the rename itself durable. ***/
+		iFd = open (ROM_DIR, O_RDONLY);
+		if (iFd != -1)
+		{
+			fsync (iFd);
+			close (iFd);
+		}
+	}
+#endif
+
+	stROM.iFd = open (sPathFile, O_RDWR|O_BINARY);
+	if (stROM.iFd == -1)
+	{
+		printf ("[ WARN ] Could not open \"%s\": %s!\n",
+			sPathFile, strerror (errno));
+	}
+	if (iRenamed == 0) { return (0); }
+	memcpy (stROM.stPristine.sData, stImage->sData, stImage->iSize);
+	SaveLayout();
+
+	return (1);
+}
+/*****************************************************************************/
+int NextRange (int iFrom, int *iEnd)
+/*****************************************************************************/
+{
+	/* Returns the start of the first range, at or after iFrom, where the
+	 * working image differs from the pristine image, or the image size if
+	 * there is none. *iEnd becomes the end of the range. Ranges closer than
+	 * MAX_GAP bytes are joined, to save on writes.
+	 */
+
+	unsigned char *sOld, *sNew;
+	int iSize;
+	int iStart;
+	int iGap;
+
+	sOld = stROM.stPristine.sData;
+	sNew = stROM.stWorking.sData;
+	iSize = stROM.stWorking.iSize;
+
+	iStart = iFrom;
+	while ((iStart < iSize) && (sOld[iStart] == sNew[iStart])) { iStart++; }
+	*iEnd = iStart;
+	if (iStart == iSize) { return (iSize); }
+
+	/*** Extend the range, until MAX_GAP equal bytes follow. ***/
+	*iEnd = iStart + 1;
+	iGap = 0;
+	while ((*iEnd + iGap < iSize) && (iGap < MAX_GAP))
+	{
+		if (sOld[*iEnd + iGap] != sNew[*iEnd + iGap])
+		{
+			*iEnd+=(iGap + 1);
+			iGap = 0;
+		} else { iGap++; }
+	}
+
+	return (iStart);
+}
+/*****************************************************************************/
+void KeepRoom (int iLevel, int iRoom)
+/*****************************************************************************/
+{
+	/* Call before room iRoom (as in struct tiles) of iLevel changes. Each
+	 * snapshot of iLevel that still shares the room with the level gets a
+	 * copy of it; they all get the same copy.
+	 */
+
+	struct snapshot *stSnapshot;
+	struct room *stRoom;
+
+	/*** Used for looping. ***/
+	int iSnapshotLoop;
+
+	stRoom = NULL;
+	for (iSnapshotLoop = 0; iSnapshotLoop <= MAX_SNAPSHOTS + 1;
+		iSnapshotLoop++)
+	{
+		stSnapshot = &arSnapshots[iSnapshotLoop];
+		if ((stSnapshot->iLevel != iLevel) || (iRoom >= stSnapshot->iRooms) ||
+			(stSnapshot->arRooms[iRoom] != NULL)) { continue; }
+
+		if (stRoom == NULL)
+		{
+			stRoom = (struct room *)malloc (sizeof (struct room));
+			if (stRoom == NULL)
+			{
+				printf ("[FAILED] Could not allocate a room!\n");
+				exit (EXIT_ERROR);
+			}
+			stRoom->iRefs = 0;
+			memcpy (stRoom->sObjects, arLevelTiles[iLevel].sObjects +
+				(iRoom * TILES), TILES);
+			memcpy (stRoom->sGraphics, arLevelTiles[iLevel].sGraphics +
+				(iRoom * TILES), TILES);
+		}
+		stSnapshot->arRooms[iRoom] = stRoom;
+		stRoom->iRefs++;
+	}
+}
+/*****************************************************************************/
+void KeepRooms (int iLevel)
+/*****************************************************************************/
+{
+	/*** See KeepRoom(); for when all rooms change, or move. ***/
+
+	struct tiles *stTiles;
+	int iRooms;
+
+	/*** Used for looping. ***/
+	int iRoomLoop;
+
+	stTiles = &arLevelTiles[iLevel];
+	iRooms = stTiles->iRoomsX * ((stTiles->iHeight + HEIGHT - 1) / HEIGHT);
+	for (iRoomLoop = 0; iRoomLoop < iRooms; iRoomLoop++)
+		{ KeepRoom (iLevel, iRoomLoop); }
+}
+/*****************************************************************************/
+int RestoreRecords (struct snapshot *stSnapshot, int iObject)
+/*****************************************************************************/
+{
+	/* Makes the records of iObject those of stSnapshot, for GoToSnapshot().
+	 * Equal records at the start and at the end are left alone. If the
+	 * number of records did not change, only the differing words are set;
+	 * otherwise the records in between are removed and added again.
+	 * Returns 1 if anything changed.
+	 */
+
+	unsigned short *arSnap;
+	int iWords;
+	int iNrOld, iNrNew;
+	int iSame, iSameEnd;
+
+	/*** Used for looping. ***/
+	int iRecordLoop;
+	int iWordLoop;
+
+	arSnap = stSnapshot->arWords[iObject];
+	iWords = RecordWords (iObject);
+	iNrOld = arObjects[iCurLevel][iObject].iNr;
+	iNrNew = stSnapshot->arNr[iObject];
+
+	iSame = 0;
+	while ((iSame < iNrOld) && (iSame < iNrNew) &&
+		(memcmp (ObjectRecord (iCurLevel, iObject, iSame + 1),
+		arSnap + (iSame * iWords), iWords * sizeof (unsigned short)) == 0))
+		{ iSame++; }
+	if ((iSame == iNrOld) && (iSame == iNrNew)) { return (0); }
+	iSameEnd = 0;
+	while ((iSame + iSameEnd < iNrOld) && (iSame + iSameEnd < iNrNew) &&
+		(memcmp (ObjectRecord (iCurLevel, iObject, iNrOld - iSameEnd),
+		arSnap + ((iNrNew - iSameEnd - 1) * iWords),
+		iWords * sizeof (unsigned short)) == 0)) { iSameEnd++; }
+
+	IndexObjects (iCurLevel, iObject, 0);
+	if (iNrOld == iNrNew)
+	{
+		for (iRecordLoop = iSame + 1; iRecordLoop <= iNrOld - iSameEnd;
+			iRecordLoop++)
+		{
+			for (iWordLoop = 0; iWordLoop < iWords; iWordLoop++)
+			{
+				SetWord (iCurLevel, iObject, iRecordLoop, iWordLoop,
+					arSnap[((iRecordLoop - 1) * iWords) + iWordLoop]);
+			}
+		}
+	} else {
+		for (iRecordLoop = iNrOld - iSameEnd; iRecordLoop > iSame;
+			iRecordLoop--)
+		{
+			JournalRecord (CHANGE_REMOVE, iCurLevel, iObject, iRecordLoop);
+			DeleteRecord (iCurLevel, iObject, iRecordLoop);
+		}
+		for (iRecordLoop = iSame + 1; iRecordLoop <= iNrNew - iSameEnd;
+			iRecordLoop++)
+		{
+			InsertRecord (iCurLevel, iObject, iRecordLoop,
+				arSnap + ((iRecordLoop - 1) * iWords));
+			JournalRecord (CHANGE_INSERT, iCurLevel, iObject, iRecordLoop);
+		}
+	}
+	IndexObjects (iCurLevel, iObject, 1);
+
+	return (1);
+}
+/*****************************************************************************/
+void ReloadSprites (void)
+/*****************************************************************************/
+{
+	/* Recreates the preloaded images and the atlases, after the renderer
+	 * lost its textures. Images that cannot be loaded are not drawn.
+	 */
+
+	/*** Used for looping. ***/
+	int iLoadedLoop;
+	int iAtlasLoop;
+
+	iBatchNr = 0;
+	for (iAtlasLoop = 0; iAtlasLoop < iAtlases; iAtlasLoop++)
+	{
+		if (arAtlases[iAtlasLoop] != NULL)
+			{ SDL_DestroyTexture (arAtlases[iAtlasLoop]); }
+		arAtlases[iAtlasLoop] = NULL;
+	}
+	if (atlas != NULL) { SDL_FreeSurface (atlas); }
+	atlas = NULL;
+	iAtlases = 0;
+	iAtlasX = 0;
+	iAtlasY = 0;
+	iShelfH = 0;
+	memset (arSprites, 0, sizeof (arSprites));
+	iSprites = 0;
+
+	for (iLoadedLoop = 0; iLoadedLoop < iLoadedNr; iLoadedLoop++)
+	{
+		if ((arLoaded[iLoadedLoop].iFirst == iLoadedLoop) &&
+			(arLoaded[iLoadedLoop].img != NULL))
+			{ SDL_DestroyTexture (arLoaded[iLoadedLoop].img); }
+	}
+	for (iLoadedLoop = 0; iLoadedLoop < iLoadedNr; iLoadedLoop++)
+	{
+		if (arLoaded[iLoadedLoop].iFirst == iLoadedLoop)
+		{
+			arLoaded[iLoadedLoop].img =
+				CreateSprite (arLoaded[iLoadedLoop].sImage);
+			if (arLoaded[iLoadedLoop].img == NULL)
+			{
+				printf ("[ WARN ] Could not reload %s: %s!\n",
+					arLoaded[iLoadedLoop].sImage, SDL_GetError());
+			}
+		} else {
+			arLoaded[iLoadedLoop].img =
+				arLoaded[arLoaded[iLoadedLoop].iFirst].img;
+		}
+		*arLoaded[iLoadedLoop].imgHolder = arLoaded[iLoadedLoop].img;
+	}
+	FinishAtlas();
+
+	if (iDebug == 1)
+	{
+		printf ("[ INFO ] Reloaded the images, %i in %i atlases.\n",
+			iSprites, iAtlases);
+	}
+}